@@ -1,49 +1,83 @@
 #ifndef AFINA_THREADPOOL_H
 #define AFINA_THREADPOOL_H
 
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
-#include <functional>
 #include <memory>
 #include <mutex>
-#include <queue>
 #include <string>
 #include <thread>
-#include <chrono>
-#include <cassert>
+#include <type_traits>
 
-using namespace std::chrono_literals;
+#include <afina/concurrency/MpmcQueue.h>
+#include <afina/concurrency/Task.h>
 
 namespace Afina {
 
 /**
  * # Thread pool
+ * Elastic pool of threads running tasks. There are always at least low watermark threads, once every
+ * thread is busy the new task makes one more up to the high watermark, and thread above the low watermark
+ * finishes after it was idle for the idle time.
+ *
+ * Each thread owns a work stealing deque: tasks submitted by the running task go to the deque of the
+ * current thread and are popped in LIFO order without any locking, while idle threads steal the oldest
+ * tasks from the others. Tasks from the outside come through the shared lock free ring bounded by the max
+ * queue size, thread moves a batch of them into its own deque at once. Once the ring is full, overflow
+ * policy decides what happens to the new task, each outcome is counted in stats.
+ *
+ * Tasks are constructed right in the slot of the shared queue or in a task node recycled by the pool
+ * thread, so callable up to task_capacity bytes is submitted and executed without any allocation.
  */
 class Executor {
-    enum class State {
-        // Threadpool is fully operational, tasks could be added and get executed
-        kRun,
+public:
+    // Inline capacity of task, bigger callables are allocated on heap
+    static const std::size_t task_capacity = 64;
 
-        // Threadpool is on the way to be shutdown, no ned task could be added, but existing will be
-        // completed as requested
-        kStopping,
+    using Task = Concurrency::Task<task_capacity>;
 
-        // Threadppol is stopped
-        kStopped
+    // What to do with the task from outside of the pool when the queue is full
+    enum class Overflow {
+        // Execute returns false
+        kReject,
+
+        // Execute waits for a free slot up to the block timeout, then returns false
+        kBlock,
+
+        // Task is executed right in the calling thread
+        kRunInCaller,
+
+        // Oldest task in queue is destroyed without execution to make room for the new one
+        kShedOldest
     };
 
-    Executor(std::string &_name, int _max_queue_size, int _lower = 4, int _higher = 8, int _idle_time = 1000):
-              name(_name),
-              max_queue_size(_max_queue_size),
-              lower_watermark(_lower),
-              higher_watermark(_higher),
-              idle_time(_idle_time),
-              state(State::kRun),
-              idle_threads(0) {}
-
-    ~Executor() {
-        tasks.erase(tasks.begin(), tasks.end());
-        threads.erase(threads.begin(), threads.end());
-    }
+    // Overflow counters
+    struct Stats {
+        // Tasks rejected by kReject policy
+        std::size_t rejected;
+
+        // Submissions that waited for a free slot, and ones of them that gave up on timeout
+        std::size_t blocked;
+        std::size_t timed_out;
+
+        // Tasks executed by submitting thread
+        std::size_t ran_in_caller;
+
+        // Tasks dropped from queue
+        std::size_t shed;
+    };
+
+    Executor(std::string name, std::size_t low_watermark = 4, std::size_t high_watermark = 8,
+             std::size_t max_queue_size = 64, std::chrono::milliseconds idle_time = std::chrono::milliseconds(1000),
+             Overflow overflow = Overflow::kReject,
+             std::chrono::milliseconds block_timeout = std::chrono::milliseconds(100));
+    ~Executor();
+
+    /**
+     * Launches low watermark threads, tasks could be executed after that
+     */
+    void Start();
 
     /**
      * Signal thread pool to stop, it will stop accepting new jobs and close threads just after each become
@@ -52,93 +86,218 @@ class Executor {
      * In case if await flag is true, call won't return until all background jobs are done and all threads are stopped
      */
     void Stop(bool await = false);
-    void Start();
 
     /**
      * Add function to be executed on the threadpool. Method returns true in case if task has been placed
-     * onto execution queue, i.e scheduled for execution and false otherwise.
+     * onto execution queue, i.e scheduled for execution and false otherwise. Queue limit and overflow policy
+     * apply to tasks from outside of the pool only, running task always puts new one into own deque.
      *
      * That function doesn't wait for function result. Function could always be written in a way to notify caller about
      * execution finished by itself
      */
-    template <typename F, typename... Types> bool Execute(F &&func, Types... args) {
-        // Prepare "task"
-        auto exec = std::bind(std::forward<F>(func), std::forward<Types>(args)...);
+    template <typename F, typename... Types> bool Execute(F &&func, Types &&... args) {
+        typedef Concurrency::BoundCall<typename std::decay<F>::type, typename std::decay<Types>::type...> Call;
+        return Emplace<Call>(std::forward<F>(func), std::forward<Types>(args)...);
+    }
 
-        std::unique_lock<std::mutex> lock(mutex);
-        if (state != State::kRun) {
+    /**
+     * Same as above, but task is the callable object of type T constructed from the arguments right in the
+     * queue slot
+     */
+    template <typename T, typename... Args> bool Execute(Args &&... args) {
+        return Emplace<T>(std::forward<Args>(args)...);
+    }
+
+    // Number of threads alive
+    std::size_t threads() const { return _threads.load(std::memory_order_relaxed); }
+
+    // Snapshot of overflow counters
+    Stats stats() const;
+
+private:
+    enum class State {
+        // Threadpool is fully operational, tasks could be added and get executed
+        kRun,
+
+        // Threadpool is on the way to be shutdown, no ned task could be added, but existing will be
+        // completed as requested
+        kStopping,
+
+        // Threadppol is stopped
+        kStopped
+    };
+
+    // Thread slot, see Executor.cpp
+    struct Worker;
+
+    // No copy/move/assign allowed
+    Executor(const Executor &) = delete;
+    Executor(Executor &&) = delete;
+    Executor &operator=(const Executor &) = delete;
+    Executor &operator=(Executor &&) = delete;
+
+    // Constructs task in the node for the deque of the current thread or right in the slot of the shared queue
+    template <typename T, typename... Args> bool Emplace(Args &&... args) {
+        Task *node = Allocate();
+        if (node != nullptr) {
+            try {
+                node->emplace<T>(std::forward<Args>(args)...);
+            } catch (...) {
+                Recycle(node);
+                throw;
+            }
+            return Push(node);
+        }
+
+        // Stop doesn't let threads finish while there is somebody in the middle of submission
+        Submission submission(_submitters);
+        if (_state.load() != State::kRun) {
             return false;
         }
 
-        // Enqueue new task
-        if (idle_threads > 0) { // we have idle threads
-            tasks.push_back(exec);
-            empty_condition.notify_one();
+        auto fill = [&](Task &slot) { slot.emplace<T>(std::forward<Args>(args)...); };
+        if (_queue.push(fill)) {
+            Wake();
+            return true;
         }
-        else { // all threads are working
-            if (threads.size() < higher_watermark) { // creating new thread
-                tasks.push_back(exec);
-                auto id = std::thread::id::id();
-                std::unique_ptr<std::thread> new_thread(&thread_run, this, id);
-                threads.push_back(std::move(new_thread));
-                threads.back()->detach();
+
+        switch (_overflow) {
+        case Overflow::kBlock:
+            if (Block(fill)) {
+                Wake();
                 return true;
             }
-            else {
-                if (tasks.size() < max_queue_size) {
-                    tasks.push_back(exec);
-                    return true;
-                }
-                return false;
+            return false;
+
+        case Overflow::kRunInCaller: {
+            _ran_in_caller.fetch_add(1, std::memory_order_relaxed);
+            Task task(Concurrency::InPlace<T>(), std::forward<Args>(args)...);
+            task();
+            return true;
+        }
+
+        case Overflow::kShedOldest:
+            do {
+                Shed();
+            } while (!_queue.push(fill));
+            Wake();
+            return true;
+
+        default:
+            _rejected.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    }
+
+    // Waits for a free slot in the shared queue up to block timeout
+    template <typename F> bool Block(F &fill) {
+        _blocked.fetch_add(1, std::memory_order_relaxed);
+        auto deadline = std::chrono::steady_clock::now() + _block_timeout;
+
+        // Consumer checks the waiting counter after it frees a slot, see Find
+        std::unique_lock<std::mutex> lock(_full_mutex);
+        _waiting.fetch_add(1);
+        bool pushed = _queue.push(fill);
+        while (!pushed && _state.load() == State::kRun) {
+            if (_full_condition.wait_until(lock, deadline) == std::cv_status::timeout) {
+                pushed = _queue.push(fill);
+                break;
             }
+            pushed = _queue.push(fill);
         }
-        return true;
+        _waiting.fetch_sub(1);
+
+        if (!pushed) {
+            _timed_out.fetch_add(1, std::memory_order_relaxed);
+        }
+        return pushed;
     }
 
-private:
-    std::string name;
-    int max_queue_size;
-    int lower_watermark;
-    int higher_watermark;
-    int idle_time;
+    // Counts thread in the middle of submission
+    struct Submission {
+        Submission(std::atomic<std::size_t> &c) : counter(c) { counter.fetch_add(1); }
+        ~Submission() { counter.fetch_sub(1); }
 
-    void Delete_thread_by_id(Executor *executor, std::thread::id id);
-    void thread_run(Executor* executor, std::thread::id id);
+        std::atomic<std::size_t> &counter;
+    };
 
-    // No copy/move/assign allowed
-    Executor(const Executor &);            // = delete;
-    Executor(Executor &&);                 // = delete;
-    Executor &operator=(const Executor &); // = delete;
-    Executor &operator=(Executor &&);      // = delete;
+    // Node for the task of the current thread, nullptr if thread doesn't belong to the pool
+    Task *Allocate();
+
+    // Returns node of the current thread to its cache
+    void Recycle(Task *node);
+
+    // Places node into the deque of the current thread
+    bool Push(Task *node);
+
+    // Drops the oldest task of the shared queue
+    void Shed();
+
+    // Makes sure some thread is going to pick up the task just added
+    void Wake();
+
+    // Starts thread in a free slot, _mutex must be held
+    void Spawn();
+
+    // Body of each thread
+    void OnRun(Worker *self);
+
+    // Looks for a task in own deque, then in the shared queue and then in deques of others
+    Task *Find(Worker *self);
+
+    // Whether there is any task waiting, only an estimation
+    bool HasWork() const;
+
+    const std::string _name;
+    const std::size_t _low_watermark;
+    const std::size_t _high_watermark;
+    const std::size_t _max_queue_size;
+    const std::chrono::milliseconds _idle_time;
+    const Overflow _overflow;
+    const std::chrono::milliseconds _block_timeout;
+
+    // Slots for high watermark threads
+    std::unique_ptr<Worker[]> _workers;
+
+    // Worker of the current thread if it belongs to some executor
+    static thread_local Worker *_current;
 
     /**
      * Mutex to protect state below from concurrent modification
      */
-    std::mutex mutex;
+    std::mutex _mutex;
 
     /**
      * Conditional variable to await new data in case of empty queue
      */
-    std::condition_variable empty_condition;
+    std::condition_variable _empty_condition;
 
-    std::condition_variable stop_condition;
+    // Signalled once the last thread is finished on stop
+    std::condition_variable _stop_condition;
 
-    /**
-     * Vector of actual threads that perorm execution
-     */
-    std::vector<std::unique_ptr<std::thread>> threads;
+    std::atomic<State> _state;
 
-    /**
-     * Task queue
-     */
-    std::deque<std::function<void()>> tasks;
+    // Threads alive and threads waiting for tasks
+    std::atomic<std::size_t> _threads;
+    std::atomic<std::size_t> _idle;
 
-    /**
-     * Flag to stop bg threads
-     */
-    State state = State::kRun;
+    // Tasks from outside of the pool
+    Concurrency::MpmcQueue<Task> _queue;
+
+    // Threads in the middle of Execute from outside of the pool
+    std::atomic<std::size_t> _submitters;
+
+    // Submitters waiting for a free slot in queue
+    std::mutex _full_mutex;
+    std::condition_variable _full_condition;
+    std::atomic<std::size_t> _waiting;
 
-    int idle_threads;
+    // Overflow counters, see Stats
+    std::atomic<std::size_t> _rejected;
+    std::atomic<std::size_t> _blocked;
+    std::atomic<std::size_t> _timed_out;
+    std::atomic<std::size_t> _ran_in_caller;
+    std::atomic<std::size_t> _shed;
 };
 
 } // namespace Afina
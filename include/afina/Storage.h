@@ -1,7 +1,13 @@
 #ifndef AFINA_STORAGE_H
 #define AFINA_STORAGE_H
 
+#include <cstdint>
+#include <functional>
+#include <memory>
 #include <string>
+#include <vector>
+
+#include <afina/StringView.h>
 
 namespace Afina {
 
@@ -84,6 +90,176 @@ public:
      * @param value output parameter to copy value to
      */
     virtual bool Get(const std::string &key, std::string &value) const = 0;
+
+    /**
+     * Zero copy API: same semantics as methods above, but keys and values are passed as views so callers
+     * holding data in their own buffers don't need to create std::string copies.
+     *
+     * Writes also accept opaque client flags stored along with the value and entry time to live: number
+     * of seconds entry stays visible, 0 means entry never expires and negative value means entry is
+     * expired right away. Expired entries are not visible to any method, PutIfAbsent treats them as
+     * absent and Set as missing.
+     *
+     * Default implementation materializes strings, ignores flags and ttl and forwards to methods above,
+     * implementations are encouraged to override them with allocation free versions
+     */
+    virtual bool Put(StringView key, StringView value, uint32_t flags, int32_t ttl) {
+        return Put(key.str(), value.str());
+    }
+
+    // See Put(StringView, StringView, uint32_t, int32_t)
+    virtual bool PutIfAbsent(StringView key, StringView value, uint32_t flags, int32_t ttl) {
+        return PutIfAbsent(key.str(), value.str());
+    }
+
+    // See Put(StringView, StringView, uint32_t, int32_t)
+    virtual bool Set(StringView key, StringView value, uint32_t flags, int32_t ttl) {
+        return Set(key.str(), value.str());
+    }
+
+    // See Put(StringView, StringView, uint32_t, int32_t)
+    virtual bool Delete(StringView key) { return Delete(key.str()); }
+
+    // See Put(StringView, StringView, uint32_t, int32_t)
+    virtual bool Get(StringView key, std::string &value) const { return Get(key.str(), value); }
+
+    /**
+     * Adds data to the end of the existing value, flags and expiration time of the entry stay the same.
+     * If requested key doesn't present in storage method returns false and doesnt change anything.
+     *
+     * @param key to update value for
+     * @param data to be appended
+     */
+    virtual bool Append(StringView key, StringView data) {
+        std::string value;
+        if (!Get(key.str(), value)) {
+            return false;
+        }
+        return Set(key.str(), value.append(data.data(), data.size()));
+    }
+
+    /**
+     * Callback receiving view of the stored value and its flags. View is valid only during the call,
+     * callback must not call storage back
+     */
+    using Reader = std::function<void(StringView value, uint32_t flags)>;
+
+    /**
+     * Retrive value for the given key without copying it out of the storage: if key is found then reader
+     * gets called with the view of the stored value and method returns true. Otherwise reader is not called
+     * and method returns false
+     *
+     * @param key to retrive value for
+     * @param reader callback to pass value view to
+     */
+    virtual bool Get(StringView key, const Reader &reader) const {
+        std::string value;
+        if (!Get(key.str(), value)) {
+            return false;
+        }
+        reader(value, 0);
+        return true;
+    }
+
+    // Keeps memory of the pinned value alive, see Pin()
+    using Holder = std::shared_ptr<const void>;
+
+    /**
+     * Callback receiving view of the stored value, its flags and holder of the value memory. If holder
+     * isn't empty view stays valid as long as any copy of the holder exists, whatever happens to the entry
+     * meanwhile. Empty holder means value isn't pinned and view is valid only during the call, same as for
+     * Reader. Callback must not call storage back
+     */
+    using PinReader = std::function<void(StringView value, uint32_t flags, Holder holder)>;
+
+    /**
+     * Same as Get(StringView, const Reader &), but storage could keep value memory alive after the call
+     * instead of copying it out. Values shorter than min_size are never pinned as copying them is cheaper.
+     * Default implementation doesn't pin anything
+     *
+     * @param key to retrive value for
+     * @param min_size smallest value worth pinning
+     * @param reader callback to pass value view and holder to
+     */
+    virtual bool Pin(StringView key, std::size_t min_size, const PinReader &reader) const {
+        return Get(key, [&reader](StringView value, uint32_t flags) { reader(value, flags, nullptr); });
+    }
+
+    /**
+     * Callback receiving results of the batched lookup: position of the key in the batch followed by the
+     * same arguments PinReader gets
+     */
+    using BatchReader = std::function<void(std::size_t index, StringView value, uint32_t flags, Holder holder)>;
+
+    /**
+     * Looks up several keys at once, same as calling Pin() for each of them in order, but implementations
+     * take every lock once per batch rather than once per key. Reader is called for found keys only, in the
+     * order of keys. Returns number of keys found.
+     *
+     * Default implementation calls Pin() for every key
+     *
+     * @param keys to retrive values for
+     * @param min_size smallest value worth pinning
+     * @param reader callback to pass results to
+     */
+    virtual std::size_t GetMany(const std::vector<StringView> &keys, std::size_t min_size,
+                                const BatchReader &reader) const {
+        std::size_t found = 0;
+        for (std::size_t i = 0; i < keys.size(); i++) {
+            auto pin = [&reader, i](StringView value, uint32_t flags, Holder holder) {
+                reader(i, value, flags, std::move(holder));
+            };
+            found += Pin(keys[i], min_size, pin) ? 1 : 0;
+        }
+        return found;
+    }
+
+    /**
+     * Write method value received through reservation is stored with, see methods above
+     */
+    enum class WriteMode { Put, PutIfAbsent, Set, Append };
+
+    /**
+     * # Value being received
+     * Storage memory of the known size taken before value bytes are available, so caller could fill it
+     * right where the value is going to live instead of collecting value in its own buffer first. Value
+     * is invisible until Commit(), destroying reservation without commit drops it.
+     *
+     * Reservation must not outlive storage it was taken from.
+     */
+    class Reservation {
+    public:
+        virtual ~Reservation() {}
+
+        // Memory to put value to, exactly size() bytes. Stays in place until reservation is destroyed
+        virtual char *data() = 0;
+
+        // Size of the value reservation was taken for
+        virtual std::size_t size() const = 0;
+
+        // Stores value as write method of the reservation mode would do, returns the same result. Must be
+        // called at most once
+        virtual bool Commit() = 0;
+    };
+
+    /**
+     * Takes memory for the value of the given size, arguments have the same meaning as for write methods
+     * above. Key is copied, so it doesn't have to outlive the call. Condition of the mode (key presence
+     * for PutIfAbsent, Set and Append) is checked on commit only.
+     *
+     * Returns nullptr if storage can't hold value of that size or doesn't support reservations at all,
+     * that is what default implementation does: caller has to collect value itself and use write methods
+     *
+     * @param mode write method to store value with
+     * @param key to store value for
+     * @param size number of value bytes
+     * @param flags opaque client flags, ignored by Append
+     * @param ttl time to live, ignored by Append
+     */
+    virtual std::unique_ptr<Reservation> Reserve(WriteMode mode, StringView key, std::size_t size, uint32_t flags,
+                                                 int32_t ttl) {
+        return nullptr;
+    }
 };
 
 } // namespace Afina
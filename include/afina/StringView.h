@@ -0,0 +1,41 @@
+#ifndef AFINA_STRING_VIEW_H
+#define AFINA_STRING_VIEW_H
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+namespace Afina {
+
+/**
+ * # Non owning reference to the sequence of chars
+ * Pointer + length pair, allows to pass keys and values around without materializing std::string
+ * copies. Referenced memory must outlive the view
+ */
+class StringView {
+public:
+    StringView() : _data(nullptr), _size(0) {}
+    StringView(const char *data, size_t size) : _data(data), _size(size) {}
+    StringView(const std::string &str) : _data(str.data()), _size(str.size()) {}
+
+    inline const char *data() const { return _data; }
+    inline size_t size() const { return _size; }
+    inline bool empty() const { return _size == 0; }
+
+    inline const char &operator[](size_t pos) const { return _data[pos]; }
+
+    inline std::string str() const { return std::string(_data, _size); }
+
+    inline bool operator==(const StringView &other) const {
+        return _size == other._size && (_size == 0 || std::memcmp(_data, other._data, _size) == 0);
+    }
+    inline bool operator!=(const StringView &other) const { return !(*this == other); }
+
+private:
+    const char *_data;
+    size_t _size;
+};
+
+} // namespace Afina
+
+#endif // AFINA_STRING_VIEW_H
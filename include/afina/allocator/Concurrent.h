@@ -0,0 +1,110 @@
+#ifndef AFINA_ALLOCATOR_CONCURRENT_H
+#define AFINA_ALLOCATOR_CONCURRENT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <afina/allocator/Pointer.h>
+#include <afina/allocator/Simple.h>
+
+namespace Afina {
+namespace Allocator {
+
+/**
+ * # Thread safe allocator with per-thread caches
+ * Shared Simple allocator is protected by a lock, but most of the calls never take it: every thread has
+ * a magazine of free blocks per size class. Alloc pops a block from the magazine of the calling thread,
+ * free pushes it back, so both are lock free as long as magazine is neither empty nor full. Empty
+ * magazine is refilled with half of its capacity by a single trip to the shared allocator, full one
+ * gives half of its blocks back the same way.
+ *
+ * Block freed by one thread goes to the magazine of that thread, not of the one allocated it. Blocks
+ * cached in magazines are counted as used by the shared allocator, up to 256KB per size class per
+ * thread. Blocks bigger than that always come from the shared allocator. So area has to be sized with
+ * caches in mind: thread working with many size classes could hold hundreds of kilobytes.
+ *
+ * Cached blocks aren't checked on free, so double free goes unnoticed until block is given back to the
+ * shared allocator.
+ */
+class Concurrent {
+public:
+    Concurrent(void *base, const size_t size);
+
+    /**
+     * Allocates block of at least N bytes
+     *
+     * @param N size_t
+     * @throw AllocError of NoMemory type if magazine is empty and shared allocator is exhausted. Blocks
+     * cached by other threads are not available until defrag()
+     */
+    Pointer alloc(size_t N);
+
+    /**
+     * Same as Simple::realloc, always takes the lock
+     *
+     * @param p Pointer
+     * @param N size_t
+     */
+    void realloc(Pointer &p, size_t N);
+
+    /**
+     * Returns block to the magazine of the calling thread and resets p, does nothing for empty pointer
+     *
+     * @param p Pointer
+     */
+    void free(Pointer &p);
+
+    /**
+     * Gives all cached blocks back to the shared allocator and compacts it. Blocks are moved, so no other
+     * thread could use allocator or any of its blocks meanwhile
+     */
+    void defrag();
+
+    // Shared allocator statistics along with the number of cached blocks
+    std::string dump() const;
+
+    // See Simple::used(), includes cached blocks
+    size_t used() const;
+
+private:
+    // Free blocks of the single size class owned by a thread
+    struct magazine {
+        std::vector<Pointer> blocks;
+        size_t limit;
+    };
+
+    // All magazines of the thread
+    struct cache {
+        std::vector<magazine> magazines;
+    };
+
+    // Cache of the calling thread, created on first use
+    cache &local();
+
+    // Takes up to half of magazine capacity from the shared allocator, at least one block
+    void refill(magazine &m, size_t cls);
+
+    // Gives half of magazine blocks back to the shared allocator
+    void flush(magazine &m);
+
+    // Unique across all instances ever created, so thread local shortcut never matches dead allocator
+    const uint64_t _id;
+
+    mutable std::mutex _lock;
+    Simple _shared;
+
+    // Thread caches, never destroyed before allocator: cache of exited thread is reused by the next
+    // thread getting the same id
+    std::unordered_map<std::thread::id, std::unique_ptr<cache>> _caches;
+};
+
+} // namespace Allocator
+} // namespace Afina
+
+#endif // AFINA_ALLOCATOR_CONCURRENT_H
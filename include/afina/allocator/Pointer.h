@@ -7,6 +7,12 @@ namespace Allocator {
 // to avoid expensive macros calculations and increase compile speed
 class Simple;
 
+/**
+ * # Handle of the block allocated by Simple
+ * Pointer refers to the block descriptor rather than the block itself, so allocator is free to move
+ * block around: get() always returns its current address. Copies of the pointer refer to the same block.
+ * Once block is freed through one of the copies, others become dangling, just like raw pointers do.
+ */
 class Pointer {
 public:
     Pointer();
@@ -17,7 +23,16 @@ public:
     Pointer &operator=(const Pointer &);
     Pointer &operator=(Pointer &&);
 
-    void *get() const { return 0; }
+    // Address of the block payload, nullptr for empty pointer
+    void *get() const { return _desc != nullptr ? *_desc : nullptr; }
+
+private:
+    friend class Simple;
+
+    explicit Pointer(void **desc);
+
+    // Descriptor slot holding current block address
+    void **_desc;
 };
 
 } // namespace Allocator
@@ -1,8 +1,10 @@
 #ifndef AFINA_ALLOCATOR_SIMPLE_H
 #define AFINA_ALLOCATOR_SIMPLE_H
 
-#include <string>
 #include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
 
 namespace Afina {
 namespace Allocator {
@@ -18,6 +20,20 @@ class Pointer;
  * Allocator instance doesn't take ownership of wrapped memmory and do not delete it
  * on destruction. So caller must take care of resource cleaup after allocator stop
  * being needs
+ *
+ * # Size classes
+ * Every request is rounded up to one of the size classes: multiples of 8 up to 1KB, then four classes per
+ * each power of two, so no more than 25% of the block is wasted. Blocks are carved from the area one after
+ * another, each one preceded by 8 bytes header. Freed block goes to the free list of its class and is
+ * reused by the next request of the same class, so both alloc and free are O(1).
+ *
+ * # Descriptors
+ * Pointer doesn't keep block address, it refers to a descriptor slot holding it instead. Descriptor
+ * table lives at the end of the area and grows down towards blocks, block header keeps index of its
+ * descriptor. That allows defrag() to slide live blocks towards the beginning of the area, squeezing out
+ * free ones, and just update their descriptors: pointers owned by the caller stay valid.
+ *
+ * Blocks are 8 bytes aligned. Not thread safe.
  */
 // TODO: Implements interface to allow usage as C++ allocators
 class Simple {
@@ -25,37 +41,101 @@ public:
     Simple(void *base, const size_t size);
 
     /**
-     * TODO: semantics
+     * Allocates block of at least N bytes
+     *
      * @param N size_t
+     * @throw AllocError of NoMemory type if neither free list nor the rest of the area could fit the block
      */
     Pointer alloc(size_t N);
 
     /**
-     * TODO: semantics
+     * Resizes block to at least N bytes preserving its content, the same as alloc for empty pointer. Block
+     * stays in place if it is shrunk or if it is the last one in the area, otherwise it is moved and p is
+     * updated. On failure p is left intact.
+     *
      * @param p Pointer
      * @param N size_t
+     * @throw AllocError of NoMemory type if block can't be extended
      */
     void realloc(Pointer &p, size_t N);
 
     /**
-     * TODO: semantics
+     * Returns block back to allocator and resets p, does nothing for empty pointer
+     *
      * @param p Pointer
+     * @throw AllocError of InvalidFree type if p isn't a live block of this allocator
      */
     void free(Pointer &p);
 
     /**
-     * TODO: semantics
+     * Moves all live blocks to the beginning of the area preserving their order, so all free space forms
+     * a single region available for blocks of any class. Descriptors of freed blocks are given back too
+     * when possible. Takes time linear in the number of blocks, pointers stay valid while addresses change
      */
     void defrag();
 
     /**
-     * TODO: semantics
+     * Human readable statistics: how much of the area is used and how many blocks of every size class
+     * are allocated and free
      */
     std::string dump() const;
 
+    // Number of size classes
+    static size_t size_classes();
+
+    // Size class fitting N bytes, size_classes() if N is too big for any block
+    static size_t size_class(size_t N);
+
+    // Number of bytes blocks of the given class could hold
+    static size_t class_size(size_t cls);
+
+    // Size class of the live block, p isn't validated. Doesn't touch allocator state, so could be called
+    // concurrently by the block owner
+    static size_t size_class(const Pointer &p);
+
+    // Number of bytes available for blocks and descriptors
+    size_t size() const { return size_t(_end - _begin); }
+
+    // Number of bytes taken by live blocks including their headers, size class rounding and descriptors
+    size_t used() const { return _used; }
+
 private:
+    // Allocation statistics and free list of the single size class
+    struct class_state {
+        void *free;
+        uint32_t live;
+        uint32_t idle;
+    };
+
+    // Takes block of the given class from free list or from the top, at least reserve bytes must remain
+    // free between the top and descriptor table. Returns block header
+    void *carve(size_t cls, size_t reserve);
+
+    // Returns block to the free list of its class or to the top
+    void release(void *block);
+
+    // Header of the live block referred by p, throws InvalidFree for anything else
+    void *checked(const Pointer &p) const;
+
     void *_base;
     const size_t _base_len;
+
+    // Area available for blocks and descriptors, aligned
+    char *_begin;
+    char *_end;
+
+    // End of the last block, everything above it was never allocated or was given back
+    char *_top;
+
+    // Lowest descriptor slot, table spans up to the end of the area
+    char *_table;
+
+    // Descriptor slots not used by any block are linked through their content
+    void **_free_desc;
+
+    size_t _used;
+
+    std::vector<class_state> _classes;
 };
 
 } // namespace Allocator
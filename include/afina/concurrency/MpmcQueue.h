@@ -0,0 +1,123 @@
+#ifndef AFINA_CONCURRENCY_MPMC_QUEUE_H
+#define AFINA_CONCURRENCY_MPMC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+namespace Afina {
+namespace Concurrency {
+
+/**
+ * # Bounded multiple producers multiple consumers queue
+ * Lock free ring after Dmitry Vyukov: every cell has a sequence number telling which lap of the ring it
+ * is ready for. Producer claims a cell by moving the tail with compare-and-swap once cell sequence says
+ * the cell is free on the current lap, fills the cell and publishes it by bumping the sequence, consumer
+ * does the same with the head. Producers and consumers never wait for each other unless they race for
+ * the same cell, a slow producer only delays consumer of its own cell.
+ *
+ * Values stay in their cells between uses, so producer constructs value right in place.
+ */
+template <typename T> class MpmcQueue {
+public:
+    MpmcQueue(std::size_t capacity) : _capacity(capacity > 0 ? capacity : 1), _cells(new Cell[_capacity]) {
+        for (std::size_t i = 0; i < _capacity; i++) {
+            _cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        _head.store(0, std::memory_order_relaxed);
+        _tail.store(0, std::memory_order_relaxed);
+    }
+
+    MpmcQueue(const MpmcQueue &) = delete;
+    MpmcQueue &operator=(const MpmcQueue &) = delete;
+
+    /**
+     * Claims a cell at the tail and calls fill(T &) to put value there. Returns false without calling fill
+     * if queue is full. If fill throws, cell is published as it is and exception goes on
+     */
+    template <typename F> bool push(F &&fill) {
+        std::size_t tail = _tail.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell &cell = _cells[tail % _capacity];
+            std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            if (sequence == tail) {
+                if (_tail.compare_exchange_weak(tail, tail + 1, std::memory_order_relaxed)) {
+                    Publish publish(cell, tail + 1);
+                    fill(cell.value);
+                    return true;
+                }
+            } else if (sequence < tail) {
+                // Cell still holds value of the previous lap
+                return false;
+            } else {
+                tail = _tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Moves value from the head out, returns false if queue is empty
+    bool pop(T &value) {
+        std::size_t head = _head.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell &cell = _cells[head % _capacity];
+            std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            if (sequence == head + 1) {
+                if (_head.compare_exchange_weak(head, head + 1, std::memory_order_relaxed)) {
+                    value = std::move(cell.value);
+                    cell.sequence.store(head + _capacity, std::memory_order_release);
+                    return true;
+                }
+            } else if (sequence < head + 1) {
+                // Nothing was published into the cell on this lap yet
+                return false;
+            } else {
+                head = _head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Number of values in queue, only an estimation when called concurrently with other operations
+    std::size_t size() const {
+        std::size_t head = _head.load(std::memory_order_relaxed);
+        std::size_t tail = _tail.load(std::memory_order_relaxed);
+        return tail > head ? tail - head : 0;
+    }
+
+    bool empty() const { return size() == 0; }
+
+    std::size_t capacity() const { return _capacity; }
+
+private:
+    static const std::size_t cache_line = 64;
+
+    struct Cell {
+        std::atomic<std::size_t> sequence;
+        T value;
+    };
+
+    // Makes claimed cell visible to consumers even if filling it throws
+    struct Publish {
+        Publish(Cell &c, std::size_t s) : cell(c), sequence(s) {}
+        ~Publish() { cell.sequence.store(sequence, std::memory_order_release); }
+
+        Cell &cell;
+        std::size_t sequence;
+    };
+
+    const std::size_t _capacity;
+    std::unique_ptr<Cell[]> _cells;
+
+    // Consumers side
+    char _pad0[cache_line];
+    std::atomic<std::size_t> _head;
+
+    // Producers side
+    char _pad1[cache_line];
+    std::atomic<std::size_t> _tail;
+    char _pad2[cache_line];
+};
+
+} // namespace Concurrency
+} // namespace Afina
+
+#endif // AFINA_CONCURRENCY_MPMC_QUEUE_H
@@ -0,0 +1,180 @@
+#ifndef AFINA_CONCURRENCY_TASK_H
+#define AFINA_CONCURRENCY_TASK_H
+
+#include <cstddef>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace Afina {
+namespace Concurrency {
+
+// Tag selecting the type of callable Task constructs in place
+template <typename T> struct InPlace {};
+
+/**
+ * # Function along with its arguments
+ * Keeps decayed copies of the function and arguments just like std::bind does and calls function with
+ * arguments passed as lvalues. Function could be a pointer to member, then the first argument is a pointer
+ * to the object.
+ */
+template <typename F, typename... Args> class BoundCall {
+public:
+    template <typename Fa, typename... Aa>
+    explicit BoundCall(Fa &&func, Aa &&... args) : _func(std::forward<Fa>(func)), _args(std::forward<Aa>(args)...) {}
+
+    void operator()() { Call(typename make_indices<sizeof...(Args)>::type()); }
+
+private:
+    template <std::size_t... I> struct indices {};
+    template <std::size_t N, std::size_t... I> struct make_indices : make_indices<N - 1, N - 1, I...> {};
+    template <std::size_t... I> struct make_indices<0, I...> { typedef indices<I...> type; };
+
+    template <std::size_t... I> void Call(indices<I...>) { Invoke(_func, std::get<I>(_args)...); }
+
+    template <typename Fi, typename... Ai> static auto Invoke(Fi &func, Ai &... args) -> decltype(func(args...)) {
+        return func(args...);
+    }
+
+    template <typename R, typename C, typename... P, typename O, typename... Ai>
+    static R Invoke(R (C::*func)(P...), O &object, Ai &... args) {
+        return ((*object).*func)(args...);
+    }
+
+    template <typename R, typename C, typename... P, typename O, typename... Ai>
+    static R Invoke(R (C::*func)(P...) const, O &object, Ai &... args) {
+        return ((*object).*func)(args...);
+    }
+
+    F _func;
+    std::tuple<Args...> _args;
+};
+
+/**
+ * # Move only callable with small buffer
+ * Replacement for std::function<void()> in the executor queues. Callable that fits into Capacity bytes, is
+ * not overaligned and could be moved without exception lives right inside the task, so task placed into
+ * a queue slot costs no allocation at all. Bigger callables are put on heap.
+ *
+ * Empty task is what queue slots hold between uses, callable could be placed into it by emplace.
+ */
+template <std::size_t Capacity> class Task {
+public:
+    static const std::size_t capacity = Capacity;
+
+    // Whether callable of type T is kept inside task without allocation
+    template <typename T>
+    struct fits : std::integral_constant<bool, sizeof(T) <= Capacity && alignof(T) <= alignof(std::max_align_t) &&
+                                                   std::is_nothrow_move_constructible<T>::value> {};
+
+    Task() : _ops(nullptr) {}
+
+    // Constructs callable of type T from the arguments
+    template <typename T, typename... Args> Task(InPlace<T>, Args &&... args) : _ops(nullptr) {
+        emplace<T>(std::forward<Args>(args)...);
+    }
+
+    Task(Task &&other) noexcept : _ops(other._ops) {
+        if (_ops != nullptr) {
+            _ops->relocate(other._storage, _storage);
+            other._ops = nullptr;
+        }
+    }
+
+    Task &operator=(Task &&other) noexcept {
+        if (this != &other) {
+            reset();
+            if (other._ops != nullptr) {
+                other._ops->relocate(other._storage, _storage);
+                _ops = other._ops;
+                other._ops = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    Task(const Task &) = delete;
+    Task &operator=(const Task &) = delete;
+
+    ~Task() { reset(); }
+
+    // Destroys current callable if any and constructs callable of type T from the arguments
+    template <typename T, typename... Args> void emplace(Args &&... args) {
+        reset();
+        Holder<T, fits<T>::value>::create(_storage, std::forward<Args>(args)...);
+        _ops = &Holder<T, fits<T>::value>::ops;
+    }
+
+    void reset() {
+        if (_ops != nullptr) {
+            _ops->destroy(_storage);
+            _ops = nullptr;
+        }
+    }
+
+    explicit operator bool() const { return _ops != nullptr; }
+
+    void operator()() { _ops->invoke(_storage); }
+
+private:
+    // Operations on the callable stored in the buffer
+    struct Ops {
+        void (*invoke)(void *storage);
+
+        // Move constructs callable at destination and destroys the source one
+        void (*relocate)(void *from, void *to);
+
+        void (*destroy)(void *storage);
+    };
+
+    template <typename T, bool Inline> struct Holder;
+
+    // Callable right in the buffer
+    template <typename T> struct Holder<T, true> {
+        template <typename... Args> static void create(void *storage, Args &&... args) {
+            new (storage) T(std::forward<Args>(args)...);
+        }
+        static void invoke(void *storage) { (*static_cast<T *>(storage))(); }
+        static void relocate(void *from, void *to) {
+            T *source = static_cast<T *>(from);
+            new (to) T(std::move(*source));
+            source->~T();
+        }
+        static void destroy(void *storage) { static_cast<T *>(storage)->~T(); }
+
+        static const Ops ops;
+    };
+
+    // Buffer keeps pointer to the callable on heap
+    template <typename T> struct Holder<T, false> {
+        template <typename... Args> static void create(void *storage, Args &&... args) {
+            *static_cast<T **>(storage) = new T(std::forward<Args>(args)...);
+        }
+        static void invoke(void *storage) { (**static_cast<T **>(storage))(); }
+        static void relocate(void *from, void *to) { *static_cast<T **>(to) = *static_cast<T **>(from); }
+        static void destroy(void *storage) { delete *static_cast<T **>(storage); }
+
+        static const Ops ops;
+    };
+
+    static_assert(Capacity >= sizeof(void *), "Task must fit at least a pointer");
+
+    alignas(std::max_align_t) char _storage[Capacity];
+    const Ops *_ops;
+};
+
+template <std::size_t Capacity> const std::size_t Task<Capacity>::capacity;
+
+template <std::size_t Capacity>
+template <typename T>
+const typename Task<Capacity>::Ops Task<Capacity>::Holder<T, true>::ops = {&invoke, &relocate, &destroy};
+
+template <std::size_t Capacity>
+template <typename T>
+const typename Task<Capacity>::Ops Task<Capacity>::Holder<T, false>::ops = {&invoke, &relocate, &destroy};
+
+} // namespace Concurrency
+} // namespace Afina
+
+#endif // AFINA_CONCURRENCY_TASK_H
@@ -2,10 +2,14 @@
 #define AFINA_COROUTINE_ENGINE_H
 
 #include <cstdint>
+#include <functional>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <setjmp.h>
 #include <tuple>
+#include <utility>
+#include <vector>
 
 namespace Afina {
 namespace Coroutine {
@@ -15,7 +19,83 @@ namespace Coroutine {
  * Allows to run coroutine and schedule its execution. Not threadsafe
  */
 class Engine final {
+public:
+    /**
+     * How routines keep their stacks
+     */
+    enum class StackMode {
+        // Routines share stack of the start caller, every switch copies used part of it to heap and back.
+        // Saved stack takes only as much memory as routine actually used
+        Copying,
+
+        // Every routine runs on its own mapped stack with guard page below, switch just swaps registers.
+        // Supported on x86-64 only, engine falls back to copying elsewhere
+        Separate
+    };
+
+    // Stack size routines get in separate mode by default
+    static const std::size_t default_stack_size = 64 * 1024;
+
+    // Default pool limits, see pool_limits()
+    static const std::size_t default_dirty_stacks = 16;
+    static const std::size_t default_pooled = 1024;
+
+    /**
+     * Pool statistics, counters are accumulated since engine creation
+     */
+    struct PoolStats {
+        // Contexts allocated from heap, taken from the pool, and kept in the pool now
+        std::size_t contexts_allocated = 0;
+        std::size_t contexts_reused = 0;
+        std::size_t contexts_pooled = 0;
+
+        // Stacks mapped, taken from the pool, unmapped as pool was full, and kept in the pool now
+        std::size_t stacks_mapped = 0;
+        std::size_t stacks_reused = 0;
+        std::size_t stacks_unmapped = 0;
+        std::size_t stacks_pooled = 0;
+
+        // Pooled stacks which still hold their pages, and number of times pages were released
+        std::size_t stacks_dirty = 0;
+        std::size_t stacks_released = 0;
+    };
+
 private:
+    // Compile time sequence 0..N-1 to unpack arguments tuple
+    template <std::size_t... I> struct indices {};
+    template <std::size_t N, std::size_t... I> struct make_indices : make_indices<N - 1, N - 1, I...> {};
+    template <std::size_t... I> struct make_indices<0, I...> { typedef indices<I...> type; };
+
+    /**
+     * Routine function along with its arguments, for separate stack mode where routine can't take them
+     * from the stack of its creator
+     */
+    struct body {
+        virtual ~body() {}
+        virtual void call() = 0;
+    };
+
+    // Arguments are kept as function takes them: parameters taken by reference keep referencing
+    // arguments, others are copied or moved into the body
+    template <typename... Ta> struct body_impl : body {
+        template <typename... Args>
+        body_impl(void (*func)(Ta...), Args &&... args) : func(func), args(std::forward<Args>(args)...) {}
+
+        void call() override { call(typename make_indices<sizeof...(Ta)>::type()); }
+
+        template <std::size_t... I> void call(indices<I...>) { func(std::forward<Ta>(std::get<I>(args))...); }
+
+        void (*func)(Ta...);
+        std::tuple<Ta...> args;
+    };
+
+    // Pooled stacks of a single size class: first clean ones, which pages are released, then dirty ones.
+    // Stacks are taken from the back, so the most recently used are reused first
+    struct stack_class {
+        std::vector<char *> stacks;
+        std::size_t clean = 0;
+    };
+
     /**
      * A single coroutine instance which could be scheduled for execution
      * should be allocated on heap
@@ -28,12 +108,22 @@ private:
         // coroutine stack end address
         char *Hight = nullptr;
 
-        // coroutine stack copy buffer
+        // coroutine stack copy buffer and its capacity
         std::tuple<char *, uint32_t> Stack = std::make_tuple(nullptr, 0);
 
         // Saved coroutine context (registers)
         jmp_buf Environment;
 
+        // Separate stack mode: mapping of the stack including guard page, stack pointer saved on switch and
+        // routine to be called once it gets control for the first time
+        char *Mapping = nullptr;
+        std::size_t MappingSize = 0;
+        void *StackPointer = nullptr;
+        std::unique_ptr<body> Body;
+
+        // True if routine is in the "blocked" list rather than "alive" one
+        bool blocked = false;
+
         // To include routine in the different lists, such as "alive", "blocked", e.t.c
         struct context *prev = nullptr;
         struct context *next = nullptr;
@@ -54,11 +144,40 @@ private:
      */
     context* alive;
 
+    /**
+     * List of routines which can't be scheduled until unblocked
+     */
+    context* blocked;
+
     /**
      * Context to be returned finally
      */
     context* idle_ctx;
 
+    /**
+     * Routine finished on its own separate stack, it is destroyed once control leaves that stack
+     */
+    context* finished;
+
+    /**
+     * Called once every routine is blocked
+     */
+    std::function<void()> unblocker;
+
+    // How routines keep their stacks, and size of separate stack
+    StackMode _mode;
+    std::size_t _stack_size;
+
+    // Released contexts linked by next, and released stacks by size class
+    context *_free_contexts;
+    std::map<std::size_t, stack_class> _free_stacks;
+
+    // Pooled dirty stacks per size class, and pooled contexts or stacks per class
+    std::size_t _dirty_limit;
+    std::size_t _pool_limit;
+
+    PoolStats _stats;
+
 protected:
     /**
      * Save stack of the current coroutine in the given context
@@ -73,12 +192,89 @@ protected:
     /**
      * Suspend current coroutine execution and execute given context
      */
-    // void Enter(context& ctx);
+    void Enter(context& ctx);
+
+    /**
+     * Creates routine running given body on its own stack of at least given size, returns nullptr if stack
+     * can't be mapped
+     */
+    context *Create(body *routine, std::size_t stack_size);
+
+    /**
+     * Context from the pool, or a new one if pool is empty
+     */
+    context *Allocate();
+
+    /**
+     * Gives context and its stack back to the pools
+     */
+    void Release(context *ctx);
+
+    /**
+     * Stack of the given size class from the pool, or a newly mapped one. Returns nullptr on failure
+     */
+    char *TakeStack(std::size_t size);
+
+    /**
+     * Puts stack to the pool of its size class
+     */
+    void ReturnStack(char *mapping, std::size_t size);
+
+    /**
+     * First function called on the separate stack: runs current routine body and passes control away for
+     * good once it is done
+     */
+    static void Entry(Engine *engine);
+
+    /**
+     * Body of the idle context: runs routines until all of them are done, then releases engine resources
+     */
+    void Idle();
+
+private:
+    // Removes routine from the list
+    static void Unlink(context *&list, context *ctx);
+
+    // Puts routine in front of the list
+    static void Link(context *&list, context *ctx);
+
+    // Frees context along with its stack copy
+    static void Destroy(context *ctx);
+
+    // Size of the stack mapping including guard page
+    static std::size_t MappingSize(std::size_t size);
 
 public:
-    Engine() : StackBottom(0), cur_routine(nullptr), alive(nullptr) {}
+    /**
+     * @param unblocker function called on the idle context once every routine is blocked. It is expected to
+     * wait for some of them to become ready and unblock those, engine stops if nothing got unblocked
+     * @param mode how routines keep their stacks
+     * @param stack_size size of routine stack in separate mode, rounded up to power of 2 pages
+     */
+    Engine(std::function<void()> unblocker = nullptr, StackMode mode = StackMode::Copying,
+           std::size_t stack_size = default_stack_size);
     Engine(Engine &&) = delete;
     Engine(const Engine &) = delete;
+    ~Engine();
+
+    // Mode engine actually works in
+    StackMode mode() const { return _mode; }
+
+    /**
+     * Sets pool limits. Finished routines give their contexts and stacks to the pools, so the next routines
+     * don't hit allocator or map stacks. Above the limit contexts are freed and stacks unmapped.
+     *
+     * Pooled stack keeps pages routine touched, so the most recently released stacks are reused first.
+     * Once there are more dirty stacks in the size class than allowed, pages of the oldest one are given back
+     * to the kernel with madvise, while the mapping is kept for reuse
+     *
+     * @param dirty_stacks number of pooled stacks in a size class which keep their pages
+     * @param pooled number of pooled contexts and of pooled stacks in a size class
+     */
+    void pool_limits(std::size_t dirty_stacks, std::size_t pooled);
+
+    // Pool statistics
+    const PoolStats &pool_stats() const { return _stats; }
 
     /**
      * Gives up current routine execution and let engine to schedule other one. It is not defined when
@@ -95,54 +291,81 @@ public:
      * when it has been suspended previously.
      *
      * If routine to pass execution to is not specified runtime will try to transfer execution back to caller
-     * of the current routine, if there is no caller then this method has same semantics as yield
+     * of the current routine, if there is no caller then this method has same semantics as yield. Blocked
+     * routine can't get control, so passing it is noop
      */
     void sched(void *routine);
 
+    /**
+     * Removes routine from the alive ones, so it doesn't get control until unblocked. If it is the current
+     * routine, control passes to some other one right away
+     *
+     * @param routine to block, current one if nullptr
+     */
+    void block(void *routine = nullptr);
+
+    /**
+     * Puts blocked routine back to the alive ones, so it could be scheduled again
+     */
+    void unblock(void *routine);
+
     /**
      * Entry point into the engine. Prepare all internal mechanics and starts given function which is
      * considered as main.
      *
      * Once control returns back to caller of start all coroutines are done execution, in other words,
-     * this function doesn't return control until all coroutines are done.
+     * this function doesn't return control until all coroutines are done. Routines left blocked with
+     * nothing to unblock them are never resumed, their stacks are dropped
      *
      * @param pointer to the main coroutine
      * @param arguments to be passed to the main coroutine
      */
-    template <typename... Ta> void start(void (*main)(Ta...), Ta &&... args) {
-        // To acquire stack begin, create variable on stack and remember its address
+    template <typename... Ta, typename... Args>
+    __attribute__((noinline)) void start(void (*main)(Ta...), Args &&... args) {
+        // To acquire stack begin, create variable on stack and remember its address. Function must have its
+        // own frame, otherwise locals of the caller could end up below that address and get overwritten
+        // whenever coroutine stack is restored
         char StackStartsHere;
         this->StackBottom = &StackStartsHere;
 
+        // Caller of start becomes the idle context, it gets control back once some routine finishes or
+        // every routine is blocked
+        idle_ctx = Allocate();
+        cur_routine = idle_ctx;
+
         // Start routine execution
-        void *pc = run(main, std::forward<Ta>(args)...);
-        idle_ctx = new context();
-
-        if (setjmp(idle_ctx->Environment) > 0) {
-            // Here: correct finish of the coroutine section
-            yield();
-        } else if (pc != nullptr) {
-            Store(*idle_ctx);
-            sched(pc);
+        if (run(main, std::forward<Args>(args)...) != nullptr) {
+            Idle();
         }
 
         // Shutdown runtime
-        delete idle_ctx;
+        Release(idle_ctx);
+        idle_ctx = nullptr;
+        cur_routine = nullptr;
         this->StackBottom = 0;
     }
 
     /**
      * Register new coroutine. It won't receive control until scheduled explicitely or implicitly. In case of some
-     * errors function returns -1
+     * errors function returns nullptr
+     *
+     * Arguments are passed as to the regular function call, but in separate stack mode arguments taken by
+     * reference must outlive the routine. In copying mode routine starts on a copy of the creator stack, so
+     * references to the creator locals point to that copy
      */
-    template <typename... Ta> void *run(void (*func)(Ta...), Ta &&... args) {
+    template <typename... Ta, typename... Args> void *run(void (*func)(Ta...), Args &&... args) {
         if (this->StackBottom == 0) {
             // Engine wasn't initialized yet
             return nullptr;
         }
 
+        // Separate stack can't share anything with the creator, so function and arguments go to the heap
+        if (_mode == StackMode::Separate) {
+            return Create(new body_impl<Ta...>(func, std::forward<Args>(args)...), _stack_size);
+        }
+
         // New coroutine context that carries around all information enough to call function
-        context *pc = new context();
+        context *pc = Allocate();
 
         // Store current state right here, i.e just before enter new coroutine, later, once it gets scheduled
         // execution starts here. Note that we have to acquire stack of the current function call to ensure
@@ -152,29 +375,17 @@ public:
             // context pointer, arguments and a pointer to the function comes from restored stack
 
             // invoke routine
-            func(std::forward<Ta>(args)...);
+            func(std::forward<Args>(args)...);
 
             // Routine has completed its execution, time to delete it. Note that we should be extremely careful in where
             // to pass control after that. We never want to go backward by stack as that would mean to go backward in
             // time. Function run() has already return once (when setjmp returns 0), so return second return from run
             // would looks a bit awkward
-            if (pc->prev != nullptr) {
-                pc->prev->next = pc->next;
-            }
-
-            if (pc->next != nullptr) {
-                pc->next->prev = pc->prev;
-            }
-
-            if (alive == cur_routine) {
-                alive = alive->next;
-            }
+            Unlink(alive, pc);
 
             // current coroutine finished, and the pointer is not relevant now
             cur_routine = nullptr;
-            pc->prev = pc->next = nullptr;
-            delete std::get<0>(pc->Stack);
-            delete pc;
+            Release(pc);
 
             // We cannot return here, as this function "returned" once already, so here we must select some other
             // coroutine to run. As current coroutine is completed and can't be scheduled anymore, it is safe to
@@ -188,14 +399,24 @@ public:
         Store(*pc);
 
         // Add routine as alive double-linked list
-        pc->next = alive;
-        alive = pc;
-        if (pc->next != nullptr) {
-            pc->next->prev = pc;
-        }
-
+        Link(alive, pc);
         return pc;
     }
+
+    /**
+     * Same as run, but in separate stack mode routine gets stack of at least the given size. Stacks are
+     * pooled by size classes of power of 2 pages
+     */
+    template <typename... Ta, typename... Args>
+    void *run_with_stack(std::size_t stack_size, void (*func)(Ta...), Args &&... args) {
+        if (_mode == StackMode::Separate) {
+            if (this->StackBottom == 0) {
+                return nullptr;
+            }
+            return Create(new body_impl<Ta...>(func, std::forward<Args>(args)...), stack_size);
+        }
+        return run(func, std::forward<Args>(args)...);
+    }
 };
 
 } // namespace Coroutine
@@ -24,6 +24,9 @@ public:
     ~Add() {}
 
     void Execute(Storage &storage, const std::string &args, std::string &out) override;
+
+protected:
+    Storage::WriteMode mode() const override { return Storage::WriteMode::PutIfAbsent; }
 };
 
 } // namespace Execute
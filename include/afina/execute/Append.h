@@ -25,6 +25,9 @@ public:
     ~Append() {}
 
     void Execute(Storage &storage, const std::string &args, std::string &out) override;
+
+protected:
+    Storage::WriteMode mode() const override { return Storage::WriteMode::Append; }
 };
 
 } // namespace Execute
@@ -1,12 +1,13 @@
 #ifndef AFINA_EXECUTE_COMMAND_H
 #define AFINA_EXECUTE_COMMAND_H
 
+#include <memory>
 #include <string>
 
-namespace Afina {
-
-class Storage;
+#include <afina/Storage.h>
+#include <afina/execute/Response.h>
 
+namespace Afina {
 namespace Execute {
 
 /**
@@ -19,6 +20,25 @@ public:
     virtual ~Command() {}
 
     virtual void Execute(Storage &storage, const std::string &args, std::string &out) = 0;
+
+    /**
+     * Same as above, but result goes to the response which could reference storage memory instead of
+     * copying it. Default implementation appends string result
+     */
+    virtual void Execute(Storage &storage, const std::string &args, Response &out);
+
+    /**
+     * Commands with data block could receive it right into the storage memory instead of getting it
+     * through Execute: returns reservation for size bytes of data or nullptr if command doesn't support
+     * that or storage can't reserve memory, then data has to be passed to Execute as usual
+     */
+    virtual std::unique_ptr<Storage::Reservation> Reserve(Storage &storage, std::size_t size) { return nullptr; }
+
+    /**
+     * Finishes command which data was received into the reservation returned by Reserve, writes result to
+     * the output same as Execute does
+     */
+    virtual void Complete(Storage::Reservation &reservation, std::string &out) {}
 };
 
 } // namespace Execute
@@ -31,18 +31,35 @@ namespace Execute {
  * hold items with such keys (because they were never stored, or stored
  * but deleted to make space for more items, or expired, or explicitly
  * deleted by a client).
+ *
+ * Command "gets" works the same way, but each item line ends with the cas
+ * unique of the value: VALUE <key> <flags> <bytes> <cas unique>. Storage
+ * doesn't version values, so it is always 0 meaning "no cas"
  */
 class Get : public Command {
 public:
-    Get(const std::vector<std::string> &keys) : _keys(keys) {}
+    Get(const std::vector<std::string> &keys, bool cas = false) : _keys(keys), _cas(cas) {}
     ~Get() {}
 
     inline const std::vector<std::string> &keys() const { return _keys; }
 
+    // Whether items carry cas unique, i.e command is "gets"
+    inline bool cas() const { return _cas; }
+
+    using Command::Execute;
+
     void Execute(Storage &storage, const std::string &args, std::string &out) override;
 
+    // Large values are referenced by the response right in the storage memory
+    void Execute(Storage &storage, const std::string &args, Response &out) override;
+
 private:
+    // Values shorter than that are copied into the response, pinning them costs more
+    static const std::size_t min_reference = 1024;
+
     std::vector<std::string> _keys;
+
+    bool _cas;
 };
 
 } // namespace Execute
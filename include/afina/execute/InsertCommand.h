@@ -22,7 +22,23 @@ public:
     inline const uint32_t flags() const { return _flags; }
     inline const int32_t expire() const { return _expire; }
 
+    /**
+     * Converts memcached expiration time into the storage time to live: 0 means never expire, values up to
+     * 30 days are relative number of seconds, larger ones are absolute unix timestamps and negative ones
+     * mean item is expired immediately
+     */
+    int32_t ttl() const;
+
+    // Reserves storage memory for the value, see Command.h
+    std::unique_ptr<Storage::Reservation> Reserve(Storage &storage, std::size_t size) override;
+
+    // Commits reservation, result is "STORED" or "NOT_STORED"
+    void Complete(Storage::Reservation &reservation, std::string &out) override;
+
 protected:
+    // Storage write method the command stores value with
+    virtual Storage::WriteMode mode() const = 0;
+
     const std::string _key;
     const uint32_t _flags;
     const int32_t _expire;
@@ -25,6 +25,9 @@ public:
     ~Replace() {}
 
     void Execute(Storage &storage, const std::string &args, std::string &out) override;
+
+protected:
+    Storage::WriteMode mode() const override { return Storage::WriteMode::Set; }
 };
 
 } // namespace Execute
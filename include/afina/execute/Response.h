@@ -0,0 +1,71 @@
+#ifndef AFINA_EXECUTE_RESPONSE_H
+#define AFINA_EXECUTE_RESPONSE_H
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <sys/uio.h>
+
+#include <afina/Storage.h>
+#include <afina/StringView.h>
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Command response made of segments
+ * Text is copied into the buffer owned by the response, while stored values could be referenced in place
+ * along with holders keeping their memory alive. So response is sent by a single writev without copying
+ * values, and pins are released once response is destroyed.
+ */
+class Response {
+public:
+    Response() : _size(0) {}
+
+    // Appends copy of the text
+    Response &append(StringView text);
+
+    // Appends copy of the text
+    Response &append(const char *text) { return append(StringView(text, std::strlen(text))); }
+
+    // Appends data referenced in place, holder keeps it alive until response is destroyed or cleared
+    Response &reference(StringView data, Storage::Holder holder);
+
+    // Number of bytes in all segments
+    inline std::size_t size() const { return _size; }
+
+    inline bool empty() const { return _size == 0; }
+
+    /**
+     * Fills iovecs with response bytes starting at the given offset, returns number of iovecs filled
+     *
+     * @param offset number of bytes to skip from the response start
+     * @param iov array to fill
+     * @param max number of elements in iov
+     */
+    std::size_t gather(std::size_t offset, struct iovec *iov, std::size_t max) const;
+
+    // Drops all segments and releases holders
+    void clear();
+
+private:
+    // Referenced data or, if data is null, range of the text buffer. Text buffer could be reallocated, so
+    // text segments are kept as offsets
+    struct segment {
+        const char *data;
+        std::size_t offset;
+        std::size_t size;
+    };
+
+    std::string _text;
+    std::vector<segment> _segments;
+    std::vector<Storage::Holder> _holders;
+    std::size_t _size;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_RESPONSE_H
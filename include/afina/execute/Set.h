@@ -25,6 +25,12 @@ public:
     ~Set() {}
 
     void Execute(Storage &storage, const std::string &args, std::string &out) override;
+
+    // Same as Execute, reports success even if value wasn't stored
+    void Complete(Storage::Reservation &reservation, std::string &out) override;
+
+protected:
+    Storage::WriteMode mode() const override { return Storage::WriteMode::Put; }
 };
 
 } // namespace Execute
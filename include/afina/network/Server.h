@@ -1,6 +1,7 @@
 #ifndef AFINA_NETWORK_SERVER_H
 #define AFINA_NETWORK_SERVER_H
 
+#include <cstddef>
 #include <memory>
 #include <vector>
 
@@ -18,7 +19,7 @@ namespace Network {
 class Server {
 public:
     Server(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Afina::Logging::Service> pl)
-        : pStorage(ps), pLogging(pl) {}
+        : pStorage(ps), pLogging(pl), max_pending(1 << 20) {}
     virtual ~Server() {}
 
     /**
@@ -44,6 +45,12 @@ public:
      */
     virtual void Join() = 0;
 
+    /**
+     * Limits bytes of responses connection keeps unsent. Once limit is reached connection stops reading
+     * new commands until client takes some of the responses. Must be called before Start
+     */
+    void SetMaxPending(std::size_t bytes) { max_pending = bytes; }
+
 protected:
     /**
      * Instance of backing storeage on which current server should execute
@@ -55,6 +62,11 @@ protected:
      * Logging service to be used in order to report application progress
      */
     std::shared_ptr<Afina::Logging::Service> pLogging;
+
+    /**
+     * Limit of unsent response bytes per connection, see SetMaxPending
+     */
+    std::size_t max_pending;
 };
 
 } // namespace Network
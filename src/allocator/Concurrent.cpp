@@ -0,0 +1,164 @@
+#include <afina/allocator/Concurrent.h>
+
+#include <algorithm>
+#include <atomic>
+#include <sstream>
+
+#include <afina/allocator/Error.h>
+
+namespace Afina {
+namespace Allocator {
+
+namespace {
+
+// Magazine never holds more than that many blocks or bytes
+const size_t magazine_blocks = 32;
+const size_t magazine_bytes = 256 * 1024;
+
+std::atomic<uint64_t> next_id(1);
+
+// Last cache used by the thread
+struct local_cache {
+    uint64_t owner;
+    void *cache;
+};
+
+thread_local local_cache last = {0, nullptr};
+
+} // namespace
+
+// See Concurrent.h
+Concurrent::Concurrent(void *base, size_t size) : _id(next_id.fetch_add(1)), _shared(base, size) {}
+
+// See Concurrent.h
+Pointer Concurrent::alloc(size_t N) {
+    size_t cls = Simple::size_class(N);
+    magazine *m = cls < Simple::size_classes() ? &local().magazines[cls] : nullptr;
+    if (m == nullptr || m->limit == 0) {
+        std::lock_guard<std::mutex> lock(_lock);
+        return _shared.alloc(N);
+    }
+
+    if (m->blocks.empty()) {
+        refill(*m, cls);
+    }
+
+    Pointer p = m->blocks.back();
+    m->blocks.pop_back();
+    return p;
+}
+
+// See Concurrent.h
+void Concurrent::realloc(Pointer &p, size_t N) {
+    std::lock_guard<std::mutex> lock(_lock);
+    _shared.realloc(p, N);
+}
+
+// See Concurrent.h
+void Concurrent::free(Pointer &p) {
+    if (p.get() == nullptr) {
+        return;
+    }
+
+    // Header of the live block doesn't change until it is freed, no need to lock
+    magazine &m = local().magazines[Simple::size_class(p)];
+    if (m.limit == 0) {
+        std::lock_guard<std::mutex> lock(_lock);
+        _shared.free(p);
+        return;
+    }
+
+    if (m.blocks.size() == m.limit) {
+        flush(m);
+    }
+    m.blocks.push_back(p);
+    p = Pointer();
+}
+
+// See Concurrent.h
+void Concurrent::defrag() {
+    std::lock_guard<std::mutex> lock(_lock);
+    for (auto &it : _caches) {
+        for (magazine &m : it.second->magazines) {
+            for (Pointer &p : m.blocks) {
+                _shared.free(p);
+            }
+            m.blocks.clear();
+        }
+    }
+    _shared.defrag();
+}
+
+// See Concurrent.h
+std::string Concurrent::dump() const {
+    std::lock_guard<std::mutex> lock(_lock);
+
+    // Magazines of other threads change without the lock, so the number is approximate
+    size_t cached = 0;
+    for (auto &it : _caches) {
+        for (const magazine &m : it.second->magazines) {
+            cached += m.blocks.size();
+        }
+    }
+
+    std::stringstream out;
+    out << _shared.dump() << _caches.size() << " thread caches, " << cached << " blocks cached" << std::endl;
+    return out.str();
+}
+
+// See Concurrent.h
+size_t Concurrent::used() const {
+    std::lock_guard<std::mutex> lock(_lock);
+    return _shared.used();
+}
+
+// See Concurrent.h
+Concurrent::cache &Concurrent::local() {
+    if (last.owner == _id) {
+        return *static_cast<cache *>(last.cache);
+    }
+
+    std::lock_guard<std::mutex> lock(_lock);
+    std::unique_ptr<cache> &c = _caches[std::this_thread::get_id()];
+    if (!c) {
+        c.reset(new cache());
+        c->magazines.resize(Simple::size_classes());
+        for (size_t cls = 0; cls < c->magazines.size(); cls++) {
+            size_t limit = std::min(magazine_blocks, magazine_bytes / Simple::class_size(cls));
+            c->magazines[cls].limit = limit < 2 ? 0 : limit;
+        }
+    }
+
+    last.owner = _id;
+    last.cache = c.get();
+    return *c;
+}
+
+// See Concurrent.h
+void Concurrent::refill(magazine &m, size_t cls) {
+    std::lock_guard<std::mutex> lock(_lock);
+    size_t size = Simple::class_size(cls);
+    for (size_t i = 0; i < m.limit / 2; i++) {
+        try {
+            m.blocks.push_back(_shared.alloc(size));
+        } catch (AllocError &) {
+            if (m.blocks.empty()) {
+                throw;
+            }
+            return;
+        }
+    }
+}
+
+// See Concurrent.h
+void Concurrent::flush(magazine &m) {
+    std::lock_guard<std::mutex> lock(_lock);
+    size_t keep = m.blocks.size() - m.blocks.size() / 2;
+    for (size_t i = keep; i < m.blocks.size(); i++) {
+        _shared.free(m.blocks[i]);
+    }
+    m.blocks.resize(keep);
+}
+
+} // namespace Allocator
+} // namespace Afina
@@ -1,40 +1,297 @@
 #include <afina/allocator/Simple.h>
 
+#include <cstring>
+#include <sstream>
+
+#include <afina/allocator/Error.h>
 #include <afina/allocator/Pointer.h>
 
 namespace Afina {
 namespace Allocator {
 
-Simple::Simple(void *base, size_t size) : _base(base), _base_len(size) {}
-
-/**
- * TODO: semantics
- * @param N size_t
- */
-Pointer Simple::alloc(size_t N) { return Pointer(); }
-
-/**
- * TODO: semantics
- * @param p Pointer
- * @param N size_t
- */
-void Simple::realloc(Pointer &p, size_t N) {}
-
-/**
- * TODO: semantics
- * @param p Pointer
- */
-void Simple::free(Pointer &p) {}
-
-/**
- * TODO: semantics
- */
-void Simple::defrag() {}
-
-/**
- * TODO: semantics
- */
-std::string Simple::dump() const { return ""; }
+namespace {
+
+// Precedes every block in the area
+struct block {
+    // Size class of the block
+    uint32_t cls;
+
+    // Index of the descriptor slot, counted from the end of the area
+    uint32_t desc;
+};
+
+// Descriptor index of free blocks
+const uint32_t no_desc = UINT32_MAX;
+
+const size_t align = 8;
+
+// Small classes are multiples of the step, bigger ones split each power of two into 1 << sub_bits classes
+const size_t small_step = 8;
+const size_t small_max = 1024;
+const size_t small_classes = small_max / small_step;
+const unsigned small_bits = 10;
+const unsigned sub_bits = 2;
+
+const size_t max_block = size_t(1) << 31;
+const size_t classes_count = small_classes + ((31 - small_bits) << sub_bits);
+
+// Index of the smallest class fitting n bytes, n must not exceed max_block
+size_t class_of(size_t n) {
+    if (n <= small_max) {
+        return n == 0 ? 0 : (n - 1) / small_step;
+    }
+
+    // 2^b < n <= 2^(b + 1)
+    unsigned b = 63 - __builtin_clzll(uint64_t(n - 1));
+    return small_classes + ((b - small_bits) << sub_bits) + ((n - 1 - (size_t(1) << b)) >> (b - sub_bits));
+}
+
+// Payload size of blocks of the given class
+size_t class_size(size_t cls) {
+    if (cls < small_classes) {
+        return (cls + 1) * small_step;
+    }
+
+    cls -= small_classes;
+    unsigned b = small_bits + unsigned(cls >> sub_bits);
+    return (size_t(1) << b) + ((cls & ((1 << sub_bits) - 1)) + 1) * (size_t(1) << (b - sub_bits));
+}
+
+inline block *header(void *b) { return static_cast<block *>(b); }
+
+inline char *payload(void *b) { return reinterpret_cast<char *>(header(b) + 1); }
+
+inline char *block_end(void *b) { return payload(b) + class_size(header(b)->cls); }
+
+// Free blocks are linked through their payload
+inline void *&next_free(void *b) { return *reinterpret_cast<void **>(payload(b)); }
+
+} // namespace
+
+// See Simple.h
+Simple::Simple(void *base, size_t size)
+    : _base(base), _base_len(size), _free_desc(nullptr), _used(0),
+      _classes(classes_count, class_state{nullptr, 0, 0}) {
+    uintptr_t begin = (reinterpret_cast<uintptr_t>(base) + align - 1) & ~uintptr_t(align - 1);
+    uintptr_t end = (reinterpret_cast<uintptr_t>(base) + size) & ~uintptr_t(align - 1);
+
+    _begin = reinterpret_cast<char *>(begin < end ? begin : end);
+    _end = reinterpret_cast<char *>(end);
+    _top = _begin;
+    _table = _end;
+}
+
+// See Simple.h
+Pointer Simple::alloc(size_t N) {
+    if (N > max_block) {
+        throw AllocError(AllocErrorType::NoMemory, "Block is too big");
+    }
+
+    // New descriptor slot has to fit along with the block
+    void *b = carve(class_of(N), _free_desc == nullptr ? sizeof(void *) : 0);
+
+    void **desc = _free_desc;
+    if (desc != nullptr) {
+        _free_desc = static_cast<void **>(*desc);
+    } else {
+        _table -= sizeof(void *);
+        desc = reinterpret_cast<void **>(_table);
+    }
+
+    *desc = payload(b);
+    _used += sizeof(block) + class_size(header(b)->cls) + sizeof(void *);
+    header(b)->desc = uint32_t(reinterpret_cast<void **>(_end) - desc - 1);
+    return Pointer(desc);
+}
+
+// See Simple.h
+void Simple::realloc(Pointer &p, size_t N) {
+    if (p._desc == nullptr) {
+        p = alloc(N);
+        return;
+    }
+
+    void *b = checked(p);
+    if (N > max_block) {
+        throw AllocError(AllocErrorType::NoMemory, "Block is too big");
+    }
+
+    size_t cls = class_of(N);
+    if (cls == header(b)->cls) {
+        return;
+    }
+
+    // Last block could be resized in any direction just by moving the top
+    char *end = payload(b) + class_size(cls);
+    if (block_end(b) == _top && end <= _table) {
+        _classes[header(b)->cls].live--;
+        _classes[cls].live++;
+        _used = _used - class_size(header(b)->cls) + class_size(cls);
+        header(b)->cls = uint32_t(cls);
+        _top = end;
+        return;
+    }
+
+    if (cls < header(b)->cls) {
+        return;
+    }
+
+    // Block moves, but descriptor stays the same, so all copies of p see the new address
+    void *moved = carve(cls, 0);
+    std::memcpy(payload(moved), payload(b), class_size(header(b)->cls));
+    _used = _used - class_size(header(b)->cls) + class_size(cls);
+    header(moved)->desc = header(b)->desc;
+    *p._desc = payload(moved);
+    release(b);
+}
+
+// See Simple.h
+void Simple::free(Pointer &p) {
+    if (p._desc == nullptr) {
+        return;
+    }
+
+    void *b = checked(p);
+    _used -= sizeof(block) + class_size(header(b)->cls) + sizeof(void *);
+    release(b);
+
+    *p._desc = _free_desc;
+    _free_desc = p._desc;
+    p = Pointer();
+}
+
+// See Simple.h
+void Simple::defrag() {
+    char *to = _begin;
+    for (char *from = _begin; from < _top;) {
+        char *next = block_end(from);
+        if (header(from)->desc != no_desc) {
+            size_t size = size_t(next - from);
+            if (to != from) {
+                std::memmove(to, from, size);
+                reinterpret_cast<void **>(_end)[-1 - ptrdiff_t(header(to)->desc)] = payload(to);
+            }
+            to += size;
+        }
+        from = next;
+    }
+    _top = to;
+
+    for (class_state &sc : _classes) {
+        sc.free = nullptr;
+        sc.idle = 0;
+    }
+
+    // Live slots point below the table, free ones are either null or point to other slots
+    char *table = _table;
+    auto is_free = [table](char *slot) {
+        char *value = *reinterpret_cast<char **>(slot);
+        return value == nullptr || value >= table;
+    };
+
+    while (_table < _end && is_free(_table)) {
+        _table += sizeof(void *);
+    }
+
+    _free_desc = nullptr;
+    for (char *slot = _table; slot < _end; slot += sizeof(void *)) {
+        if (is_free(slot)) {
+            *reinterpret_cast<void **>(slot) = _free_desc;
+            _free_desc = reinterpret_cast<void **>(slot);
+        }
+    }
+}
+
+// See Simple.h
+std::string Simple::dump() const {
+    std::stringstream out;
+    out << "area " << size_t(_end - _begin) << " bytes, " << size_t(_top - _begin) << " used by blocks, "
+        << size_t(_end - _table) << " by descriptors, " << size_t(_table - _top) << " untouched" << std::endl;
+
+    for (size_t cls = 0; cls < _classes.size(); cls++) {
+        const class_state &sc = _classes[cls];
+        if (sc.live != 0 || sc.idle != 0) {
+            out << "class " << class_size(cls) << ": " << sc.live << " live, " << sc.idle << " free" << std::endl;
+        }
+    }
+    return out.str();
+}
+
+// See Simple.h
+size_t Simple::size_classes() { return classes_count; }
+
+// See Simple.h
+size_t Simple::size_class(size_t N) { return N > max_block ? classes_count : class_of(N); }
+
+// See Simple.h
+size_t Simple::class_size(size_t cls) { return Allocator::class_size(cls); }
+
+// See Simple.h
+size_t Simple::size_class(const Pointer &p) { return (static_cast<block *>(p.get()) - 1)->cls; }
+
+// See Simple.h
+void *Simple::carve(size_t cls, size_t reserve) {
+    class_state &sc = _classes[cls];
+
+    // Room for the new descriptor slot is required even if the block itself comes from the free list
+    if (size_t(_table - _top) < reserve) {
+        throw AllocError(AllocErrorType::NoMemory, "Not enough memory");
+    }
+
+    void *b = sc.free;
+    if (b != nullptr) {
+        sc.free = next_free(b);
+        sc.idle--;
+    } else {
+        size_t need = sizeof(block) + class_size(cls) + reserve;
+        if (size_t(_table - _top) < need) {
+            throw AllocError(AllocErrorType::NoMemory, "Not enough memory");
+        }
+
+        b = _top;
+        header(b)->cls = uint32_t(cls);
+        _top = block_end(b);
+    }
+
+    sc.live++;
+    return b;
+}
+
+// See Simple.h
+void Simple::release(void *b) {
+    class_state &sc = _classes[header(b)->cls];
+    sc.live--;
+    header(b)->desc = no_desc;
+
+    if (block_end(b) == _top) {
+        // Last block goes back to the untouched area, so it could be used by any class
+        _top = static_cast<char *>(b);
+    } else {
+        next_free(b) = sc.free;
+        sc.free = b;
+        sc.idle++;
+    }
+}
+
+// See Simple.h
+void *Simple::checked(const Pointer &p) const {
+    char *slot = reinterpret_cast<char *>(p._desc);
+    if (slot < _table || slot >= _end || (reinterpret_cast<uintptr_t>(slot) & (align - 1)) != 0) {
+        throw AllocError(AllocErrorType::InvalidFree, "Pointer doesn't belong to allocator");
+    }
+
+    // Slot of the freed block points to another slot or nowhere, so it fails the range check
+    char *data = static_cast<char *>(*p._desc);
+    if (data < _begin + sizeof(block) || data >= _top) {
+        throw AllocError(AllocErrorType::InvalidFree, "Pointer was freed already");
+    }
+
+    void *b = data - sizeof(block);
+    if (header(b)->desc != uint32_t(reinterpret_cast<void **>(_end) - p._desc - 1)) {
+        throw AllocError(AllocErrorType::InvalidFree, "Pointer was freed already");
+    }
+    return b;
+}
 
 } // namespace Allocator
 } // namespace Afina
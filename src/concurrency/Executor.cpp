@@ -0,0 +1,321 @@
+#include <afina/Executor.h>
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+#include "concurrency/WorkStealingDeque.h"
+
+namespace Afina {
+
+// Thread slot: deque stays in place when thread finishes, so thieves could scan slots without locking
+struct Executor::Worker {
+    Worker() : owner(nullptr), index(0), active(false) {}
+
+    Executor *owner;
+    std::size_t index;
+
+    // Whether slot has a thread running, changes under the executor mutex only
+    std::atomic<bool> active;
+
+    std::thread thread;
+
+    Concurrency::WorkStealingDeque<Executor::Task *> tasks;
+
+    // Empty task nodes, touched by the thread of the slot only
+    std::vector<Executor::Task *> spare;
+};
+
+// See Executor.h
+thread_local Executor::Worker *Executor::_current = nullptr;
+
+namespace {
+
+// Max number of tasks moved from the shared queue into the deque of the thread at once
+const std::size_t max_batch = 32;
+
+// How many times thread gives up CPU looking for a task before it goes to sleep
+const std::size_t spin_rounds = 4;
+
+// Max number of empty task nodes cached by the thread
+const std::size_t max_spare = 256;
+
+} // namespace
+
+const std::size_t Executor::task_capacity;
+
+// See Executor.h
+Executor::Executor(std::string name, std::size_t low_watermark, std::size_t high_watermark,
+                   std::size_t max_queue_size, std::chrono::milliseconds idle_time, Overflow overflow,
+                   std::chrono::milliseconds block_timeout)
+    : _name(std::move(name)), _low_watermark(std::max<std::size_t>(low_watermark, 1)),
+      _high_watermark(std::max(high_watermark, _low_watermark)), _max_queue_size(max_queue_size),
+      _idle_time(idle_time), _overflow(overflow), _block_timeout(block_timeout), _workers(new Worker[_high_watermark]),
+      _state(State::kStopped), _threads(0), _idle(0), _queue(max_queue_size), _submitters(0), _waiting(0),
+      _rejected(0), _blocked(0), _timed_out(0), _ran_in_caller(0), _shed(0) {
+    for (std::size_t i = 0; i < _high_watermark; i++) {
+        _workers[i].owner = this;
+        _workers[i].index = i;
+    }
+}
+
+// See Executor.h
+Executor::~Executor() {
+    Stop(true);
+    for (std::size_t i = 0; i < _high_watermark; i++) {
+        for (Task *node : _workers[i].spare) {
+            delete node;
+        }
+    }
+}
+
+// See Executor.h
+void Executor::Start() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (_state.load() != State::kStopped) {
+        return;
+    }
+
+    _state.store(State::kRun);
+    for (std::size_t i = 0; i < _low_watermark; i++) {
+        Spawn();
+    }
+}
+
+// See Executor.h
+void Executor::Stop(bool await) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (_state.load() == State::kRun) {
+        _state.store(_threads.load() > 0 ? State::kStopping : State::kStopped);
+    }
+    _empty_condition.notify_all();
+    {
+        std::lock_guard<std::mutex> full_lock(_full_mutex);
+        _full_condition.notify_all();
+    }
+
+    if (await) {
+        while (_state.load() != State::kStopped) {
+            _stop_condition.wait(lock);
+        }
+        for (std::size_t i = 0; i < _high_watermark; i++) {
+            if (_workers[i].thread.joinable()) {
+                _workers[i].thread.join();
+            }
+        }
+    }
+}
+
+// See Executor.h
+Executor::Task *Executor::Allocate() {
+    Worker *self = _current;
+    if (self == nullptr || self->owner != this) {
+        return nullptr;
+    }
+    if (self->spare.empty()) {
+        return new Task();
+    }
+
+    Task *node = self->spare.back();
+    self->spare.pop_back();
+    return node;
+}
+
+// See Executor.h
+void Executor::Recycle(Task *node) {
+    node->reset();
+    Worker *self = _current;
+    if (self->spare.size() < max_spare) {
+        self->spare.push_back(node);
+    } else {
+        delete node;
+    }
+}
+
+// See Executor.h
+bool Executor::Push(Task *node) {
+    if (_state.load(std::memory_order_relaxed) != State::kRun) {
+        Recycle(node);
+        return false;
+    }
+
+    // Current thread is going to drain own deque before it finishes, no race with stop here
+    _current->tasks.push(node);
+    Wake();
+    return true;
+}
+
+// See Executor.h
+void Executor::Shed() {
+    Task oldest;
+    if (_queue.pop(oldest)) {
+        _shed.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+// See Executor.h
+Executor::Stats Executor::stats() const {
+    Stats stats;
+    stats.rejected = _rejected.load(std::memory_order_relaxed);
+    stats.blocked = _blocked.load(std::memory_order_relaxed);
+    stats.timed_out = _timed_out.load(std::memory_order_relaxed);
+    stats.ran_in_caller = _ran_in_caller.load(std::memory_order_relaxed);
+    stats.shed = _shed.load(std::memory_order_relaxed);
+    return stats;
+}
+
+// See Executor.h
+void Executor::Wake() {
+    // Pairs with the fence in OnRun: either sleeping thread sees the task or we see it is going to sleep
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (_idle.load(std::memory_order_relaxed) > 0) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _empty_condition.notify_one();
+    } else if (_threads.load(std::memory_order_relaxed) < _high_watermark) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_idle.load() == 0 && _threads.load() < _high_watermark && _state.load() == State::kRun) {
+            Spawn();
+        }
+    }
+}
+
+// See Executor.h
+void Executor::Spawn() {
+    for (std::size_t i = 0; i < _high_watermark; i++) {
+        Worker &worker = _workers[i];
+        if (worker.active.load(std::memory_order_relaxed)) {
+            continue;
+        }
+
+        // Previous thread of the slot is done with executor already, it is just about to exit
+        if (worker.thread.joinable()) {
+            worker.thread.join();
+        }
+        worker.active.store(true);
+        _threads.fetch_add(1);
+        worker.thread = std::thread(&Executor::OnRun, this, &worker);
+        return;
+    }
+}
+
+// See Executor.h
+void Executor::OnRun(Worker *self) {
+    _current = self;
+
+    std::unique_lock<std::mutex> lock(_mutex, std::defer_lock);
+    for (;;) {
+        Task *task = Find(self);
+        for (std::size_t i = 0; task == nullptr && i < spin_rounds; i++) {
+            std::this_thread::yield();
+            task = Find(self);
+        }
+        if (task != nullptr) {
+            // Slot stays empty if task constructor has thrown
+            if (*task) {
+                (*task)();
+            }
+            Recycle(task);
+            continue;
+        }
+
+        // Nothing to do, go to sleep. Recheck queues once idle counter is published to not miss a wakeup,
+        // see Wake
+        lock.lock();
+        _idle.fetch_add(1);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (HasWork()) {
+            _idle.fetch_sub(1);
+            lock.unlock();
+            continue;
+        }
+        if (_state.load() != State::kRun) {
+            _idle.fetch_sub(1);
+            if (_submitters.load() == 0) {
+                break;
+            }
+
+            // Somebody is going to put the task into queue despite stop, wait for it
+            lock.unlock();
+            std::this_thread::yield();
+            continue;
+        }
+
+        bool timeout = _empty_condition.wait_for(lock, _idle_time) == std::cv_status::timeout;
+        _idle.fetch_sub(1);
+        if (timeout && _threads.load() > _low_watermark && _state.load() == State::kRun && !HasWork()) {
+            break;
+        }
+        lock.unlock();
+    }
+
+    // Lock is held here, own deque is empty and nobody else could push to it
+    _current = nullptr;
+    self->active.store(false);
+    if (_threads.fetch_sub(1) == 1 && _state.load() == State::kStopping) {
+        _state.store(State::kStopped);
+        _stop_condition.notify_all();
+    }
+}
+
+// See Executor.h
+Executor::Task *Executor::Find(Worker *self) {
+    Task *task = nullptr;
+    if (self->tasks.pop(task)) {
+        return task;
+    }
+
+    if (!_queue.empty()) {
+        // Take a fair share of the rest so that others could steal it without touching the ring
+        std::size_t batch = 1 + std::min(max_batch, _queue.size() / _threads.load(std::memory_order_relaxed));
+        std::size_t taken = 0;
+        for (; taken < batch; taken++) {
+            Task *node = Allocate();
+            if (!_queue.pop(*node)) {
+                Recycle(node);
+                break;
+            }
+
+            if (task == nullptr) {
+                task = node;
+            } else {
+                self->tasks.push(node);
+            }
+        }
+
+        // Let submitters blocked on full queue know about free slots, pairs with the counter increment in Block
+        if (taken > 0 && _overflow == Overflow::kBlock) {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (_waiting.load(std::memory_order_relaxed) > 0) {
+                std::lock_guard<std::mutex> lock(_full_mutex);
+                _full_condition.notify_all();
+            }
+        }
+        if (task != nullptr) {
+            return task;
+        }
+    }
+
+    // Steal starting from the next slot so that thieves spread over victims
+    for (std::size_t i = 1; i < _high_watermark; i++) {
+        Worker &victim = _workers[(self->index + i) % _high_watermark];
+        if (!victim.tasks.empty() && victim.tasks.steal(task)) {
+            return task;
+        }
+    }
+    return nullptr;
+}
+
+// See Executor.h
+bool Executor::HasWork() const {
+    if (!_queue.empty()) {
+        return true;
+    }
+    for (std::size_t i = 0; i < _high_watermark; i++) {
+        if (!_workers[i].tasks.empty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace Afina
@@ -0,0 +1,147 @@
+#ifndef AFINA_CONCURRENCY_WORK_STEALING_DEQUE_H
+#define AFINA_CONCURRENCY_WORK_STEALING_DEQUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace Afina {
+namespace Concurrency {
+
+/**
+ * # Chase-Lev work stealing deque
+ * Unbounded lock free deque owned by a single thread. Owner pushes and pops at the bottom end as if it
+ * was a stack, so it keeps working on the hottest tasks, while any number of thieves take the oldest
+ * tasks from the top end. Owner races with thieves through compare-and-swap only when the deque has a single
+ * element left, the rest is fences and loads and stores of the ends.
+ *
+ * Implementation follows "Correct and Efficient Work-Stealing for Weak Memory Models" (Le et al, 2013).
+ * Ring grows by doubling once full, replaced rings are kept alive until the deque is destroyed because
+ * a thief might still read from them.
+ *
+ * T is stored in atomics and is read speculatively by thieves, so it should be a pointer or another
+ * trivially copyable type.
+ */
+template <typename T> class WorkStealingDeque {
+public:
+    // Capacity is rounded up to the power of 2
+    WorkStealingDeque(std::size_t capacity = 64) : _top(0), _bottom(0) {
+        std::size_t size = 1;
+        while (size < capacity) {
+            size *= 2;
+        }
+        _rings.emplace_back(new Ring(size));
+        _ring.store(_rings.back().get(), std::memory_order_relaxed);
+    }
+
+    WorkStealingDeque(const WorkStealingDeque &) = delete;
+    WorkStealingDeque &operator=(const WorkStealingDeque &) = delete;
+
+    // Appends value to the bottom end. Owner side
+    void push(T value) {
+        std::int64_t bottom = _bottom.load(std::memory_order_relaxed);
+        std::int64_t top = _top.load(std::memory_order_acquire);
+        Ring *ring = _ring.load(std::memory_order_relaxed);
+        if (bottom - top > std::int64_t(ring->mask)) {
+            ring = Grow(ring, top, bottom);
+        }
+
+        // Release publishes the value to thieves
+        ring->put(bottom, value);
+        _bottom.store(bottom + 1, std::memory_order_release);
+    }
+
+    // Takes the most recently pushed value, returns false if deque is empty. Owner side
+    bool pop(T &value) {
+        std::int64_t bottom = _bottom.load(std::memory_order_relaxed) - 1;
+        Ring *ring = _ring.load(std::memory_order_relaxed);
+        _bottom.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t top = _top.load(std::memory_order_relaxed);
+
+        if (top > bottom) {
+            // Empty
+            _bottom.store(bottom + 1, std::memory_order_relaxed);
+            return false;
+        }
+
+        value = ring->get(bottom);
+        if (top == bottom) {
+            // Last element, race with thieves for it
+            bool won = _top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+            _bottom.store(bottom + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    // Takes the oldest value, returns false if deque is empty or another thread took the value first.
+    // Could be called by any thread
+    bool steal(T &value) {
+        std::int64_t top = _top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t bottom = _bottom.load(std::memory_order_acquire);
+        if (top >= bottom) {
+            return false;
+        }
+
+        Ring *ring = _ring.load(std::memory_order_acquire);
+        value = ring->get(top);
+        return _top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+    }
+
+    // Number of values in deque, only an estimation when called concurrently with other operations
+    std::size_t size() const {
+        std::int64_t bottom = _bottom.load(std::memory_order_relaxed);
+        std::int64_t top = _top.load(std::memory_order_relaxed);
+        return bottom > top ? std::size_t(bottom - top) : 0;
+    }
+
+    bool empty() const { return size() == 0; }
+
+    std::size_t capacity() const { return _ring.load(std::memory_order_relaxed)->mask + 1; }
+
+private:
+    static const std::size_t cache_line = 64;
+
+    // Power of 2 ring indexed by ever growing positions
+    struct Ring {
+        Ring(std::size_t size) : mask(size - 1), items(new std::atomic<T>[size]) {}
+
+        T get(std::int64_t i) const { return items[i & mask].load(std::memory_order_relaxed); }
+        void put(std::int64_t i, T value) { items[i & mask].store(value, std::memory_order_relaxed); }
+
+        std::size_t mask;
+        std::unique_ptr<std::atomic<T>[]> items;
+    };
+
+    // Replaces full ring by the one twice as big, owner side
+    Ring *Grow(Ring *ring, std::int64_t top, std::int64_t bottom) {
+        Ring *grown = new Ring(2 * (ring->mask + 1));
+        for (std::int64_t i = top; i < bottom; i++) {
+            grown->put(i, ring->get(i));
+        }
+        _rings.emplace_back(grown);
+        _ring.store(grown, std::memory_order_release);
+        return grown;
+    }
+
+    // Thieves side
+    std::atomic<std::int64_t> _top;
+    char _pad0[cache_line];
+
+    // Owner side
+    std::atomic<std::int64_t> _bottom;
+    std::atomic<Ring *> _ring;
+
+    // Every ring ever used, the last one is current
+    std::vector<std::unique_ptr<Ring>> _rings;
+    char _pad1[cache_line];
+};
+
+} // namespace Concurrency
+} // namespace Afina
+
+#endif // AFINA_CONCURRENCY_WORK_STEALING_DEQUE_H
@@ -3,11 +3,114 @@
 #include <setjmp.h>
 #include <stdio.h>
 #include <string.h>
+#include <cstdlib>
 #include <cstring>
 
+#include <sys/mman.h>
+#include <unistd.h>
+
+#if defined(__x86_64__)
+extern "C" {
+// Pushes callee saved registers and floating point control words to the current stack, stores stack pointer
+// to *from, then switches to the stack pointer to and pops everything back from there
+void afina_coroutine_switch(void **from, void *to);
+
+// Return address of the fresh stack: calls function from r13 passing r12 as its argument
+void afina_coroutine_start();
+}
+
+asm(".pushsection .text\n"
+    ".p2align 4\n"
+    ".type afina_coroutine_switch,@function\n"
+    "afina_coroutine_switch:\n"
+    "    pushq %rbp\n"
+    "    pushq %rbx\n"
+    "    pushq %r12\n"
+    "    pushq %r13\n"
+    "    pushq %r14\n"
+    "    pushq %r15\n"
+    "    subq $8, %rsp\n"
+    "    stmxcsr (%rsp)\n"
+    "    fnstcw 4(%rsp)\n"
+    "    movq %rsp, (%rdi)\n"
+    "    movq %rsi, %rsp\n"
+    "    ldmxcsr (%rsp)\n"
+    "    fldcw 4(%rsp)\n"
+    "    addq $8, %rsp\n"
+    "    popq %r15\n"
+    "    popq %r14\n"
+    "    popq %r13\n"
+    "    popq %r12\n"
+    "    popq %rbx\n"
+    "    popq %rbp\n"
+    "    ret\n"
+    ".size afina_coroutine_switch, .-afina_coroutine_switch\n"
+    ".p2align 4\n"
+    ".type afina_coroutine_start,@function\n"
+    "afina_coroutine_start:\n"
+    "    movq %r12, %rdi\n"
+    "    callq *%r13\n"
+    "    ud2\n"
+    ".size afina_coroutine_start, .-afina_coroutine_start\n"
+    ".popsection\n");
+#endif
+
 namespace Afina {
 namespace Coroutine {
 
+namespace {
+
+// Gap between the frame restoring stack and the restored region, covers frame parts above its locals
+const std::size_t restore_margin = 256;
+
+#if defined(__x86_64__)
+const bool separate_supported = true;
+#else
+const bool separate_supported = false;
+
+// Separate stack mode is never enabled on other architectures
+void afina_coroutine_switch(void **, void *) { std::abort(); }
+void afina_coroutine_start() { std::abort(); }
+#endif
+
+// Initial values of floating point control words as ABI defines them
+const uint32_t default_mxcsr = 0x1F80;
+const uint32_t default_fpucw = 0x037F;
+
+} // namespace
+
+const std::size_t Engine::default_stack_size;
+const std::size_t Engine::default_dirty_stacks;
+const std::size_t Engine::default_pooled;
+
+Engine::Engine(std::function<void()> unblocker, StackMode mode, std::size_t stack_size)
+    : StackBottom(0), cur_routine(nullptr), alive(nullptr), blocked(nullptr), idle_ctx(nullptr),
+      finished(nullptr), unblocker(unblocker), _mode(mode), _stack_size(stack_size), _free_contexts(nullptr),
+      _dirty_limit(default_dirty_stacks), _pool_limit(default_pooled) {
+    if (_mode == StackMode::Separate && !separate_supported) {
+        _mode = StackMode::Copying;
+    }
+}
+
+Engine::~Engine() {
+    while (_free_contexts != nullptr) {
+        context *ctx = _free_contexts;
+        _free_contexts = ctx->next;
+        Destroy(ctx);
+    }
+
+    for (auto &size_class : _free_stacks) {
+        for (char *mapping : size_class.second.stacks) {
+            munmap(mapping, MappingSize(size_class.first));
+        }
+    }
+}
+
+void Engine::pool_limits(std::size_t dirty_stacks, std::size_t pooled) {
+    _dirty_limit = dirty_stacks;
+    _pool_limit = pooled;
+}
+
 void Engine::Store(context &ctx) {
     char Higher;
     ctx.Hight = &Higher;
@@ -17,39 +120,289 @@ void Engine::Store(context &ctx) {
         ctx.Hight = ctx.Low;
         ctx.Low = tmp;
     }
+
+    // Copy buffer is reused unless stack got deeper since the last switch
     std::size_t length = ctx.Hight - ctx.Low;
-    char* stack = new char[length];
-    std::memcpy(stack, ctx.Low, length);
-    delete[] std::get<0>(ctx.Stack);
-    ctx.Stack = std::make_tuple(stack, length);
+    if (std::get<1>(ctx.Stack) < length) {
+        delete[] std::get<0>(ctx.Stack);
+        ctx.Stack = std::make_tuple(new char[length], uint32_t(length));
+    }
+    std::memcpy(std::get<0>(ctx.Stack), ctx.Low, length);
 }
 
 void Engine::Restore(context &ctx) {
+    // Stack grows down, so go deeper until this frame lays below the region to be overwritten
     char now;
-    while ((ctx.Low < &now) && (&now < ctx.Hight)) {
+    if (&now + restore_margin > ctx.Low) {
         Restore(ctx);
     }
-    std::memcpy(ctx.Low, std::get<0>(ctx.Stack), std::get<1>(ctx.Stack));
+    std::memcpy(ctx.Low, std::get<0>(ctx.Stack), ctx.Hight - ctx.Low);
     cur_routine = &ctx;
     longjmp(ctx.Environment, 1);
 }
 
+void Engine::Enter(context &ctx) {
+    if (_mode == StackMode::Separate) {
+        context *from = cur_routine;
+        cur_routine = &ctx;
+        afina_coroutine_switch(&from->StackPointer, ctx.StackPointer);
+        return;
+    }
+
+    if (setjmp(cur_routine->Environment) == 0) {
+        Store(*cur_routine);
+        Restore(ctx);
+    }
+}
+
+Engine::context *Engine::Create(body *routine, std::size_t stack_size) {
+    std::unique_ptr<body> routine_body(routine);
+
+    // Size class is power of 2 pages
+    std::size_t size = sysconf(_SC_PAGESIZE);
+    while (size < stack_size) {
+        size *= 2;
+    }
+
+    char *mapping = TakeStack(size);
+    if (mapping == nullptr) {
+        return nullptr;
+    }
+
+    context *pc = Allocate();
+    pc->Mapping = mapping;
+    pc->MappingSize = MappingSize(size);
+    pc->Body = std::move(routine_body);
+
+    // Fresh stack looks like the one suspended by switch: saved registers and control words below the return
+    // address of the start code, which calls Entry(this). Stack top is page aligned, so after return
+    // stack is aligned just as call instruction expects
+    void **sp = reinterpret_cast<void **>(pc->Mapping + pc->MappingSize);
+    *--sp = reinterpret_cast<void *>(&afina_coroutine_start);
+    *--sp = nullptr;                                  // rbp
+    *--sp = nullptr;                                  // rbx
+    *--sp = this;                                     // r12
+    *--sp = reinterpret_cast<void *>(&Engine::Entry); // r13
+    *--sp = nullptr;                                  // r14
+    *--sp = nullptr;                                  // r15
+    --sp;
+    reinterpret_cast<uint32_t *>(sp)[0] = default_mxcsr;
+    reinterpret_cast<uint32_t *>(sp)[1] = default_fpucw;
+    pc->StackPointer = sp;
+
+    Link(alive, pc);
+    return pc;
+}
+
+void Engine::Entry(Engine *engine) {
+    context *ctx = engine->cur_routine;
+    ctx->Body->call();
+
+    // Routine can't release the stack it is running on, so idle context does that once it gets control
+    Unlink(engine->alive, ctx);
+    engine->finished = ctx;
+    engine->cur_routine = engine->idle_ctx;
+    afina_coroutine_switch(&ctx->StackPointer, engine->idle_ctx->StackPointer);
+}
+
+Engine::context *Engine::Allocate() {
+    if (_free_contexts == nullptr) {
+        _stats.contexts_allocated++;
+        return new context();
+    }
+
+    context *ctx = _free_contexts;
+    _free_contexts = ctx->next;
+    ctx->next = nullptr;
+    _stats.contexts_reused++;
+    _stats.contexts_pooled--;
+    return ctx;
+}
+
+void Engine::Release(context *ctx) {
+    if (ctx->Mapping != nullptr) {
+        ReturnStack(ctx->Mapping, ctx->MappingSize - sysconf(_SC_PAGESIZE));
+        ctx->Mapping = nullptr;
+        ctx->MappingSize = 0;
+    }
+
+    if (_stats.contexts_pooled >= _pool_limit) {
+        Destroy(ctx);
+        return;
+    }
+
+    // Stack copy buffer stays with the context, so routine reusing it doesn't allocate it again
+    ctx->Body.reset();
+    ctx->StackPointer = nullptr;
+    ctx->blocked = false;
+    ctx->prev = nullptr;
+    ctx->next = _free_contexts;
+    _free_contexts = ctx;
+    _stats.contexts_pooled++;
+}
+
+char *Engine::TakeStack(std::size_t size) {
+    stack_class &pool = _free_stacks[size];
+    if (!pool.stacks.empty()) {
+        char *mapping = pool.stacks.back();
+        pool.stacks.pop_back();
+        if (pool.clean > pool.stacks.size()) {
+            pool.clean--;
+        } else {
+            _stats.stacks_dirty--;
+        }
+        _stats.stacks_pooled--;
+        _stats.stacks_reused++;
+        return mapping;
+    }
+
+    // Stack overflow hits the guard page rather than memory below the stack
+    std::size_t mapping_size = MappingSize(size);
+    void *mapping =
+        mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+    if (mapping == MAP_FAILED) {
+        return nullptr;
+    }
+    if (mprotect(mapping, mapping_size - size, PROT_NONE) == -1) {
+        munmap(mapping, mapping_size);
+        return nullptr;
+    }
+    _stats.stacks_mapped++;
+    return static_cast<char *>(mapping);
+}
+
+void Engine::ReturnStack(char *mapping, std::size_t size) {
+    stack_class &pool = _free_stacks[size];
+    if (pool.stacks.size() >= _pool_limit) {
+        munmap(mapping, MappingSize(size));
+        _stats.stacks_unmapped++;
+        return;
+    }
+
+    pool.stacks.push_back(mapping);
+    _stats.stacks_pooled++;
+    _stats.stacks_dirty++;
+
+    // Oldest dirty stack gives its pages back, mapping stays in place and reads as zeroes once touched again
+    if (pool.stacks.size() - pool.clean > _dirty_limit) {
+        std::size_t guard = MappingSize(size) - size;
+        madvise(pool.stacks[pool.clean] + guard, size, MADV_DONTNEED);
+        pool.clean++;
+        _stats.stacks_dirty--;
+        _stats.stacks_released++;
+    }
+}
+
+void Engine::Idle() {
+    // Every time routine finishes or blocks leaving nothing to run control comes back here
+    while (true) {
+        if (alive == nullptr && blocked != nullptr && unblocker) {
+            unblocker();
+        }
+        if (alive == nullptr) {
+            break;
+        }
+        Enter(*alive);
+
+        if (finished != nullptr) {
+            Release(finished);
+            finished = nullptr;
+        }
+    }
+
+    // Nothing could resume blocked routines anymore
+    while (blocked != nullptr) {
+        context *ctx = blocked;
+        Unlink(blocked, ctx);
+        Release(ctx);
+    }
+}
+
+void Engine::Unlink(context *&list, context *ctx) {
+    if (ctx->prev != nullptr) {
+        ctx->prev->next = ctx->next;
+    }
+    if (ctx->next != nullptr) {
+        ctx->next->prev = ctx->prev;
+    }
+    if (list == ctx) {
+        list = ctx->next;
+    }
+    ctx->prev = ctx->next = nullptr;
+}
+
+void Engine::Link(context *&list, context *ctx) {
+    ctx->prev = nullptr;
+    ctx->next = list;
+    if (list != nullptr) {
+        list->prev = ctx;
+    }
+    list = ctx;
+}
+
+void Engine::Destroy(context *ctx) {
+    delete[] std::get<0>(ctx->Stack);
+    delete ctx;
+}
+
+std::size_t Engine::MappingSize(std::size_t size) { return size + sysconf(_SC_PAGESIZE); }
+
 void Engine::yield() {
-    auto routine = alive;
-    if (routine == cur_routine) {
-        routine = alive->next;
+    if (cur_routine == nullptr) {
+        return;
+    }
+
+    // Round robin over alive routines, idle context isn't one of them
+    context *routine = cur_routine == idle_ctx ? nullptr : cur_routine->next;
+    if (routine == nullptr) {
+        routine = alive;
     }
-    if (routine != nullptr) {
-        sched(static_cast<void*>(routine));
+    if (routine != nullptr && routine != cur_routine) {
+        Enter(*routine);
     }
 }
 
 void Engine::sched(void *routine_) {
-    if (setjmp(cur_routine->Environment) == 0) {
-        Store(*cur_routine);
-        context* ctx = static_cast<context*>(routine_);
-        Restore(*ctx);
+    if (routine_ == nullptr) {
+        yield();
+        return;
     }
+
+    context *ctx = static_cast<context *>(routine_);
+    if (cur_routine == nullptr || ctx == cur_routine || ctx->blocked) {
+        return;
+    }
+    Enter(*ctx);
+}
+
+void Engine::block(void *routine_) {
+    context *ctx = routine_ == nullptr ? cur_routine : static_cast<context *>(routine_);
+    if (ctx == nullptr || ctx == idle_ctx || ctx->blocked) {
+        return;
+    }
+
+    context *next = ctx->next != nullptr ? ctx->next : alive;
+    Unlink(alive, ctx);
+    Link(blocked, ctx);
+    ctx->blocked = true;
+
+    if (ctx == cur_routine) {
+        if (next == ctx) {
+            next = alive;
+        }
+        Enter(next != nullptr ? *next : *idle_ctx);
+    }
+}
+
+void Engine::unblock(void *routine_) {
+    context *ctx = static_cast<context *>(routine_);
+    if (ctx == nullptr || !ctx->blocked) {
+        return;
+    }
+
+    Unlink(blocked, ctx);
+    Link(alive, ctx);
+    ctx->blocked = false;
 }
 
 } // namespace Coroutine
@@ -9,13 +9,8 @@ namespace Execute {
 // memcached protocol: "append" means "add this data to an existing key after existing data".
 void Append::Execute(Storage &storage, const std::string &args, std::string &out) {
     std::cout << "Append(" << _key << ")" << args << std::endl;
-    std::string value;
-    if (!storage.Get(_key, value)) {
-        out.assign("NOT_STORED");
-        return;
-    }
-    storage.Put(_key, value + args);
-    out.assign("STORED");
+    // Flags and expiration time given to the command are ignored, entry keeps its own
+    out.assign(storage.Append(StringView(_key), StringView(args)) ? "STORED" : "NOT_STORED");
 }
 
 } // namespace Execute
@@ -1 +1,14 @@
 #include <afina/execute/Command.h>
+
+namespace Afina {
+namespace Execute {
+
+// See Command.h
+void Command::Execute(Storage &storage, const std::string &args, Response &out) {
+    std::string result;
+    Execute(storage, args, result);
+    out.append(result);
+}
+
+} // namespace Execute
+} // namespace Afina
@@ -3,11 +3,14 @@
 
 #include <iostream>
 #include <iterator>
+#include <limits>
 #include <sstream>
 
 namespace Afina {
 namespace Execute {
 
+const std::size_t Get::min_reference;
+
 /* memcached protocol:
 
 Each item sent by the server looks like this:
@@ -26,18 +29,36 @@ void Get::Execute(Storage &storage, const std::string &args, std::string &out) {
     copy(_keys.begin(), _keys.end(), std::ostream_iterator<std::string>(keyStream, " "));
     std::cout << "Get(" << keyStream.str() << ")" << std::endl;
 
-    std::stringstream outStream;
-
-    std::string value;
-    for (auto &key : _keys) {
-        if (!storage.Get(key, value))
-            continue;
-        outStream << "VALUE " << key << " 0 " << value.size() << "\r\n";
-        outStream << value << "\r\n";
-    }
-    outStream << "END"; // networking layer should add the last \r\n
+    // Values are appended straight from the storage, without intermediate copies. All keys are looked up
+    // in a single batch, so storage locks are taken once per request
+    out.clear();
+    std::vector<StringView> keys(_keys.begin(), _keys.end());
+    bool cas = _cas;
+    auto writer = [&out, &keys, cas](std::size_t i, StringView value, uint32_t flags, Storage::Holder holder) {
+        out.append("VALUE ").append(keys[i].data(), keys[i].size()).append(" ").append(std::to_string(flags));
+        out.append(" ").append(std::to_string(value.size())).append(cas ? " 0\r\n" : "\r\n");
+        out.append(value.data(), value.size()).append("\r\n");
+    };
+    storage.GetMany(keys, std::numeric_limits<std::size_t>::max(), writer);
+    out.append("END"); // networking layer should add the last \r\n
+}
 
-    out = outStream.str();
+// See Get.h
+void Get::Execute(Storage &storage, const std::string &args, Response &out) {
+    std::vector<StringView> keys(_keys.begin(), _keys.end());
+    bool cas = _cas;
+    auto writer = [&out, &keys, cas](std::size_t i, StringView value, uint32_t flags, Storage::Holder holder) {
+        out.append("VALUE ").append(keys[i]).append(" ").append(std::to_string(flags)).append(" ");
+        out.append(std::to_string(value.size())).append(cas ? " 0\r\n" : "\r\n");
+        if (holder) {
+            out.reference(value, std::move(holder));
+        } else {
+            out.append(value);
+        }
+        out.append("\r\n");
+    };
+    storage.GetMany(keys, min_reference, writer);
+    out.append("END"); // networking layer should add the last \r\n
 }
 
 } // namespace Execute
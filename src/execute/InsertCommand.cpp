@@ -0,0 +1,36 @@
+#include <afina/execute/InsertCommand.h>
+
+#include <ctime>
+
+namespace Afina {
+namespace Execute {
+
+namespace {
+
+// Expiration times larger than that are treated as unix timestamps, same as memcached does
+const int32_t max_relative_expire = 60 * 60 * 24 * 30;
+
+} // namespace
+
+// See InsertCommand.h
+int32_t InsertCommand::ttl() const {
+    if (_expire <= max_relative_expire) {
+        return _expire < 0 ? -1 : _expire;
+    }
+
+    int64_t left = int64_t(_expire) - int64_t(std::time(nullptr));
+    return left > 0 ? int32_t(left) : -1;
+}
+
+// See InsertCommand.h
+std::unique_ptr<Storage::Reservation> InsertCommand::Reserve(Storage &storage, std::size_t size) {
+    return storage.Reserve(mode(), StringView(_key), size, _flags, ttl());
+}
+
+// See InsertCommand.h
+void InsertCommand::Complete(Storage::Reservation &reservation, std::string &out) {
+    out.assign(reservation.Commit() ? "STORED" : "NOT_STORED");
+}
+
+} // namespace Execute
+} // namespace Afina
@@ -0,0 +1,64 @@
+#include <afina/execute/Response.h>
+
+namespace Afina {
+namespace Execute {
+
+// See Response.h
+Response &Response::append(StringView text) {
+    if (text.empty()) {
+        return *this;
+    }
+
+    // Text following text extends the same segment
+    if (_segments.empty() || _segments.back().data != nullptr) {
+        _segments.push_back({nullptr, _text.size(), 0});
+    }
+    _text.append(text.data(), text.size());
+    _segments.back().size += text.size();
+    _size += text.size();
+    return *this;
+}
+
+// See Response.h
+Response &Response::reference(StringView data, Storage::Holder holder) {
+    if (data.empty()) {
+        return *this;
+    }
+
+    _segments.push_back({data.data(), 0, data.size()});
+    _holders.push_back(std::move(holder));
+    _size += data.size();
+    return *this;
+}
+
+// See Response.h
+std::size_t Response::gather(std::size_t offset, struct iovec *iov, std::size_t max) const {
+    std::size_t count = 0;
+    for (const segment &s : _segments) {
+        if (count == max) {
+            break;
+        }
+        if (offset >= s.size) {
+            offset -= s.size;
+            continue;
+        }
+
+        const char *data = s.data != nullptr ? s.data : _text.data() + s.offset;
+        iov[count].iov_base = const_cast<char *>(data + offset);
+        iov[count].iov_len = s.size - offset;
+        offset = 0;
+        count++;
+    }
+    return count;
+}
+
+// See Response.h
+void Response::clear() {
+    _text.clear();
+    _segments.clear();
+    _holders.clear();
+    _size = 0;
+}
+
+} // namespace Execute
+} // namespace Afina
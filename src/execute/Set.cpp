@@ -9,7 +9,13 @@ namespace Execute {
 // memcached protocol: "set" means "store this data".
 void Set::Execute(Storage &storage, const std::string &args, std::string &out) {
     std::cout << "Set(" << _key << "): " << args << std::endl;
-    storage.Put(_key, args);
+    storage.Put(StringView(_key), StringView(args), _flags, ttl());
+    out = "STORED";
+}
+
+// See Set.h
+void Set::Complete(Storage::Reservation &reservation, std::string &out) {
+    reservation.Commit();
     out = "STORED";
 }
 
@@ -17,9 +17,15 @@
 #include "logging/ServiceImpl.h"
 #include "network/mt_blocking/ServerImpl.h"
 #include "network/mt_nonblocking/ServerImpl.h"
+#include "network/mt_reuseport/ServerImpl.h"
 #include "network/st_blocking/ServerImpl.h"
+#include "network/st_coroutine/ServerImpl.h"
 #include "network/st_nonblocking/ServerImpl.h"
+#include "network/uring/ServerImpl.h"
 
+#include "storage/ArenaLRU.h"
+#include "storage/ClockLRU.h"
+#include "storage/ShardedLRU.h"
 #include "storage/SimpleLRU.h"
 #include "storage/ThreadSafeSimpleLRU.h"
 
@@ -50,10 +56,21 @@ public:
             storage_type = options["storage"].as<std::string>();
         }
 
+        size_t cache_size = 1024;
+        if (options.count("cache-size") > 0) {
+            cache_size = options["cache-size"].as<size_t>();
+        }
+
         if (storage_type == "st_lru") {
-            storage = std::make_shared<Afina::Backend::SimpleLRU>();
+            storage = std::make_shared<Afina::Backend::SimpleLRU>(cache_size);
         } else if (storage_type == "mt_lru") {
-            storage = std::make_shared<Afina::Backend::ThreadSafeSimplLRU>();
+            storage = std::make_shared<Afina::Backend::ThreadSafeSimplLRU>(cache_size);
+        } else if (storage_type == "sharded_lru") {
+            storage = std::make_shared<Afina::Backend::ShardedLRU>(cache_size);
+        } else if (storage_type == "clock_lru") {
+            storage = std::make_shared<Afina::Backend::ClockLRU>(cache_size);
+        } else if (storage_type == "arena_lru") {
+            storage = std::make_shared<Afina::Backend::ArenaLRU>(cache_size);
         } else {
             throw std::runtime_error("Unknown storage type");
         }
@@ -64,6 +81,15 @@ public:
             network_type = options["network"].as<std::string>();
         }
 
+        if (options.count("workers") > 0) {
+            workers = options["workers"].as<size_t>();
+        }
+
+        size_t storage_threads = 0;
+        if (options.count("storage-threads") > 0) {
+            storage_threads = options["storage-threads"].as<size_t>();
+        }
+
         if (network_type == "st_block") {
             server = std::make_shared<Afina::Network::STblocking::ServerImpl>(storage, logService);
         } else if (network_type == "mt_block") {
@@ -71,10 +97,20 @@ public:
         } else if (network_type == "st_nonblock") {
             server = std::make_shared<Afina::Network::STnonblock::ServerImpl>(storage, logService);
         } else if (network_type == "mt_nonblock") {
-            server = std::make_shared<Afina::Network::MTnonblock::ServerImpl>(storage, logService);
+            server = std::make_shared<Afina::Network::MTnonblock::ServerImpl>(storage, logService, storage_threads);
+        } else if (network_type == "reuseport") {
+            server = std::make_shared<Afina::Network::MTreuseport::ServerImpl>(storage, logService);
+        } else if (network_type == "uring") {
+            server = std::make_shared<Afina::Network::Uring::ServerImpl>(storage, logService);
+        } else if (network_type == "coroutine") {
+            server = std::make_shared<Afina::Network::STcoroutine::ServerImpl>(storage, logService);
         } else {
             throw std::runtime_error("Unknown network type");
         }
+
+        if (options.count("max-pending-bytes") > 0) {
+            server->SetMaxPending(options["max-pending-bytes"].as<size_t>());
+        }
     }
 
     // Start services in correct order
@@ -89,7 +125,7 @@ public:
         // TODO: configure network service
         const uint16_t port = 8080;
         log->warn("Start network on {}", port);
-        server->Start(port, 2, 2);
+        server->Start(port, 2, workers);
     }
 
     // Stop services in correct order
@@ -109,6 +145,9 @@ private:
 
     std::shared_ptr<Afina::Storage> storage;
     std::shared_ptr<Afina::Network::Server> server;
+
+    // Number of network threads
+    size_t workers = 2;
 };
 
 // Signal set that to notify application about time to stop
@@ -128,7 +167,13 @@ int main(int argc, char **argv) {
         // TODO: use custom cxxopts::value to print options possible values in help message
         // and simplify validation below
         options.add_options()("s,storage", "Type of storage service to use", cxxopts::value<std::string>());
+        options.add_options()("c,cache-size", "Storage memory limit in bytes", cxxopts::value<size_t>());
         options.add_options()("n,network", "Type of network service to use", cxxopts::value<std::string>());
+        options.add_options()("w,workers", "Number of network threads", cxxopts::value<size_t>());
+        options.add_options()("storage-threads", "Number of threads executing commands, mt_nonblock only",
+                              cxxopts::value<size_t>());
+        options.add_options()("max-pending-bytes", "Unsent responses limit per connection, reading stops beyond",
+                              cxxopts::value<size_t>());
         options.add_options()("h,help", "Print usage info");
         options.parse(argc, argv);
 
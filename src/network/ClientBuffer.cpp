@@ -0,0 +1,56 @@
+#include "ClientBuffer.h"
+
+#include <cstring>
+
+namespace Afina {
+namespace Network {
+
+// See ClientBuffer.h
+ClientBuffer::ClientBuffer(std::size_t capacity)
+    : _initial(capacity), _data(new char[capacity]), _capacity(capacity), _read(0), _parsed(0) {}
+
+// See ClientBuffer.h
+void ClientBuffer::parsed(std::size_t amount) {
+    _parsed += amount;
+    if (_parsed == _read) {
+        reset();
+    }
+}
+
+// See ClientBuffer.h
+void ClientBuffer::reserve(std::size_t amount) {
+    if (read_size() >= amount) {
+        return;
+    }
+
+    std::size_t pending = parse_size();
+    if (_capacity - pending >= amount && pending <= _capacity / 2) {
+        std::memmove(_data.get(), parse_ptr(), pending);
+    } else {
+        std::size_t capacity = _capacity * 2;
+        while (capacity - pending < amount) {
+            capacity *= 2;
+        }
+
+        std::unique_ptr<char[]> data(new char[capacity]);
+        std::memcpy(data.get(), parse_ptr(), pending);
+        _data.swap(data);
+        _capacity = capacity;
+    }
+
+    _parsed = 0;
+    _read = pending;
+}
+
+// See ClientBuffer.h
+void ClientBuffer::reset() {
+    _read = 0;
+    _parsed = 0;
+    if (_capacity > _initial) {
+        _data.reset(new char[_initial]);
+        _capacity = _initial;
+    }
+}
+
+} // namespace Network
+} // namespace Afina
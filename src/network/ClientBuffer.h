@@ -0,0 +1,60 @@
+#ifndef AFINA_NETWORK_CLIENTBUFFER_H
+#define AFINA_NETWORK_CLIENTBUFFER_H
+
+#include <cstddef>
+#include <memory>
+
+namespace Afina {
+namespace Network {
+
+/**
+ * # Connection input buffer
+ * Socket reads append bytes to the free tail, parser consumes them from the head, both in place. Space
+ * taken by consumed bytes is reclaimed lazily: once tail is too small for the next read, pending bytes
+ * are moved to the beginning, and if that isn't enough buffer doubles. So every byte is moved O(1) times
+ * amortized and large set payload arriving in many small reads costs linear time. Nothing is ever
+ * zeroed, drained buffer just rewinds and gives back memory it grew for.
+ */
+class ClientBuffer {
+public:
+    ClientBuffer(std::size_t capacity = 4096);
+
+    ClientBuffer(const ClientBuffer &) = delete;
+    ClientBuffer &operator=(const ClientBuffer &) = delete;
+
+    // Free space to read into
+    char *read_ptr() { return _data.get() + _read; }
+    std::size_t read_size() const { return _capacity - _read; }
+
+    // Marks amount bytes at read_ptr() as filled
+    void read(std::size_t amount) { _read += amount; }
+
+    // Bytes read but not consumed yet
+    char *parse_ptr() { return _data.get() + _parsed; }
+    std::size_t parse_size() const { return _read - _parsed; }
+
+    // Marks amount bytes at parse_ptr() as consumed
+    void parsed(std::size_t amount);
+
+    // Makes sure at least amount bytes could be read keeping pending ones
+    void reserve(std::size_t amount);
+
+    // Drops all bytes
+    void reset();
+
+private:
+    // Capacity buffer starts with and shrinks back to
+    const std::size_t _initial;
+
+    std::unique_ptr<char[]> _data;
+    std::size_t _capacity;
+
+    // Offsets of the end of filled and consumed bytes
+    std::size_t _read;
+    std::size_t _parsed;
+};
+
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_CLIENTBUFFER_H
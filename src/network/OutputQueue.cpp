@@ -0,0 +1,79 @@
+#include "OutputQueue.h"
+
+#include <algorithm>
+#include <cerrno>
+
+#include <sys/uio.h>
+
+namespace Afina {
+namespace Network {
+
+const std::size_t OutputQueue::max_iovecs;
+
+// See OutputQueue.h
+OutputQueue::OutputQueue(std::size_t limit) : _limit(std::max<std::size_t>(limit, 1)), _position(0), _size(0) {}
+
+// See OutputQueue.h
+void OutputQueue::push(Execute::Response &&response) {
+    if (response.empty()) {
+        return;
+    }
+    _size += response.size();
+    _responses.push_back(std::move(response));
+}
+
+// See OutputQueue.h
+std::size_t OutputQueue::gather(std::size_t offset, struct iovec *iov, std::size_t max) const {
+    offset += _position;
+    std::size_t count = 0;
+    for (auto it = _responses.begin(); it != _responses.end() && count < max; ++it) {
+        if (offset >= it->size()) {
+            offset -= it->size();
+            continue;
+        }
+        count += it->gather(offset, iov + count, max - count);
+        offset = 0;
+    }
+    return count;
+}
+
+// See OutputQueue.h
+void OutputQueue::sent(std::size_t amount) {
+    _size -= amount;
+    _position += amount;
+    while (!_responses.empty() && _position >= _responses.front().size()) {
+        _position -= _responses.front().size();
+        _responses.pop_front();
+    }
+}
+
+// See OutputQueue.h
+ssize_t OutputQueue::write(int socket) {
+    struct iovec iovecs[max_iovecs];
+    std::size_t count = gather(0, iovecs, max_iovecs);
+    ssize_t written = writev(socket, iovecs, count);
+    if (written > 0) {
+        sent(written);
+    }
+    return written;
+}
+
+// See OutputQueue.h
+bool OutputQueue::flush(int socket) {
+    while (!empty()) {
+        if (write(socket) < 0 && errno != EINTR) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// See OutputQueue.h
+void OutputQueue::clear() {
+    _responses.clear();
+    _position = 0;
+    _size = 0;
+}
+
+} // namespace Network
+} // namespace Afina
@@ -0,0 +1,88 @@
+#ifndef AFINA_NETWORK_OUTPUTQUEUE_H
+#define AFINA_NETWORK_OUTPUTQUEUE_H
+
+#include <cstddef>
+#include <deque>
+
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include <afina/execute/Response.h>
+
+namespace Afina {
+namespace Network {
+
+/**
+ * # Connection output queue
+ * Responses of the executed commands waiting to be sent, in order. Connection executes everything it has
+ * read and then sends the whole queue by writev, so a client pipelining commands gets their responses in as
+ * few syscalls and packets as possible. Values referenced by responses go to the socket right from the
+ * storage memory and stay pinned until sent.
+ *
+ * Queue counts bytes pending and is full once there are limit of them: connection should stop reading
+ * commands then until client takes some responses, so client that doesn't read can't make server buffer
+ * unbounded amount of data. Limit is soft, commands already read are executed anyway.
+ *
+ * Responses never move in memory until they are sent, so iovecs gathered stay valid while queue grows.
+ */
+class OutputQueue {
+public:
+    // Number of segments gathered for a single writev
+    static const std::size_t max_iovecs = 64;
+
+    // Limit is at least a byte, so full queue always has something to send
+    OutputQueue(std::size_t limit);
+
+    OutputQueue(const OutputQueue &) = delete;
+    OutputQueue &operator=(const OutputQueue &) = delete;
+
+    // Appends response to the tail
+    void push(Execute::Response &&response);
+
+    // Bytes not sent yet
+    std::size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+
+    // Whether connection should stop reading commands
+    bool full() const { return _size >= _limit; }
+
+    /**
+     * Fills iovecs with pending bytes, returns number of iovecs filled
+     *
+     * @param offset number of pending bytes to skip
+     * @param iov array to fill
+     * @param max number of elements in iov
+     */
+    std::size_t gather(std::size_t offset, struct iovec *iov, std::size_t max) const;
+
+    // Drops amount bytes from the head as sent, releasing responses sent completely
+    void sent(std::size_t amount);
+
+    /**
+     * Sends pending bytes by a single writev and drops what was sent. Returns writev result, so on error
+     * errno tells what happened
+     */
+    ssize_t write(int socket);
+
+    // Sends the whole queue to the blocking socket, returns false on error and errno tells what happened
+    bool flush(int socket);
+
+    // Drops all responses
+    void clear();
+
+private:
+    const std::size_t _limit;
+
+    std::deque<Execute::Response> _responses;
+
+    // Bytes of the first response sent already
+    std::size_t _position;
+
+    // Bytes of all responses minus position
+    std::size_t _size;
+};
+
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_OUTPUTQUEUE_H
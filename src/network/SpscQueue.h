@@ -0,0 +1,87 @@
+#ifndef AFINA_NETWORK_SPSC_QUEUE_H
+#define AFINA_NETWORK_SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+namespace Afina {
+namespace Network {
+
+/**
+ * # Bounded single producer single consumer queue
+ * Lock free ring of power of 2 capacity. Producer only writes the tail and consumer only writes the
+ * head, each of them keeps a cached copy of the other index and rereads it only when ring looks full or
+ * empty, so most of the calls touch no cache line written by the other side.
+ *
+ * Exactly one thread may push and exactly one thread may pop at a time.
+ */
+template <typename T> class SpscQueue {
+public:
+    // Capacity is rounded up to the power of 2
+    SpscQueue(std::size_t capacity) : _head(0), _tail_cache(0), _tail(0), _head_cache(0) {
+        std::size_t size = 1;
+        while (size < capacity) {
+            size *= 2;
+        }
+        _mask = size - 1;
+        _items.reset(new T[size]);
+    }
+
+    SpscQueue(const SpscQueue &) = delete;
+    SpscQueue &operator=(const SpscQueue &) = delete;
+
+    // Appends value to the tail, returns false if queue is full. Producer side
+    bool push(const T &value) {
+        std::size_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail - _head_cache > _mask) {
+            _head_cache = _head.load(std::memory_order_acquire);
+            if (tail - _head_cache > _mask) {
+                return false;
+            }
+        }
+
+        _items[tail & _mask] = value;
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Takes value from the head, returns false if queue is empty. Consumer side
+    bool pop(T &value) {
+        std::size_t head = _head.load(std::memory_order_relaxed);
+        if (head == _tail_cache) {
+            _tail_cache = _tail.load(std::memory_order_acquire);
+            if (head == _tail_cache) {
+                return false;
+            }
+        }
+
+        value = _items[head & _mask];
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    std::size_t capacity() const { return _mask + 1; }
+
+private:
+    static const std::size_t cache_line = 64;
+
+    std::unique_ptr<T[]> _items;
+    std::size_t _mask;
+
+    // Consumer side
+    char _pad0[cache_line];
+    std::atomic<std::size_t> _head;
+    std::size_t _tail_cache;
+
+    // Producer side
+    char _pad1[cache_line];
+    std::atomic<std::size_t> _tail;
+    std::size_t _head_cache;
+    char _pad2[cache_line];
+};
+
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_SPSC_QUEUE_H
@@ -22,8 +22,8 @@
 #include <afina/execute/Command.h>
 #include <afina/logging/Service.h>
 
+#include "network/OutputQueue.h"
 #include "protocol/Parser.h"
-#include "Worker.h"
 
 namespace Afina {
 namespace Network {
@@ -35,6 +35,10 @@ ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Loggi
 // See Server.h
 ServerImpl::~ServerImpl() {}
 
+const std::size_t ServerImpl::max_workers;
+const std::size_t ServerImpl::max_queued_connections;
+const std::chrono::milliseconds ServerImpl::accept_timeout(1000);
+
 // See Server.h
 void ServerImpl::Start(uint16_t port, uint32_t n_accept, uint32_t n_workers) {
     _logger = pLogging->select("network");
@@ -74,6 +78,11 @@ void ServerImpl::Start(uint16_t port, uint32_t n_accept, uint32_t n_workers) {
         throw std::runtime_error("Socket listen() failed");
     }
 
+    _executor.reset(new Afina::Executor("mt_blocking", n_workers, max_workers, max_queued_connections,
+                                        std::chrono::milliseconds(1000), Afina::Executor::Overflow::kBlock,
+                                        accept_timeout));
+    _executor->Start();
+
     running.store(true);
     _thread = std::thread(&ServerImpl::OnRun, this);
 }
@@ -82,26 +91,35 @@ void ServerImpl::Start(uint16_t port, uint32_t n_accept, uint32_t n_workers) {
 void ServerImpl::Stop() {
     running.store(false);
     shutdown(_server_socket, SHUT_RDWR);
+
+    // Wake up connections blocked in read, they are going to see end of stream and finish
+    {
+        std::lock_guard<std::mutex> lock(_sockets_mutex);
+        for (int client_socket : _client_sockets) {
+            shutdown(client_socket, SHUT_RD);
+        }
+    }
+
+    // Acceptor might be waiting for a room in queue
+    _executor->Stop();
 }
 
 // See Server.h
 void ServerImpl::Join() {
     assert(_thread.joinable());
     _thread.join();
+    _executor->Stop(true);
     close(_server_socket);
+
+    Afina::Executor::Stats stats = _executor->stats();
+    if (stats.blocked > 0) {
+        _logger->warn("Acceptor waited for free thread {} times, dropped {} connections", stats.blocked,
+                      stats.timed_out);
+    }
 }
 
 // See Server.h
 void ServerImpl::OnRun() {
-    // Here is connection state
-    // - parser: parse state of the stream
-    // - command_to_execute: last command parsed out of stream
-    // - arg_remains: how many bytes to read from stream to get command argument
-    // - argument_for_command: buffer stores argument
-    std::size_t arg_remains;
-    Protocol::Parser parser;
-    std::string argument_for_command;
-    std::unique_ptr<Execute::Command> command_to_execute;
     while (running.load()) {
         _logger->debug("waiting for connection...");
 
@@ -134,32 +152,159 @@ void ServerImpl::OnRun() {
             setsockopt(client_socket, SOL_SOCKET, SO_RCVTIMEO, (const char *)&tv, sizeof tv);
         }
 
-        // TODO: Start new thread and process data from/to connection
+        // Register connection before it gets to executor, so that Stop never misses it
         {
-            std::unique_ptr<Worker> new_worker(new Worker(pStorage.get()));
-            std::unique_lock<std::mutex> lc(_workers_mutex);
-            if (_workers.size() < _max_workers) { // we can create new connection
-                new_worker->Start(_wid, client_socket, client_addr);
-                new_worker->Detach();
-                _workers.push_back(std::move(new_worker));
-                _wid++;
-            }
-            else { // no room, sorry
+            std::lock_guard<std::mutex> lock(_sockets_mutex);
+            if (!running.load()) {
                 close(client_socket);
+                break;
             }
+            _client_sockets.insert(client_socket);
+        }
+
+        // Job is constructed only once it gets a place in executor, so socket is closed here otherwise. Job
+        // dropped from queue later closes the socket by itself
+        if (!_executor->Execute<Job>(this, client_socket)) {
+            if (running.load()) {
+                _logger->warn("No free thread for connection on descriptor {} in {} ms, closing", client_socket,
+                              accept_timeout.count());
+            }
+            Close(client_socket);
         }
     }
 
     // Cleanup on exit...
-    std::unique_lock<std::mutex> lc(_workers_mutex);
-    while (!_workers.empty()) {
-        _serv_lock.wait(lc);
-    }
-    if (!_workers.empty())
-        _workers.erase(_workers.begin(), _workers.end());
     _logger->warn("Network stopped");
 }
 
+// See ServerImpl.h
+void ServerImpl::OnConnection(int client_socket) {
+    // Here is connection state
+    // - parser: parse state of the stream
+    // - command_to_execute: last command parsed out of stream
+    // - arg_remains: how many bytes to read from stream to get command argument
+    // - argument_for_command: buffer stores argument
+    // - output: responses not sent yet
+    std::size_t arg_remains;
+    Protocol::Parser parser;
+    std::string argument_for_command;
+    std::unique_ptr<Execute::Command> command_to_execute;
+    OutputQueue output(max_pending);
+
+    // Process new connection:
+    // - read commands until socket alive
+    // - execute each command
+    // - send responses to all commands of the read at once
+    try {
+        int readed_bytes = -1;
+        char client_buffer[4096];
+        while ((readed_bytes = read(client_socket, client_buffer, sizeof(client_buffer))) > 0) {
+            _logger->debug("Got {} bytes from socket", readed_bytes);
+
+            // Single block of data readed from the socket could trigger inside actions a multiple times,
+            // for example:
+            // - read#0: [<command1 start>]
+            // - read#1: [<command1 end> <argument> <command2> <argument for command 2> <command3> ... ]
+            while (readed_bytes > 0) {
+                _logger->debug("Process {} bytes", readed_bytes);
+                // There is no command yet
+                if (!command_to_execute) {
+                    std::size_t parsed = 0;
+                    if (parser.Parse(client_buffer, readed_bytes, parsed)) {
+                        // There is no command to be launched, continue to parse input stream
+                        // Here we are, current chunk finished some command, process it
+                        _logger->debug("Found new command: {} in {} bytes", parser.Name(), parsed);
+                        command_to_execute = parser.Build(arg_remains);
+                        if (arg_remains > 0) {
+                            arg_remains += 2;
+                        }
+                    }
+
+                    // Parsed might fails to consume any bytes from input stream. In real life that could happens,
+                    // for example, because we are working with UTF-16 chars and only 1 byte left in stream
+                    if (parsed == 0) {
+                        break;
+                    } else {
+                        std::memmove(client_buffer, client_buffer + parsed, readed_bytes - parsed);
+                        readed_bytes -= parsed;
+                    }
+                }
+
+                // There is command, but we still wait for argument to arrive...
+                if (command_to_execute && arg_remains > 0) {
+                    _logger->debug("Fill argument: {} bytes of {}", readed_bytes, arg_remains);
+                    // There is some parsed command, and now we are reading argument
+                    std::size_t to_read = std::min(arg_remains, std::size_t(readed_bytes));
+                    argument_for_command.append(client_buffer, to_read);
+
+                    std::memmove(client_buffer, client_buffer + to_read, readed_bytes - to_read);
+                    arg_remains -= to_read;
+                    readed_bytes -= to_read;
+                }
+
+                // Thre is command & argument - RUN!
+                if (command_to_execute && arg_remains == 0) {
+                    _logger->debug("Start command execution");
+
+                    Execute::Response result;
+                    command_to_execute->Execute(*pStorage, argument_for_command, result);
+                    result.append("\r\n");
+                    output.push(std::move(result));
+
+                    // Client reading nothing doesn't make responses pile up
+                    if (output.full() && !output.flush(client_socket)) {
+                        throw std::runtime_error("Failed to send response");
+                    }
+
+                    // Prepare for the next command
+                    command_to_execute.reset();
+                    argument_for_command.resize(0);
+                    parser.Reset();
+                }
+            } // while (readed_bytes)
+
+            // Responses to all commands read go out together
+            if (!output.flush(client_socket)) {
+                throw std::runtime_error("Failed to send response");
+            }
+        }
+
+        if (readed_bytes == 0) {
+            _logger->debug("Connection closed");
+        } else {
+            throw std::runtime_error(std::string(strerror(errno)));
+        }
+    } catch (std::runtime_error &ex) {
+        _logger->error("Failed to process connection on descriptor {}: {}", client_socket, ex.what());
+    }
+
+    // We are done with this connection
+    Close(client_socket);
+}
+
+// See ServerImpl.h
+void ServerImpl::Close(int client_socket) {
+    {
+        std::lock_guard<std::mutex> lock(_sockets_mutex);
+        _client_sockets.erase(client_socket);
+    }
+    close(client_socket);
+}
+
+// See ServerImpl.h
+ServerImpl::Job::~Job() {
+    if (_client_socket != -1) {
+        _server->Close(_client_socket);
+    }
+}
+
+// See ServerImpl.h
+void ServerImpl::Job::operator()() {
+    int client_socket = _client_socket;
+    _client_socket = -1;
+    _server->OnConnection(client_socket);
+}
+
 } // namespace MTblocking
 } // namespace Network
 } // namespace Afina
@@ -2,12 +2,15 @@
 #define AFINA_NETWORK_MT_BLOCKING_SERVER_H
 
 #include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <set>
 #include <thread>
 
+#include <afina/Executor.h>
 #include <afina/network/Server.h>
 
-#include "Worker.h"
-
 namespace spdlog {
 class logger;
 }
@@ -18,7 +21,10 @@ namespace MTblocking {
 
 /**
  * # Network resource manager implementation
- * Server that is spawning a separate thread for each connection
+ * Server that is serving each connection by a task of the executor. Task owns pool thread while connection
+ * is alive, so executor high watermark limits number of connections served at once and the rest waits in
+ * its queue. Once the queue is full acceptor waits for a free slot, which leaves new connections in the
+ * listen backlog, and closes the connection if there is no room for too long.
  */
 class ServerImpl : public Server {
 public:
@@ -40,12 +46,41 @@ protected:
      */
     void OnRun();
 
+    /**
+     * Method is running on the executor thread, reads commands from the socket and executes them until
+     * client closes connection
+     */
+    void OnConnection(int client_socket);
+
+    // Forgets connection and closes its socket
+    void Close(int client_socket);
+
+    // Executor task serving the connection, closes socket if destroyed without execution
+    class Job {
+    public:
+        Job(ServerImpl *server, int client_socket) : _server(server), _client_socket(client_socket) {}
+        Job(Job &&other) noexcept : _server(other._server), _client_socket(other._client_socket) {
+            other._client_socket = -1;
+        }
+        ~Job();
+
+        void operator()();
+
+    private:
+        ServerImpl *_server;
+        int _client_socket;
+    };
+
 private:
-    std::mutex _workers_mutex;
-    std::vector<std::unique_ptr<Worker>> _workers;
+    // Max number of connections served at once
+    static const std::size_t max_workers = 100;
+
+    // Max number of accepted connections waiting for a free thread
+    static const std::size_t max_queued_connections = 64;
+
+    // How long acceptor waits for a room in the executor queue
+    static const std::chrono::milliseconds accept_timeout;
 
-    std::condition_variable _serv_lock;
-    
     // Logger instance
     std::shared_ptr<spdlog::logger> _logger;
 
@@ -59,9 +94,13 @@ private:
 
     // Thread to run network on
     std::thread _thread;
-    
-    std::size_t _max_workers = 100;
-    int _wid = 0;
+
+    // Pool serving connections
+    std::unique_ptr<Afina::Executor> _executor;
+
+    // Connections being served, used to interrupt blocking reads on stop
+    std::mutex _sockets_mutex;
+    std::set<int> _client_sockets;
 };
 
 } // namespace MTblocking
@@ -1,5 +1,6 @@
 #include "Connection.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 #include <iostream>
@@ -29,6 +30,8 @@ namespace Afina {
 namespace Network {
 namespace MTnonblock {
 
+const std::size_t Connection::min_read;
+
 // See Connection.h
 void Connection::Start() {
     _logger = pLogging->select("network.connection");
@@ -36,10 +39,12 @@ void Connection::Start() {
     std::unique_lock<std::mutex> lc(lock);
     state = State::Alive;
     command_to_execute.reset();
+    reservation.reset();
     argument_for_command.resize(0);
     parser.Reset();
     results_to_write.clear();
-    write_position = 0;
+    throttled = false;
+    parsed.clear();
     _event.events = Masks::read;
     client_buffer.reset();
 }
@@ -50,6 +55,7 @@ void Connection::OnError() {
     std::unique_lock<std::mutex> lc(lock);
     this->state = State::Dead;
     results_to_write.clear();
+    parsed.clear();
 }
 
 // See Connection.h
@@ -58,6 +64,7 @@ void Connection::OnClose() {
     std::unique_lock<std::mutex> lc(lock);
     this->state = State::Dead;
     results_to_write.clear();
+    parsed.clear();
 }
 
 // See Connection.h
@@ -65,84 +72,178 @@ void Connection::DoRead() {
     _logger->info("Connection reading");
     std::unique_lock<std::mutex> lc(lock);
     try {
-        int read_bytes = -1;
-        while (read_bytes = read(_socket, client_buffer.read_ptr(), client_buffer.read_size()) > 0) {
+        while (true) {
+            // Client has to take responses before it gets more commands executed
+            throttled = Throttled();
+            if (throttled) {
+                break;
+            }
+
+            // Once buffered bytes are consumed, rest of the reserved argument is read right into the storage
+            // memory. Trailing \r\n goes through the buffer as it is usually followed by the next command
+            char *read_ptr;
+            std::size_t read_size;
+            bool direct = reservation && arg_remains > 2;
+            if (direct) {
+                read_ptr = reservation->data() + (reservation->size() + 2 - arg_remains);
+                read_size = arg_remains - 2;
+            } else {
+                client_buffer.reserve(min_read);
+                read_ptr = client_buffer.read_ptr();
+                read_size = client_buffer.read_size();
+            }
+
+            ssize_t read_bytes = read(_socket, read_ptr, read_size);
+            if (read_bytes == 0) {
+                _logger->debug("Connection closed");
+                state = State::Dead;
+                break;
+            } else if (read_bytes < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    break;
+                } else if (errno == EINTR) {
+                    continue;
+                }
+                throw std::runtime_error(std::string(strerror(errno)));
+            }
+            if (direct) {
+                arg_remains -= read_bytes;
+                continue;
+            }
             client_buffer.read(read_bytes);
+
+            // Single read could finish several commands, parser consumes them right from the buffer
             while (client_buffer.parse_size() > 0) {
-                std::size_t parsed = 0;
                 if (!command_to_execute) {
+                    std::size_t parsed = 0;
                     if (parser.Parse(client_buffer.parse_ptr(), client_buffer.parse_size(), parsed)) {
                         command_to_execute = parser.Build(arg_remains);
+
+                        // Small arguments come along with the command, copying them costs less than the
+                        // extra read needed to put them right into the storage
+                        if (arg_remains >= min_read) {
+                            reservation = command_to_execute->Reserve(*_storage, arg_remains);
+                        }
                         if (arg_remains > 0) {
                             arg_remains += 2;
+                            if (!reservation) {
+                                argument_for_command.reserve(arg_remains);
+                            }
                         }
                     }
+
                     if (parsed == 0) {
                         break;
-                    } else {
-                        client_buffer.parsed(parsed);
                     }
+                    client_buffer.parsed(parsed);
                 }
+
                 if (command_to_execute && arg_remains > 0) {
-                    std::size_t to_read = std::min(arg_remains, std::size_t(client_buffer.parse_size()));
-                    argument_for_command.append(client_buffer.parse_ptr(), to_read);
+                    std::size_t to_read = std::min(arg_remains, client_buffer.parse_size());
+                    if (reservation) {
+                        std::size_t position = reservation->size() + 2 - arg_remains;
+                        if (position < reservation->size()) {
+                            std::size_t to_copy = std::min(to_read, reservation->size() - position);
+                            std::memcpy(reservation->data() + position, client_buffer.parse_ptr(), to_copy);
+                        }
+                    } else {
+                        argument_for_command.append(client_buffer.parse_ptr(), to_read);
+                    }
 
                     arg_remains -= to_read;
                     client_buffer.parsed(to_read);
                 }
 
                 if (command_to_execute && arg_remains == 0) {
-                    std::string result_to_write;
-                    command_to_execute->Execute(*_storage, argument_for_command, result_to_write);
-                    result_to_write += "\r\n";
-                    results_to_write.push_back(result_to_write);
+                    // Argument is followed by \r\n which isn't a part of it
+                    if (!reservation && argument_for_command.size() >= 2) {
+                        argument_for_command.resize(argument_for_command.size() - 2);
+                    }
+
+                    if (pipeline) {
+                        parsed.push_back(Parsed{std::move(command_to_execute), std::move(argument_for_command),
+                                                std::move(reservation)});
+                    } else {
+                        Execute::Response result_to_write;
+                        Run(*command_to_execute, argument_for_command, reservation.get(), result_to_write);
+                        reservation.reset();
+                        results_to_write.push(std::move(result_to_write));
+                    }
 
                     command_to_execute.reset();
                     argument_for_command.resize(0);
                     parser.Reset();
-
-                    _event.events = Masks::read_write;
                 }
             }
-            client_buffer.conditional_reset();
-        }
-        if (read_bytes > 0) {
-            throw std::runtime_error(std::string(strerror(errno)));
         }
+    } catch (std::runtime_error &ex) {
+        _logger->error("Failed to process connection on descriptor {}: {}", _socket, ex.what());
+        state = State::Dead;
     }
-    catch (std::runtime_error &ex) {
+    UpdateEvents();
+}
+
+// See Connection.h
+void Connection::DoExecute() {
+    try {
+        for (auto &command : executing) {
+            Execute::Response result;
+            Run(*command.command, command.argument, command.reservation.get(), result);
+            executed.push_back(std::move(result));
+        }
+    } catch (std::runtime_error &ex) {
         _logger->error("Failed to process connection on descriptor {}: {}", _socket, ex.what());
+        failed = true;
+    }
+    executing.clear();
+}
+
+// See Connection.h
+void Connection::Run(Execute::Command &command, const std::string &argument, Afina::Storage::Reservation *reservation,
+                     Execute::Response &out) {
+    if (reservation != nullptr) {
+        std::string result;
+        command.Complete(*reservation, result);
+        out.append(result);
+    } else {
+        command.Execute(*_storage, argument, out);
     }
+    out.append("\r\n");
 }
 
 // See Connection.h
 void Connection::DoWrite() {
     _logger->info("Connection writing");
     std::unique_lock<std::mutex> lc(lock);
-    struct iovec iovecs[results_to_write.size()];
-    for (int i = 0; i < results_to_write.size(); i++) {
-        iovecs[i].iov_len = results_to_write[i].size();
-        iovecs[i].iov_base = &(results_to_write[i][0]);
-    }
-    iovecs[0].iov_base = static_cast<char*>(iovecs[0].iov_base) + write_position;
-    iovecs[0].iov_len -= write_position;
 
-    int written;
-    if ((written = writev(_socket, iovecs, results_to_write.size())) <= 0) {
-        _logger->error("Failed to send response");
+    // Socket is written until it is full, so edge triggered poller gets notified once there is room again
+    while (!results_to_write.empty()) {
+        if (results_to_write.write(_socket) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                _logger->error("Failed to send response: {}", strerror(errno));
+                state = State::Dead;
+            }
+            break;
+        }
     }
-    write_position += written;
+    UpdateEvents();
+}
 
-    int i = 0;
-    for (; i < results_to_write.size() && (write_position - iovecs[i].iov_len) >= 0; i++) {
-        write_position -= iovecs[i].iov_len;
-    }
+// See Connection.h
+bool Connection::Throttled() const {
+    return results_to_write.full() || (in_flight && !parsed.empty());
+}
 
-    results_to_write.erase(results_to_write.begin(), results_to_write.begin() + i);
-    if (results_to_write.empty()) {
+// See Connection.h
+void Connection::UpdateEvents() {
+    if (Throttled()) {
+        _event.events = results_to_write.empty() ? Masks::idle : Masks::write;
+    } else if (results_to_write.empty()) {
         _event.events = Masks::read;
-    }
-    else {
+    } else {
         _event.events = Masks::read_write;
     }
 }
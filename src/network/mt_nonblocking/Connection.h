@@ -4,10 +4,12 @@
 #include <cstring>
 #include <afina/Storage.h>
 #include <afina/execute/Command.h>
+#include <afina/execute/Response.h>
 #include <afina/logging/Service.h>
 
+#include "network/ClientBuffer.h"
+#include "network/OutputQueue.h"
 #include "protocol/Parser.h"
-#include "ClientBuffer.h"
 #include "Worker.h"
 
 #include <sys/epoll.h>
@@ -27,15 +29,24 @@ public:
     struct Masks {
         static const int read = ((EPOLLIN | EPOLLRDHUP) | EPOLLERR);
         static const int read_write = (((EPOLLIN | EPOLLRDHUP) | EPOLLERR) | EPOLLOUT);
+        static const int write = ((EPOLLRDHUP | EPOLLERR) | EPOLLOUT);
+        static const int idle = (EPOLLRDHUP | EPOLLERR);
     };
 
-    Connection(int s, std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl) :
+    /**
+     * @param max_pending bytes of responses connection could keep unsent before it stops reading
+     * @param pipeline whether commands are executed by the storage pool instead of the thread reading them,
+     * see Worker
+     */
+    Connection(int s, std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl,
+               std::size_t max_pending, bool pipeline = false) :
                 _socket(s),
                 _storage(ps),
-                pLogging(pl) {
+                pLogging(pl),
+                results_to_write(max_pending),
+                pipeline(pipeline) {
         std::memset(&_event, 0, sizeof(struct epoll_event));
         _event.data.ptr = this;
-        client_buffer = ClientBuffer();
     }
 
     inline bool isAlive() const {
@@ -53,7 +64,30 @@ protected:
     void DoRead();
     void DoWrite();
 
+    // Sets events to wait for: reading stops while output queue is full or, in pipeline mode, while
+    // there is a batch in flight and the next one is parsed already
+    void UpdateEvents();
+
+    // Whether connection has to stop reading, see UpdateEvents
+    bool Throttled() const;
+
+    // Executes batch taken by the storage pool, see Worker::Submit
+    void DoExecute();
+
 private:
+    // Command parsed in pipeline mode along with its argument
+    struct Parsed {
+        std::unique_ptr<Execute::Command> command;
+        std::string argument;
+        std::unique_ptr<Afina::Storage::Reservation> reservation;
+    };
+
+    // Executes command, which argument is either in reservation or in the string
+    void Run(Execute::Command &command, const std::string &argument, Afina::Storage::Reservation *reservation,
+             Execute::Response &out);
+
+    // Socket is never read into less space than that
+    static const std::size_t min_read = 4096;
 
     friend class ServerImpl;
     friend class Worker;
@@ -66,12 +100,37 @@ private:
     std::string argument_for_command;
     std::unique_ptr<Execute::Command> command_to_execute;
     std::shared_ptr<Afina::Storage> _storage;
+
+    // Storage memory large argument of the current command is read into, taken after storage so it is
+    // released first
+    std::unique_ptr<Afina::Storage::Reservation> reservation;
     std::shared_ptr<Logging::Service> pLogging;
     std::shared_ptr<spdlog::logger> _logger;
-    std::vector<std::string> results_to_write;
+
+    // Responses not sent yet, they could reference storage memory and keep it alive until sent
+    OutputQueue results_to_write;
     ClientBuffer client_buffer;
-    std::size_t write_position = 0;
+
+    // Whether connection stopped reading as client doesn't take responses, socket could have data then
+    bool throttled = false;
     std::mutex lock;
+
+    // Events served by the owning worker in its current window, tells hot connections apart
+    uint64_t window_events = 0;
+
+    // Pipeline mode: commands parsed since the last batch was submitted
+    const bool pipeline;
+    std::vector<Parsed> parsed;
+
+    // Batch executed by the storage pool and its results, worker doesn't touch them until batch comes
+    // back. Connection has at most one batch in flight so commands are executed in order
+    std::vector<Parsed> executing;
+    std::vector<Execute::Response> executed;
+    bool in_flight = false;
+    bool failed = false;
+
+    // Next connection in the list of batches done, see Worker::Done
+    Connection *next_done = nullptr;
 };
 
 } // namespace MTnonblock
@@ -18,6 +18,7 @@
 
 #include <spdlog/logger.h>
 
+#include <afina/Executor.h>
 #include <afina/Storage.h>
 #include <afina/logging/Service.h>
 
@@ -29,8 +30,17 @@ namespace Afina {
 namespace Network {
 namespace MTnonblock {
 
+namespace {
+
+// Batches waiting for the storage pool, once there are more worker executes batch itself
+const std::size_t storage_queue = 1024;
+
+} // namespace
+
 // See Server.h
-ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl) : Server(ps, pl) {}
+ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl,
+                       std::size_t storage_threads)
+    : Server(ps, pl), _storage_threads(storage_threads) {}
 
 // See Server.h
 ServerImpl::~ServerImpl() {}
@@ -71,39 +81,38 @@ void ServerImpl::Start(uint16_t port, uint32_t n_acceptors, uint32_t n_workers)
     }
 
     make_socket_non_blocking(_server_socket);
-    if (listen(_server_socket, 5) == -1) {
+    if (listen(_server_socket, SOMAXCONN) == -1) {
         close(_server_socket);
         throw std::runtime_error("Socket listen() failed: " + std::string(strerror(errno)));
     }
 
-    // Start IO workers
-    _data_epoll_fd = epoll_create1(0);
-    if (_data_epoll_fd == -1) {
-        throw std::runtime_error("Failed to create epoll file descriptor: " + std::string(strerror(errno)));
-    }
-
     _event_fd = eventfd(0, EFD_NONBLOCK);
     if (_event_fd == -1) {
         throw std::runtime_error("Failed to create epoll file descriptor: " + std::string(strerror(errno)));
     }
 
-    struct epoll_event event;
-    event.events = EPOLLIN;
-    event.data.ptr = nullptr;
-    if (epoll_ctl(_data_epoll_fd, EPOLL_CTL_ADD, _event_fd, &event)) {
-        throw std::runtime_error("Failed to add eventfd descriptor to epoll");
+    if (_storage_threads > 0) {
+        _storage_pool.reset(new Afina::Executor("storage", _storage_threads, _storage_threads, storage_queue,
+                                                std::chrono::milliseconds(1000),
+                                                Afina::Executor::Overflow::kRunInCaller));
+        _storage_pool->Start();
+        _logger->info("Commands are executed by {} storage threads", _storage_threads);
     }
 
+    // Start IO workers, every acceptor and every worker could hand connections to any worker. All
+    // workers are created before any of them starts, as they are peers of each other
     _workers.reserve(n_workers);
     for (int i = 0; i < n_workers; i++) {
-        _workers.emplace_back(pStorage, pLogging);
-        _workers.back().Start(_data_epoll_fd);
+        _workers.emplace_back(new Worker(pStorage, pLogging, n_acceptors + n_workers, _storage_pool.get()));
+    }
+    for (int i = 0; i < n_workers; i++) {
+        _workers[i]->Start(_workers, n_acceptors + i);
     }
 
     // Start acceptors
     _acceptors.reserve(n_acceptors);
     for (int i = 0; i < n_acceptors; i++) {
-        _acceptors.emplace_back(&ServerImpl::OnRun, this);
+        _acceptors.emplace_back(&ServerImpl::OnRun, this, i);
     }
 }
 
@@ -111,22 +120,15 @@ void ServerImpl::Start(uint16_t port, uint32_t n_acceptors, uint32_t n_workers)
 void ServerImpl::Stop() {
     _logger->warn("Stop network service");
 
-    // Said workers to stop
+    // Said workers to stop, each of them is woken up through its own event descriptor
     for (auto &w : _workers) {
-        w.Stop();
+        w->Stop();
     }
 
-    // Wakeup threads that are sleep on epoll_wait
+    // Wakeup acceptors that are sleep on epoll_wait
     if (eventfd_write(_event_fd, 1)) {
-        throw std::runtime_error("Failed to wakeup workers");
-    }
-
-    for (auto pc : _connections) {
-        close(pc->_socket);
-        delete pc;
+        throw std::runtime_error("Failed to wakeup acceptors");
     }
-
-    close(_server_socket);
 }
 
 // See Server.h
@@ -136,12 +138,23 @@ void ServerImpl::Join() {
     }
 
     for (auto &w : _workers) {
-        w.Join();
+        w->Join();
+    }
+
+    // Workers wait for their batches, but pool thread could still be poking the worker which batch is done
+    if (_storage_pool) {
+        _storage_pool->Stop(true);
+        _storage_pool.reset();
     }
+
+    // Workers close their connections, including ones handed over after they stopped
+    _workers.clear();
+    close(_server_socket);
+    close(_event_fd);
 }
 
 // See ServerImpl.h
-void ServerImpl::OnRun() {
+void ServerImpl::OnRun(std::size_t index) {
     _logger->info("Start acceptor");
     int acceptor_epoll = epoll_create1(0);
     if (acceptor_epoll == -1) {
@@ -200,24 +213,22 @@ void ServerImpl::OnRun() {
                     _logger->info("Accepted connection on descriptor {} (host={}, port={})\n", infd, hbuf, sbuf);
                 }
 
-                // Register the new FD to be monitored by epoll.
-                Connection *pc = new Connection(infd, pStorage, pLogging);
-                if (pc == nullptr) {
-                    throw std::runtime_error("Failed to allocate connection");
-                }
-                _connections.insert(pc);
-
-
-                // Register connection in worker's epoll
+                // Hand connection to the least loaded worker, or to any other if its inbox is full
+                Connection *pc = new Connection(infd, pStorage, pLogging, max_pending, _storage_pool != nullptr);
                 pc->Start();
-                if (pc->isAlive()) {
-                    pc->_event.events |= EPOLLONESHOT;
-                    auto ctlans = epoll_ctl(_data_epoll_fd, EPOLL_CTL_ADD, pc->_socket, &pc->_event);
-                    if (ctlans) {
-                        std::cerr << "Could not ctl epoll (acceptor) : " << ctlans << std::endl;
+                if (!Worker::LeastLoaded(_workers)->Assign(index, pc)) {
+                    bool assigned = false;
+                    for (auto &w : _workers) {
+                        if (w->Assign(index, pc)) {
+                            assigned = true;
+                            break;
+                        }
+                    }
+
+                    if (!assigned) {
+                        _logger->error("All workers are overloaded, connection on descriptor {} dropped", infd);
                         pc->OnError();
                         close(pc->_socket);
-                        _connections.erase(pc);
                         delete pc;
                     }
                 }
@@ -1,9 +1,9 @@
 #ifndef AFINA_NETWORK_MT_NONBLOCKING_SERVER_H
 #define AFINA_NETWORK_MT_NONBLOCKING_SERVER_H
 
+#include <memory>
 #include <thread>
 #include <vector>
-#include <set>
 
 #include <afina/network/Server.h>
 #include "Connection.h"
@@ -13,6 +13,10 @@ class logger;
 }
 
 namespace Afina {
+
+// Forward declaration, see afina/Executor.h
+class Executor;
+
 namespace Network {
 namespace MTnonblock {
 
@@ -21,11 +25,19 @@ class Worker;
 
 /**
  * # Network resource manager implementation
- * Epoll based server
+ * Epoll based server: acceptors share listening socket and hand accepted connections to the least loaded
+ * worker through its lock free inbox, every worker serves its connections with a private epoll instance.
+ * Commands are executed either right by the workers or, in pipeline mode, by the separate pool of storage
+ * threads, see Worker
  */
 class ServerImpl : public Server {
 public:
-    ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl);
+    /**
+     * @param storage_threads number of threads executing commands in pipeline mode, 0 to execute them in
+     * network workers
+     */
+    ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl,
+               std::size_t storage_threads = 0);
     ~ServerImpl();
 
     // See Server.h
@@ -38,7 +50,8 @@ public:
     void Join() override;
 
 protected:
-    void OnRun();
+    // Accepts connections, index tells acceptor inbox in workers
+    void OnRun(std::size_t index);
     void OnNewConnection();
 
 private:
@@ -57,16 +70,15 @@ private:
     // but share global server socket
     std::vector<std::thread> _acceptors;
 
-    // EPOLL instance shared between workers
-    int _data_epoll_fd;
-
-    // Curstom event "device" used to wakeup workers
+    // Curstom event "device" used to wakeup acceptors
     int _event_fd;
 
-    // threads serving read/write requests
-    std::vector<Worker> _workers;
+    // threads serving read/write requests, each allocated separately so worker never moves once started
+    std::vector<std::unique_ptr<Worker>> _workers;
 
-    std::set<Connection*> _connections;
+    // Threads executing commands in pipeline mode, nullptr otherwise
+    std::size_t _storage_threads;
+    std::unique_ptr<Afina::Executor> _storage_pool;
 };
 
 } // namespace MTnonblock
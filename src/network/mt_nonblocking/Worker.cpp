@@ -1,16 +1,24 @@
 #include "Worker.h"
 
+#include <array>
 #include <cassert>
+#include <cstring>
 #include <functional>
 #include <iostream>
+#include <stdexcept>
+#include <string>
 
 #include <netdb.h>
+#include <poll.h>
 #include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <unistd.h>
 
 #include <spdlog/logger.h>
 
+#include <afina/Executor.h>
 #include <afina/logging/Service.h>
 
 #include "Utils.h"
@@ -20,36 +28,77 @@ namespace Afina {
 namespace Network {
 namespace MTnonblock {
 
-// See Worker.h
-Worker::Worker(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Afina::Logging::Service> pl)
-    : _pStorage(ps), _pLogging(pl), isRunning(false), _epoll_fd(-1) {}
+namespace {
+
+// Connections waiting for adoption per producer
+const std::size_t inbox_size = 1024;
+
+// Load is measured and balanced that often
+const std::chrono::milliseconds window(500);
+
+// Connection migrates only if worker load exceeds the least loaded one by half and by that many
+// events per second, so small fluctuations don't move connections back and forth
+const uint64_t min_imbalance = 1000;
+
+} // namespace
 
 // See Worker.h
-Worker::~Worker() {
-    isRunning = false;
+Worker::Worker(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Afina::Logging::Service> pl,
+               std::size_t producers, Afina::Executor *pool)
+    : _pStorage(ps), _pLogging(pl), isRunning(false), _epoll_fd(-1), _event_fd(-1), _peers(nullptr),
+      _producer(0), _assigned(0), _rate(0), _window_events(0), _pool(pool), _done(nullptr), _in_flight(0) {
+    _inbox.reserve(producers);
+    for (std::size_t i = 0; i < producers; i++) {
+        _inbox.emplace_back(new SpscQueue<Connection *>(inbox_size));
+    }
 }
 
 // See Worker.h
-Worker::Worker(Worker &&other) { *this = std::move(other); }
+Worker::~Worker() {
+    isRunning = false;
 
-// See Worker.h
-Worker &Worker::operator=(Worker &&other) {
-    _pStorage = std::move(other._pStorage);
-    _pLogging = std::move(other._pLogging);
-    _logger = std::move(other._logger);
-    _thread = std::move(other._thread);
-    _epoll_fd = other._epoll_fd;
+    // Connections could be handed over after the thread exited
+    for (auto &queue : _inbox) {
+        Connection *pc;
+        while (queue->pop(pc)) {
+            close(pc->_socket);
+            delete pc;
+        }
+    }
 
-    other._epoll_fd = -1;
-    return *this;
+    if (_event_fd != -1) {
+        close(_event_fd);
+    }
+    if (_epoll_fd != -1) {
+        close(_epoll_fd);
+    }
 }
 
 // See Worker.h
-void Worker::Start(int epoll_fd) {
+void Worker::Start(const std::vector<std::unique_ptr<Worker>> &peers, std::size_t producer) {
     if (isRunning.exchange(true) == false) {
         assert(_epoll_fd == -1);
-        _epoll_fd = epoll_fd;
         _logger = _pLogging->select("network.worker");
+        _peers = &peers;
+        _producer = producer;
+
+        _epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        if (_epoll_fd == -1) {
+            throw std::runtime_error("Failed to create epoll file descriptor: " + std::string(strerror(errno)));
+        }
+
+        _event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (_event_fd == -1) {
+            throw std::runtime_error("Failed to create event file descriptor: " + std::string(strerror(errno)));
+        }
+
+        struct epoll_event event;
+        event.events = EPOLLIN;
+        event.data.ptr = nullptr;
+        if (epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, _event_fd, &event)) {
+            throw std::runtime_error("Failed to add eventfd descriptor to epoll");
+        }
+
         _thread = std::thread(&Worker::OnRun, this);
     }
 }
@@ -57,6 +106,9 @@ void Worker::Start(int epoll_fd) {
 // See Worker.h
 void Worker::Stop() {
     isRunning = false;
+    if (eventfd_write(_event_fd, 1)) {
+        throw std::runtime_error("Failed to wakeup worker");
+    }
 }
 
 // See Worker.h
@@ -65,35 +117,71 @@ void Worker::Join() {
     _thread.join();
 }
 
+// See Worker.h
+bool Worker::Assign(std::size_t producer, Connection *pc) {
+    if (!_inbox[producer]->push(pc)) {
+        return false;
+    }
+
+    // Counted right away, so burst of accepts doesn't go to the same worker
+    _assigned.fetch_add(1, std::memory_order_relaxed);
+    eventfd_write(_event_fd, 1);
+    return true;
+}
+
+// See Worker.h
+uint64_t Worker::Load() const {
+    return _rate.load(std::memory_order_relaxed) + _assigned.load(std::memory_order_relaxed);
+}
+
+// See Worker.h
+Worker *Worker::LeastLoaded(const std::vector<std::unique_ptr<Worker>> &workers) {
+    Worker *result = nullptr;
+    uint64_t result_load = 0;
+    for (auto &w : workers) {
+        uint64_t load = w->Load();
+        if (result == nullptr || load < result_load) {
+            result = w.get();
+            result_load = load;
+        }
+    }
+    return result;
+}
+
 // See Worker.h
 void Worker::OnRun() {
     assert(_epoll_fd >= 0);
     _logger->trace("OnRun");
 
-    // Process connection events
-    //
-    // Do not forget to use EPOLLEXCLUSIVE flag when register socket
-    // for events to avoid thundering herd type behavior.
-    int timeout = -1;
+    // Connections are owned by this thread only, so they are registered once without EPOLLONESHOT and
+    // epoll is touched again only when connection changes what it waits for
     std::array<struct epoll_event, 64> mod_list;
+    _window_start = std::chrono::steady_clock::now();
     while (isRunning) {
-        int nmod = epoll_wait(_epoll_fd, &mod_list[0], mod_list.size(), timeout);
+        int nmod = epoll_wait(_epoll_fd, &mod_list[0], mod_list.size(), window.count());
         _logger->debug("Worker wokeup: {} events", nmod);
 
         for (int i = 0; i < nmod; i++) {
             struct epoll_event &current_event = mod_list[i];
 
-            // nullptr is used by server for event_fd "interface", if we got here then server
-            // signals us to wakeup to process some state change, ignore it in INNER loop, react
-            // on changes in OUTHER loop
+            // nullptr is used for event_fd "interface": either inbox has new connections, batches are
+            // done or worker has to stop, which is checked in OUTER loop
             if (current_event.data.ptr == nullptr) {
+                eventfd_t value;
+                eventfd_read(_event_fd, &value);
+                Adopt();
+                Collect();
                 continue;
             }
 
             // Some connection gets new data
             Connection *pconn = static_cast<Connection *>(current_event.data.ptr);
+            pconn->window_events++;
+            _window_events++;
+
+            uint32_t events = pconn->_event.events;
             if ((current_event.events & EPOLLERR) || (current_event.events & EPOLLHUP)) {
-                std::cerr << "Error from epoll" << std::endl;
+                _logger->error("Error from epoll on descriptor {}", pconn->_socket);
                 pconn->OnError();
             } else if (current_event.events & EPOLLRDHUP) {
                 pconn->OnClose();
@@ -101,45 +189,195 @@ void Worker::OnRun() {
                 // Depends on what connection wants...
                 if (current_event.events & EPOLLIN) {
                     pconn->DoRead();
+                    if (_pool != nullptr && pconn->isAlive()) {
+                        Submit(pconn);
+                    }
                 }
-                if (current_event.events & EPOLLOUT) {
+
+                // Responses to commands just read go out right away by a single writev, most of the time
+                // they fit into the socket
+                if (pconn->isAlive() && ((current_event.events & EPOLLOUT) || !pconn->results_to_write.empty())) {
                     pconn->DoWrite();
                 }
             }
+            Update(pconn, events);
+        }
 
-            // Rearm connection
-            if (pconn->isAlive()) {
-                pconn->_event.events |= EPOLLONESHOT;
-                if (epoll_ctl(_epoll_fd, EPOLL_CTL_MOD, pconn->_socket, &pconn->_event)) {
-                    close(pconn->_socket);
-                    std::cerr << "Could not ctl epoll (worker)" << std::endl;
-                    pconn->OnError();
-                    if (epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, pconn->_socket, &pconn->_event)) {
-                        std::cerr << "Failed to delete connection!" << std::endl;
-                        close(pconn->_socket);
-                        pconn->OnClose();
-                    }
-                    else {
-                        close(pconn->_socket);
-                        pconn->OnClose();
-                    }
-                }
+        if (std::chrono::steady_clock::now() - _window_start >= window) {
+            Rebalance();
+        }
+    }
+
+    // Batches in flight reference their connections, wait for them to be done
+    while (_in_flight > 0) {
+        struct pollfd event = {_event_fd, POLLIN, 0};
+        poll(&event, 1, window.count());
+        eventfd_t value;
+        eventfd_read(_event_fd, &value);
+        Collect();
+    }
+
+    for (Connection *pc : _connections) {
+        close(pc->_socket);
+        delete pc;
+    }
+    _connections.clear();
+    _logger->warn("Worker stopped");
+}
+
+// See Worker.h
+void Worker::Adopt() {
+    for (auto &queue : _inbox) {
+        Connection *pc;
+        while (queue->pop(pc)) {
+            if (epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, pc->_socket, &pc->_event)) {
+                _logger->error("Failed to add connection to epoll: {}", strerror(errno));
+                pc->OnError();
+                close(pc->_socket);
+                delete pc;
+                _assigned.fetch_sub(1, std::memory_order_relaxed);
+                continue;
             }
-            // Or delete closed one
-            else {
-                if (epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, pconn->_socket, &pconn->_event)) {
-                    std::cerr << "Failed to delete connection!" << std::endl;
-                    close(pconn->_socket);
-                    pconn->OnClose();
-                }
-                else {
-                    close(pconn->_socket);
-                    pconn->OnClose();
-                }
+            _connections.insert(pc);
+        }
+    }
+}
+
+// See Worker.h
+void Worker::Rebalance() {
+    auto now = std::chrono::steady_clock::now();
+    uint64_t elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - _window_start).count();
+    elapsed = std::max<uint64_t>(elapsed, 1);
+    _rate.store(_window_events * 1000 / elapsed, std::memory_order_relaxed);
+
+    Worker *target = LeastLoaded(*_peers);
+    uint64_t load = Load(), target_load = target->Load();
+    if (target != this && load > target_load + min_imbalance && 2 * load > 3 * target_load) {
+        // Hottest connection which still leaves this worker at least as loaded as the target
+        uint64_t limit = (load - target_load) / 2;
+        Connection *hottest = nullptr;
+        uint64_t hottest_rate = 0;
+        for (Connection *pc : _connections) {
+            // Batch in flight comes back to this worker
+            uint64_t rate = pc->window_events * 1000 / elapsed;
+            if (rate <= limit && rate > hottest_rate && !pc->in_flight) {
+                hottest = pc;
+                hottest_rate = rate;
+            }
+        }
+
+        if (hottest != nullptr && epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, hottest->_socket, &hottest->_event) == 0) {
+            if (target->Assign(_producer, hottest)) {
+                _logger->debug("Connection on descriptor {} migrated, {} events/s", hottest->_socket,
+                               hottest_rate);
+                _connections.erase(hottest);
+                _assigned.fetch_sub(1, std::memory_order_relaxed);
+                _rate.fetch_sub(hottest_rate, std::memory_order_relaxed);
+            } else if (epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, hottest->_socket, &hottest->_event)) {
+                hottest->OnError();
+                Close(hottest);
             }
         }
     }
-    _logger->warn("Worker stopped");
+
+    for (Connection *pc : _connections) {
+        pc->window_events = 0;
+    }
+    _window_events = 0;
+    _window_start = now;
+}
+
+// See Worker.h
+void Worker::Close(Connection *pc) {
+    // Descriptor is registered in this epoll only, so closing it removes it from epoll as well
+    close(pc->_socket);
+    pc->OnClose();
+    _connections.erase(pc);
+    _assigned.fetch_sub(1, std::memory_order_relaxed);
+
+    // Otherwise it is destroyed once batch is done, see Collect
+    if (!pc->in_flight) {
+        delete pc;
+    }
+}
+
+// See Worker.h
+void Worker::Update(Connection *pc, uint32_t events) {
+    if (pc->isAlive() && pc->_event.events != events &&
+        epoll_ctl(_epoll_fd, EPOLL_CTL_MOD, pc->_socket, &pc->_event)) {
+        _logger->error("Failed to modify connection in epoll: {}", strerror(errno));
+        pc->OnError();
+    }
+    if (!pc->isAlive()) {
+        Close(pc);
+    }
+}
+
+// See Worker.h
+void Worker::Submit(Connection *pc) {
+    if (pc->in_flight || pc->parsed.empty()) {
+        return;
+    }
+
+    // Batch done leaves empty vector behind, so they are just swapped
+    pc->executing.swap(pc->parsed);
+    pc->in_flight = true;
+    _in_flight++;
+    if (!_pool->Execute(&Worker::Process, this, pc)) {
+        // Pool is stopped already
+        Process(pc);
+    }
+}
+
+// See Worker.h
+void Worker::Process(Connection *pc) {
+    pc->DoExecute();
+    Done(pc);
+}
+
+// See Worker.h
+void Worker::Done(Connection *pc) {
+    Connection *head = _done.load(std::memory_order_relaxed);
+    do {
+        pc->next_done = head;
+    } while (!_done.compare_exchange_weak(head, pc, std::memory_order_release, std::memory_order_relaxed));
+
+    // Worker takes the whole list at once, so the list was empty unless worker is about to take it anyway
+    if (head == nullptr) {
+        eventfd_write(_event_fd, 1);
+    }
+}
+
+// See Worker.h
+void Worker::Collect() {
+    Connection *pc = _done.exchange(nullptr, std::memory_order_acquire);
+    while (pc != nullptr) {
+        Connection *next = pc->next_done;
+        pc->in_flight = false;
+        _in_flight--;
+
+        if (!pc->isAlive()) {
+            // Closed while batch was in flight
+            delete pc;
+        } else if (pc->failed) {
+            pc->OnError();
+            Close(pc);
+        } else {
+            uint32_t events = pc->_event.events;
+            for (auto &result : pc->executed) {
+                pc->results_to_write.push(std::move(result));
+            }
+            pc->executed.clear();
+
+            // Socket is most likely writable, so results are sent right away without waiting for epoll
+            pc->DoWrite();
+            if (pc->isAlive()) {
+                Submit(pc);
+            }
+            Update(pc, events);
+        }
+        pc = next;
+    }
 }
 
 } // namespace MTnonblock
@@ -2,8 +2,14 @@
 #define AFINA_NETWORK_MT_NONBLOCKING_WORKER_H
 
 #include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <memory>
+#include <set>
 #include <thread>
+#include <vector>
+
+#include "network/SpscQueue.h"
 
 namespace spdlog {
 class logger;
@@ -13,6 +19,10 @@ namespace Afina {
 
 // Forward declaration, see afina/Storage.h
 class Storage;
+
+// Forward declaration, see afina/Executor.h
+class Executor;
+
 namespace Logging {
 class Service;
 }
@@ -20,25 +30,41 @@ class Service;
 namespace Network {
 namespace MTnonblock {
 
+// Forward declaration, see Connection.h
+class Connection;
+
 /**
  * # Thread running epoll
- * On Start spaws background thread that is doing epoll on the given server
- * socket and process incoming connections and its data
+ * On Start spaws background thread with private epoll instance serving connections handed to the worker.
+ * Connections come through the inbox: one single producer queue per thread which could hand them over,
+ * that is every acceptor and every worker, followed by a poke of the worker event descriptor.
+ *
+ * Worker publishes its load, so acceptors could pick the least loaded one, and once in a while checks
+ * whether it is busier than others. If so, its hottest connection which doesn't reverse the imbalance
+ * migrates to the least loaded worker.
+ *
+ * Given the storage pool, worker runs in pipeline mode: it only parses commands, and once socket is read
+ * out passes commands parsed to the pool as a single batch, so slow command doesn't stall I/O of other
+ * connections. Pool thread returns batch done through the lock free list and pokes the worker event
+ * descriptor, then worker sends results.
  */
 class Worker {
 public:
-    Worker(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Afina::Logging::Service> pl);
+    /**
+     * @param producers number of threads which could hand connections to this worker
+     * @param pool executor to run commands on, nullptr to run them right in the worker thread
+     */
+    Worker(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Afina::Logging::Service> pl,
+           std::size_t producers, Afina::Executor *pool = nullptr);
     ~Worker();
 
-    Worker(Worker &&);
-    Worker &operator=(Worker &&);
-
     /**
-     * Spaws new background thread that is doing epoll on the given server
-     * socket. Once connection accepted it must be registered and being processed
-     * on this thread
+     * Spaws new background thread doing epoll over connections handed to this worker. Worker hands
+     * connections to its peers as producer with the given index
+     *
+     * @throw std::runtime_error if epoll or event descriptor can't be created
      */
-    void Start(int epoll_fd);
+    void Start(const std::vector<std::unique_ptr<Worker>> &peers, std::size_t producer);
 
     /**
      * Signal background thread to stop. After that signal thread must stop to
@@ -54,12 +80,54 @@ public:
      */
     void Join();
 
+    /**
+     * Hands connection to the worker, returns false if inbox of the producer is full. Worker owns
+     * connection once method succeeded
+     *
+     * @param producer index of the calling thread
+     * @param pc Connection
+     */
+    bool Assign(std::size_t producer, Connection *pc);
+
+    /**
+     * Current load: events served per second over the last window plus the number of connections, so
+     * idle connection counts as a single event per second
+     */
+    uint64_t Load() const;
+
+    // Worker with the lowest load
+    static Worker *LeastLoaded(const std::vector<std::unique_ptr<Worker>> &workers);
+
 protected:
     /**
      * Method executing by background thread
      */
     void OnRun();
 
+    // Registers connections from the inbox in epoll
+    void Adopt();
+
+    // Publishes event rate of the window just finished and migrates hot connection if worker is overloaded
+    void Rebalance();
+
+    // Closes and destroys connection
+    void Close(Connection *pc);
+
+    // Applies change of the events connection waits for and closes it if it is dead
+    void Update(Connection *pc, uint32_t events);
+
+    // Passes commands parsed by connection to the storage pool unless connection has batch in flight
+    void Submit(Connection *pc);
+
+    // Executes batch of the connection and returns it to the worker, runs on the storage pool
+    void Process(Connection *pc);
+
+    // Puts connection with batch done to the list, could be called by any thread
+    void Done(Connection *pc);
+
+    // Sends results of batches done and submits commands parsed meanwhile
+    void Collect();
+
 private:
     Worker(Worker &) = delete;
     Worker &operator=(Worker &) = delete;
@@ -81,6 +149,37 @@ private:
 
     // EPOLL descriptor using for events processing
     int _epoll_fd;
+
+    // Descriptor poked once inbox has connections, batches are done or worker has to stop
+    int _event_fd;
+
+    // Connections handed to this worker and not adopted yet, one queue per producer
+    std::vector<std::unique_ptr<SpscQueue<Connection *>>> _inbox;
+
+    // Workers connections could migrate to, including this one
+    const std::vector<std::unique_ptr<Worker>> *_peers;
+    std::size_t _producer;
+
+    // Connections served by this worker
+    std::set<Connection *> _connections;
+
+    // Load published for other threads: connections assigned including not adopted ones, and events per
+    // second over the last window
+    std::atomic<uint64_t> _assigned;
+    std::atomic<uint64_t> _rate;
+
+    // Current window start and number of events served in it
+    std::chrono::steady_clock::time_point _window_start;
+    uint64_t _window_events;
+
+    // Storage pool of the pipeline mode
+    Afina::Executor *_pool;
+
+    // Connections which batches are done, linked through Connection::next_done
+    std::atomic<Connection *> _done;
+
+    // Number of connections with batch in flight, including closed ones
+    std::size_t _in_flight;
 };
 
 } // namespace MTnonblock
@@ -0,0 +1,79 @@
+#include "ServerImpl.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <pthread.h>
+#include <signal.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <spdlog/logger.h>
+
+#include <afina/Storage.h>
+#include <afina/logging/Service.h>
+
+#include "Worker.h"
+
+namespace Afina {
+namespace Network {
+namespace MTreuseport {
+
+// See Server.h
+ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl)
+    : Server(ps, pl), _event_fd(-1) {}
+
+// See Server.h
+ServerImpl::~ServerImpl() {}
+
+// See Server.h
+void ServerImpl::Start(uint16_t port, uint32_t n_acceptors, uint32_t n_workers) {
+    _logger = pLogging->select("network");
+    _logger->info("Start network service");
+
+    sigset_t sig_mask;
+    sigemptyset(&sig_mask);
+    sigaddset(&sig_mask, SIGPIPE);
+    if (pthread_sigmask(SIG_BLOCK, &sig_mask, NULL) != 0) {
+        throw std::runtime_error("Unable to mask SIGPIPE");
+    }
+
+    _event_fd = eventfd(0, EFD_NONBLOCK);
+    if (_event_fd == -1) {
+        throw std::runtime_error("Failed to create event file descriptor: " + std::string(strerror(errno)));
+    }
+
+    _workers.reserve(n_workers);
+    for (uint32_t i = 0; i < n_workers; i++) {
+        _workers.emplace_back(new Worker(pStorage, pLogging, max_pending));
+        _workers.back()->Start(port, _event_fd);
+    }
+}
+
+// See Server.h
+void ServerImpl::Stop() {
+    _logger->warn("Stop network service");
+
+    for (auto &w : _workers) {
+        w->Stop();
+    }
+
+    // Event is never read, so it wakes up every worker epoll
+    if (eventfd_write(_event_fd, 1)) {
+        throw std::runtime_error("Failed to wakeup workers");
+    }
+}
+
+// See Server.h
+void ServerImpl::Join() {
+    for (auto &w : _workers) {
+        w->Join();
+    }
+    _workers.clear();
+    close(_event_fd);
+}
+
+} // namespace MTreuseport
+} // namespace Network
+} // namespace Afina
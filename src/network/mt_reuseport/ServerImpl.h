@@ -0,0 +1,59 @@
+#ifndef AFINA_NETWORK_MT_REUSEPORT_SERVER_H
+#define AFINA_NETWORK_MT_REUSEPORT_SERVER_H
+
+#include <memory>
+#include <vector>
+
+#include <afina/network/Server.h>
+
+namespace spdlog {
+class logger;
+}
+
+namespace Afina {
+namespace Network {
+namespace MTreuseport {
+
+// Forward declaration, see Worker.h
+class Worker;
+
+/**
+ * # Network resource manager implementation
+ * Multi reactor epoll server: every worker thread has its own listening socket bound to the same port
+ * with SO_REUSEPORT, its own epoll instance and owns accepted connections for their whole life. Kernel
+ * spreads incoming connections between listeners, so workers never share descriptors, epoll sets or
+ * connection state and there is no locking or handoff between threads.
+ *
+ * Connections are registered once in edge triggered mode for both reads and writes, so unlike
+ * mt_nonblock there is no epoll_ctl call per event. Every worker accepts, acceptors count is ignored.
+ */
+class ServerImpl : public Server {
+public:
+    ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl);
+    ~ServerImpl();
+
+    // See Server.h
+    void Start(uint16_t port, uint32_t acceptors, uint32_t workers) override;
+
+    // See Server.h
+    void Stop() override;
+
+    // See Server.h
+    void Join() override;
+
+private:
+    // logger to use
+    std::shared_ptr<spdlog::logger> _logger;
+
+    // Curstom event "device" used to wakeup workers, registered in every worker epoll
+    int _event_fd;
+
+    // Reactors, each allocated separately so worker never moves once its thread started
+    std::vector<std::unique_ptr<Worker>> _workers;
+};
+
+} // namespace MTreuseport
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_MT_REUSEPORT_SERVER_H
@@ -0,0 +1,217 @@
+#include "Worker.h"
+
+#include <array>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <spdlog/logger.h>
+
+#include <afina/logging/Service.h>
+
+#include "network/st_nonblocking/Connection.h"
+
+namespace Afina {
+namespace Network {
+namespace MTreuseport {
+
+using STnonblock::Connection;
+
+namespace {
+
+// Connections are registered once for everything they could ever need
+const uint32_t connection_events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+
+} // namespace
+
+// See Worker.h
+Worker::Worker(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Afina::Logging::Service> pl,
+               std::size_t max_pending)
+    : _pStorage(ps), _pLogging(pl), _max_pending(max_pending), isRunning(false), _server_socket(-1),
+      _epoll_fd(-1) {}
+
+// See Worker.h
+Worker::~Worker() {
+    isRunning = false;
+}
+
+// See Worker.h
+void Worker::Start(uint16_t port, int event_fd) {
+    assert(_epoll_fd == -1);
+    _logger = _pLogging->select("network.worker");
+
+    struct sockaddr_in server_addr;
+    std::memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;         // IPv4
+    server_addr.sin_port = htons(port);       // TCP port number
+    server_addr.sin_addr.s_addr = INADDR_ANY; // Bind to any address
+
+    _server_socket = socket(PF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_TCP);
+    if (_server_socket == -1) {
+        throw std::runtime_error("Failed to open socket: " + std::string(strerror(errno)));
+    }
+
+    // Every worker binds the same port, kernel balances connections between listeners
+    int opts = 1;
+    if (setsockopt(_server_socket, SOL_SOCKET, SO_REUSEPORT, &opts, sizeof(opts)) == -1 ||
+        setsockopt(_server_socket, SOL_SOCKET, SO_KEEPALIVE, &opts, sizeof(opts)) == -1) {
+        close(_server_socket);
+        throw std::runtime_error("Socket setsockopt() failed: " + std::string(strerror(errno)));
+    }
+
+    if (bind(_server_socket, (struct sockaddr *)&server_addr, sizeof(server_addr)) == -1) {
+        close(_server_socket);
+        throw std::runtime_error("Socket bind() failed: " + std::string(strerror(errno)));
+    }
+
+    if (listen(_server_socket, SOMAXCONN) == -1) {
+        close(_server_socket);
+        throw std::runtime_error("Socket listen() failed: " + std::string(strerror(errno)));
+    }
+
+    _epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (_epoll_fd == -1) {
+        close(_server_socket);
+        throw std::runtime_error("Failed to create epoll file descriptor: " + std::string(strerror(errno)));
+    }
+
+    // Listener is marked by the worker itself, event descriptor by nullptr
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.ptr = this;
+    if (epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, _server_socket, &event)) {
+        throw std::runtime_error("Failed to add file descriptor to epoll");
+    }
+
+    event.events = EPOLLIN;
+    event.data.ptr = nullptr;
+    if (epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, event_fd, &event)) {
+        throw std::runtime_error("Failed to add eventfd descriptor to epoll");
+    }
+
+    isRunning = true;
+    _thread = std::thread(&Worker::OnRun, this);
+}
+
+// See Worker.h
+void Worker::Stop() {
+    isRunning = false;
+}
+
+// See Worker.h
+void Worker::Join() {
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+}
+
+// See Worker.h
+void Worker::OnRun() {
+    assert(_epoll_fd >= 0);
+    _logger->trace("OnRun");
+
+    std::array<struct epoll_event, 64> mod_list;
+    while (isRunning) {
+        int nmod = epoll_wait(_epoll_fd, &mod_list[0], mod_list.size(), -1);
+        _logger->debug("Worker wokeup: {} events", nmod);
+
+        for (int i = 0; i < nmod; i++) {
+            struct epoll_event &current_event = mod_list[i];
+
+            // Stop signal, checked by the outer loop
+            if (current_event.data.ptr == nullptr) {
+                continue;
+            } else if (current_event.data.ptr == this) {
+                OnNewConnection();
+                continue;
+            }
+
+            // Edge triggered: every call reads or writes until socket would block, so no event is lost
+            Connection *pc = static_cast<Connection *>(current_event.data.ptr);
+            if ((current_event.events & EPOLLERR) || (current_event.events & EPOLLHUP)) {
+                pc->OnError();
+            } else if (current_event.events & EPOLLRDHUP) {
+                pc->OnClose();
+            } else {
+                if (current_event.events & EPOLLIN) {
+                    pc->DoRead();
+                }
+
+                // Responses to just read commands are sent right away, most of them fit into the socket. Once
+                // connection that stopped reading sends enough, it goes on reading as there is no new edge
+                // for the data already in socket
+                if (pc->isAlive() && (current_event.events & (EPOLLIN | EPOLLOUT))) {
+                    pc->DoWrite();
+                    while (pc->isAlive() && pc->throttled && !pc->results_to_write.full()) {
+                        pc->DoRead();
+                        pc->DoWrite();
+                    }
+                }
+            }
+
+            if (!pc->isAlive()) {
+                Close(pc);
+            }
+        }
+    }
+
+    for (Connection *pc : _connections) {
+        close(pc->_socket);
+        delete pc;
+    }
+    _connections.clear();
+
+    close(_server_socket);
+    close(_epoll_fd);
+    _logger->warn("Worker stopped");
+}
+
+// See Worker.h
+void Worker::OnNewConnection() {
+    for (;;) {
+        struct sockaddr in_addr;
+        socklen_t in_len;
+
+        // No need to make these sockets non blocking since accept4() takes care of it.
+        in_len = sizeof in_addr;
+        int infd = accept4(_server_socket, &in_addr, &in_len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (infd == -1) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                _logger->error("Failed to accept socket: {}", strerror(errno));
+            }
+            break;
+        }
+
+        Connection *pc = new Connection(infd, _pStorage, _pLogging, _max_pending);
+        _connections.insert(pc);
+
+        pc->Start();
+        pc->_event.events = connection_events;
+        if (epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, pc->_socket, &pc->_event)) {
+            _logger->error("Failed to add connection to epoll: {}", strerror(errno));
+            pc->OnError();
+            Close(pc);
+        }
+    }
+}
+
+// See Worker.h
+void Worker::Close(Connection *pc) {
+    // Descriptor isn't shared with anyone, so closing it removes it from epoll as well
+    close(pc->_socket);
+    pc->OnClose();
+    _connections.erase(pc);
+    delete pc;
+}
+
+} // namespace MTreuseport
+} // namespace Network
+} // namespace Afina
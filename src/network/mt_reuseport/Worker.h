@@ -0,0 +1,114 @@
+#ifndef AFINA_NETWORK_MT_REUSEPORT_WORKER_H
+#define AFINA_NETWORK_MT_REUSEPORT_WORKER_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <thread>
+
+namespace spdlog {
+class logger;
+}
+
+namespace Afina {
+
+// Forward declaration, see afina/Storage.h
+class Storage;
+namespace Logging {
+class Service;
+}
+
+namespace Network {
+
+// Forward declaration, see st_nonblocking/Connection.h
+namespace STnonblock {
+class Connection;
+} // namespace STnonblock
+
+namespace MTreuseport {
+
+/**
+ * # Reactor thread
+ * Owns listening socket, epoll instance and all connections accepted on that socket. Connections are
+ * served the same way single threaded nonblocking server does, but nothing is ever touched by other
+ * threads besides the stop flag
+ */
+class Worker {
+public:
+    /**
+     * @param max_pending bytes of responses connection could keep unsent before it stops reading
+     */
+    Worker(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Afina::Logging::Service> pl,
+           std::size_t max_pending);
+    ~Worker();
+
+    /**
+     * Opens listening socket on the given port along with the epoll instance and spawns background
+     * thread serving them. Event descriptor wakes thread up on stop
+     *
+     * @throw std::runtime_error if socket or epoll can't be created
+     */
+    void Start(uint16_t port, int event_fd);
+
+    /**
+     * Signal background thread to stop, it must be woken up through the event descriptor afterwards.
+     * Thread closes listening socket and all its connections on exit
+     */
+    void Stop();
+
+    /**
+     * Blocks calling thread until background one for this worker is actually
+     * been destoryed
+     */
+    void Join();
+
+protected:
+    /**
+     * Method executing by background thread
+     */
+    void OnRun();
+
+    // Accepts all pending connections
+    void OnNewConnection();
+
+    // Closes and destroys connection
+    void Close(STnonblock::Connection *pc);
+
+private:
+    Worker(Worker &) = delete;
+    Worker &operator=(Worker &) = delete;
+
+    // afina services
+    std::shared_ptr<Afina::Storage> _pStorage;
+
+    // afina services
+    std::shared_ptr<Afina::Logging::Service> _pLogging;
+
+    // Limit of unsent response bytes per connection
+    std::size_t _max_pending;
+
+    // Logger to be used
+    std::shared_ptr<spdlog::logger> _logger;
+
+    // Flag signals that thread should continue to operate
+    std::atomic<bool> isRunning;
+
+    // Thread serving requests in this worker
+    std::thread _thread;
+
+    // Socket bound to the server port along with listeners of other workers
+    int _server_socket;
+
+    // EPOLL descriptor using for events processing
+    int _epoll_fd;
+
+    // Connections served by this worker
+    std::set<STnonblock::Connection *> _connections;
+};
+
+} // namespace MTreuseport
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_MT_REUSEPORT_WORKER_H
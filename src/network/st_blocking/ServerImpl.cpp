@@ -21,6 +21,7 @@
 #include <afina/execute/Command.h>
 #include <afina/logging/Service.h>
 
+#include "network/OutputQueue.h"
 #include "protocol/Parser.h"
 
 namespace Afina {
@@ -125,10 +126,12 @@ void ServerImpl::OnRun() {
     // - command_to_execute: last command parsed out of stream
     // - arg_remains: how many bytes to read from stream to get command argument
     // - argument_for_command: buffer stores argument
+    // - output: responses not sent yet
     std::size_t arg_remains;
     Protocol::Parser parser;
     std::string argument_for_command;
     std::unique_ptr<Execute::Command> command_to_execute;
+    OutputQueue output(max_pending);
     while (running.load()) {
         _logger->debug("waiting for connection...");
 
@@ -164,7 +167,7 @@ void ServerImpl::OnRun() {
         // Process new connection:
         // - read commands until socket alive
         // - execute each command
-        // - send response
+        // - send responses to all commands of the read at once
         try {
             int readed_bytes = -1;
             char client_buffer[4096];
@@ -216,12 +219,13 @@ void ServerImpl::OnRun() {
                     if (command_to_execute && arg_remains == 0) {
                         _logger->debug("Start command execution");
 
-                        std::string result;
+                        Execute::Response result;
                         command_to_execute->Execute(*pStorage, argument_for_command, result);
+                        result.append("\r\n");
+                        output.push(std::move(result));
 
-                        // Send response
-                        result += "\r\n";
-                        if (send(client_socket, result.data(), result.size(), 0) <= 0) {
+                        // Client reading nothing doesn't make responses pile up
+                        if (output.full() && !output.flush(client_socket)) {
                             throw std::runtime_error("Failed to send response");
                         }
 
@@ -231,6 +235,11 @@ void ServerImpl::OnRun() {
                         parser.Reset();
                     }
                 } // while (readed_bytes)
+
+                // Responses to all commands read go out together
+                if (!output.flush(client_socket)) {
+                    throw std::runtime_error("Failed to send response");
+                }
             }
 
             if (readed_bytes == 0) {
@@ -249,6 +258,7 @@ void ServerImpl::OnRun() {
         command_to_execute.reset();
         argument_for_command.resize(0);
         parser.Reset();
+        output.clear();
     }
 
     // Cleanup on exit...
@@ -0,0 +1,400 @@
+#include "ServerImpl.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include <netinet/in.h>
+#include <signal.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <spdlog/logger.h>
+
+#include <afina/Storage.h>
+#include <afina/execute/Command.h>
+#include <afina/logging/Service.h>
+
+#include "network/ClientBuffer.h"
+#include "network/OutputQueue.h"
+#include "protocol/Parser.h"
+
+namespace Afina {
+namespace Network {
+namespace STcoroutine {
+
+const std::size_t ServerImpl::min_read;
+
+// See Server.h
+ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl)
+    : Server(ps, pl), running(false), _acceptor(-1), _event_fd(-1), _epoll_fd(-1), _engine(nullptr) {}
+
+// See Server.h
+ServerImpl::~ServerImpl() {}
+
+// See Server.h
+void ServerImpl::Start(uint16_t port, uint32_t n_acceptors, uint32_t n_workers) {
+    _logger = pLogging->select("network");
+    _logger->info("Start st_coroutine network service");
+
+    sigset_t sig_mask;
+    sigemptyset(&sig_mask);
+    sigaddset(&sig_mask, SIGPIPE);
+    if (pthread_sigmask(SIG_BLOCK, &sig_mask, NULL) != 0) {
+        throw std::runtime_error("Unable to mask SIGPIPE");
+    }
+
+    struct sockaddr_in server_addr;
+    std::memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;         // IPv4
+    server_addr.sin_port = htons(port);       // TCP port number
+    server_addr.sin_addr.s_addr = INADDR_ANY; // Bind to any address
+
+    int server_socket = socket(PF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_TCP);
+    if (server_socket == -1) {
+        throw std::runtime_error("Failed to open socket: " + std::string(strerror(errno)));
+    }
+
+    int opts = 1;
+    if (setsockopt(server_socket, SOL_SOCKET, SO_REUSEADDR, &opts, sizeof(opts)) == -1 ||
+        setsockopt(server_socket, SOL_SOCKET, SO_KEEPALIVE, &opts, sizeof(opts)) == -1) {
+        close(server_socket);
+        throw std::runtime_error("Socket setsockopt() failed: " + std::string(strerror(errno)));
+    }
+
+    if (bind(server_socket, (struct sockaddr *)&server_addr, sizeof(server_addr)) == -1) {
+        close(server_socket);
+        throw std::runtime_error("Socket bind() failed: " + std::string(strerror(errno)));
+    }
+
+    if (listen(server_socket, SOMAXCONN) == -1) {
+        close(server_socket);
+        throw std::runtime_error("Socket listen() failed: " + std::string(strerror(errno)));
+    }
+
+    _event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (_event_fd == -1) {
+        close(server_socket);
+        throw std::runtime_error("Failed to create event file descriptor: " + std::string(strerror(errno)));
+    }
+
+    _epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (_epoll_fd == -1) {
+        close(_event_fd);
+        close(server_socket);
+        throw std::runtime_error("Failed to create epoll file descriptor: " + std::string(strerror(errno)));
+    }
+
+    // Event is never read, so once stopped server stays woken up
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.ptr = nullptr;
+    if (epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, _event_fd, &event) == -1) {
+        close(_epoll_fd);
+        close(_event_fd);
+        close(server_socket);
+        throw std::runtime_error("Failed to add file descriptor to epoll: " + std::string(strerror(errno)));
+    }
+
+    event.events = EPOLLIN | EPOLLET;
+    event.data.ptr = &_acceptor;
+    if (epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, server_socket, &event) == -1) {
+        close(_epoll_fd);
+        close(_event_fd);
+        close(server_socket);
+        throw std::runtime_error("Failed to add file descriptor to epoll: " + std::string(strerror(errno)));
+    }
+
+    _acceptor.socket = server_socket;
+    running.store(true);
+    _work_thread = std::thread(&ServerImpl::OnRun, this);
+}
+
+// See Server.h
+void ServerImpl::Stop() {
+    _logger->warn("Stop network service");
+    running.store(false);
+
+    // Wakeup thread that sleeps on epoll_wait
+    if (eventfd_write(_event_fd, 1)) {
+        throw std::runtime_error("Failed to wakeup server");
+    }
+}
+
+// See Server.h
+void ServerImpl::Join() {
+    if (_work_thread.joinable()) {
+        _work_thread.join();
+    }
+
+    if (_acceptor.socket != -1) {
+        close(_acceptor.socket);
+        close(_epoll_fd);
+        close(_event_fd);
+        _acceptor.socket = -1;
+    }
+}
+
+// See ServerImpl.h
+void ServerImpl::OnRun() {
+    _logger->info("Start server thread");
+
+    Afina::Coroutine::Engine engine([this]() { Poll(); });
+    _engine = &engine;
+    engine.start(&ServerImpl::Main, *this);
+    _engine = nullptr;
+
+    // Coroutines finish once stop is noticed, so connections are gone by now
+    assert(_connections.empty());
+    _logger->warn("Network stopped");
+}
+
+// See ServerImpl.h
+void ServerImpl::OnAccept() {
+    while (running.load()) {
+        int client_socket = accept4(_acceptor.socket, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (client_socket == -1) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                // Pending connection stays in the queue, it is accepted along with the next one
+                _logger->error("Failed to accept socket: {}", strerror(errno));
+            }
+
+            if (!Wait(&_acceptor, EPOLLIN)) {
+                break;
+            }
+            continue;
+        }
+
+        // Socket stays registered in epoll as long as it is open, so coroutine never registers anything,
+        // it just tells which of the events it waits for
+        Connection *pc = new Connection(client_socket);
+        struct epoll_event event;
+        event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        event.data.ptr = pc;
+        if (epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, client_socket, &event) == -1) {
+            _logger->error("Failed to add connection to epoll: {}", strerror(errno));
+            close(client_socket);
+            delete pc;
+            continue;
+        }
+
+        _connections.insert(pc);
+        pc->routine = _engine->run(&ServerImpl::Serve, *this, pc);
+    }
+    _logger->debug("Acceptor stopped");
+}
+
+// See ServerImpl.h
+void ServerImpl::OnConnection(Connection *pc) {
+    _logger->debug("Connection starts on descriptor {}", pc->socket);
+
+    // Here is connection state, it is just the coroutine stack
+    std::size_t arg_remains = 0;
+    Protocol::Parser parser;
+    std::string argument_for_command;
+    std::unique_ptr<Execute::Command> command_to_execute;
+    std::unique_ptr<Afina::Storage::Reservation> reservation;
+    OutputQueue responses(max_pending);
+    ClientBuffer client_buffer;
+
+    try {
+        while (true) {
+            // Once buffered bytes are consumed, rest of the reserved argument is read right into the storage
+            // memory. Trailing \r\n goes through the buffer as it is usually followed by the next command
+            char *read_ptr;
+            std::size_t read_size;
+            bool direct = reservation && arg_remains > 2;
+            if (direct) {
+                read_ptr = reservation->data() + (reservation->size() + 2 - arg_remains);
+                read_size = arg_remains - 2;
+            } else {
+                client_buffer.reserve(min_read);
+                read_ptr = client_buffer.read_ptr();
+                read_size = client_buffer.read_size();
+            }
+
+            ssize_t read_bytes = read(pc->socket, read_ptr, read_size);
+            if (read_bytes == 0) {
+                _logger->debug("Connection closed");
+                break;
+            } else if (read_bytes < 0) {
+                if (errno == EINTR) {
+                    continue;
+                } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                    throw std::runtime_error(std::string(strerror(errno)));
+                }
+
+                // Nothing to read: responses to everything read so far go out together, then wait for more
+                if (!Send(pc, responses) || !Wait(pc, EPOLLIN | EPOLLRDHUP)) {
+                    break;
+                }
+                continue;
+            }
+            if (direct) {
+                arg_remains -= read_bytes;
+                continue;
+            }
+            client_buffer.read(read_bytes);
+
+            // Single read could finish several commands, parser consumes them right from the buffer
+            while (client_buffer.parse_size() > 0) {
+                if (!command_to_execute) {
+                    std::size_t parsed = 0;
+                    if (parser.Parse(client_buffer.parse_ptr(), client_buffer.parse_size(), parsed)) {
+                        command_to_execute = parser.Build(arg_remains);
+
+                        // Small arguments come along with the command, copying them costs less than the
+                        // extra read needed to put them right into the storage
+                        if (arg_remains >= min_read) {
+                            reservation = command_to_execute->Reserve(*pStorage, arg_remains);
+                        }
+                        if (arg_remains > 0) {
+                            arg_remains += 2;
+                            if (!reservation) {
+                                argument_for_command.reserve(arg_remains);
+                            }
+                        }
+                    }
+
+                    if (parsed == 0) {
+                        break;
+                    }
+                    client_buffer.parsed(parsed);
+                }
+
+                if (command_to_execute && arg_remains > 0) {
+                    std::size_t to_read = std::min(arg_remains, client_buffer.parse_size());
+                    if (reservation) {
+                        std::size_t position = reservation->size() + 2 - arg_remains;
+                        if (position < reservation->size()) {
+                            std::size_t to_copy = std::min(to_read, reservation->size() - position);
+                            std::memcpy(reservation->data() + position, client_buffer.parse_ptr(), to_copy);
+                        }
+                    } else {
+                        argument_for_command.append(client_buffer.parse_ptr(), to_read);
+                    }
+
+                    arg_remains -= to_read;
+                    client_buffer.parsed(to_read);
+                }
+
+                if (command_to_execute && arg_remains == 0) {
+                    Execute::Response response;
+                    if (reservation) {
+                        std::string result;
+                        command_to_execute->Complete(*reservation, result);
+                        response.append(result);
+                        reservation.reset();
+                    } else {
+                        // Argument is followed by \r\n which isn't a part of it
+                        if (argument_for_command.size() >= 2) {
+                            argument_for_command.resize(argument_for_command.size() - 2);
+                        }
+                        command_to_execute->Execute(*pStorage, argument_for_command, response);
+                    }
+                    response.append("\r\n");
+                    responses.push(std::move(response));
+
+                    command_to_execute.reset();
+                    argument_for_command.resize(0);
+                    parser.Reset();
+                }
+            }
+
+            // Client has to take responses before it gets more commands executed
+            if (responses.full() && !Send(pc, responses)) {
+                break;
+            }
+        }
+    } catch (std::runtime_error &ex) {
+        _logger->error("Failed to process connection on descriptor {}: {}", pc->socket, ex.what());
+    }
+
+    // Closed descriptor leaves epoll by itself
+    close(pc->socket);
+    _connections.erase(pc);
+    delete pc;
+}
+
+// See ServerImpl.h
+bool ServerImpl::Send(Connection *pc, OutputQueue &responses) {
+    // Responses keep storage memory they reference alive until they are sent. Queue iovecs live in write
+    // only, so they don't make the stack saved on switch any larger
+    while (!responses.empty()) {
+        if (responses.write(pc->socket) < 0) {
+            if (errno == EINTR) {
+                continue;
+            } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                _logger->error("Failed to send response: {}", strerror(errno));
+                return false;
+            } else if (!Wait(pc, EPOLLOUT)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// See ServerImpl.h
+bool ServerImpl::Wait(Connection *pc, uint32_t events) {
+    if (!running.load()) {
+        return false;
+    }
+
+    pc->waiting = events;
+    _engine->block();
+    pc->waiting = 0;
+    return running.load();
+}
+
+// See ServerImpl.h
+void ServerImpl::Poll() {
+    bool woken = false;
+    while (!woken) {
+        int nevents = epoll_wait(_epoll_fd, &_events[0], _events.size(), -1);
+        if (nevents == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            _logger->error("Server failed: {}", strerror(errno));
+            running.store(false);
+        }
+        _logger->debug("Server wokeup: {} events", nevents);
+
+        for (int i = 0; i < nevents; i++) {
+            Connection *pc = static_cast<Connection *>(_events[i].data.ptr);
+            if (pc == nullptr) {
+                continue;
+            }
+
+            // Edge events come for all socket changes, coroutine is unblocked only by ones it waits for, errors and
+            // hangups always wake it, epoll reports them whether they were asked for or not
+            if (pc->waiting != 0 && ((pc->waiting | EPOLLERR | EPOLLHUP) & _events[i].events)) {
+                _engine->unblock(pc->routine);
+                woken = true;
+            }
+        }
+
+        // Every coroutine is blocked now, once unblocked it sees server is stopping and finishes
+        if (!running.load()) {
+            _engine->unblock(_acceptor.routine);
+            for (Connection *pc : _connections) {
+                _engine->unblock(pc->routine);
+            }
+            return;
+        }
+    }
+}
+
+} // namespace STcoroutine
+} // namespace Network
+} // namespace Afina
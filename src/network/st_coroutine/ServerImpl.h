@@ -0,0 +1,133 @@
+#ifndef AFINA_NETWORK_ST_COROUTINE_SERVER_H
+#define AFINA_NETWORK_ST_COROUTINE_SERVER_H
+
+#include <array>
+#include <atomic>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include <sys/epoll.h>
+
+#include <afina/coroutine/Engine.h>
+#include <afina/network/Server.h>
+
+#include "network/OutputQueue.h"
+
+namespace spdlog {
+class logger;
+}
+
+namespace Afina {
+namespace Network {
+namespace STcoroutine {
+
+/**
+ * # Network resource manager implementation
+ * Single thread server where every connection is served by its own coroutine reading and writing the
+ * socket in a straight line just like st_blocking does. Sockets are non-blocking though: once read or
+ * write would block, coroutine registers what it waits for and blocks itself in the engine, so other
+ * connections get control. When every coroutine is blocked engine runs epoll and unblocks ones whose
+ * sockets got ready.
+ *
+ * Blocked coroutine keeps only the part of stack it actually used, so idle connection costs its read
+ * buffer and a few hundreds bytes of saved stack.
+ */
+class ServerImpl : public Server {
+public:
+    ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl);
+    ~ServerImpl();
+
+    // See Server.h
+    void Start(uint16_t port, uint32_t acceptors, uint32_t workers) override;
+
+    // See Server.h
+    void Stop() override;
+
+    // See Server.h
+    void Join() override;
+
+protected:
+    // Socket served by a coroutine
+    struct Connection {
+        Connection(int s) : socket(s), routine(nullptr), waiting(0) {}
+
+        int socket;
+
+        // Coroutine serving the socket
+        void *routine;
+
+        // Events coroutine is blocked on, zero if it isn't waiting for the socket
+        uint32_t waiting;
+    };
+
+    /**
+     * Method executing by the server thread
+     */
+    void OnRun();
+
+    // Coroutine accepting new connections
+    void OnAccept();
+
+    // Coroutine serving connection
+    void OnConnection(Connection *pc);
+
+    /**
+     * Writes responses out, blocking coroutine while socket is full. Returns false if connection is broken
+     * or server is stopping
+     */
+    bool Send(Connection *pc, OutputQueue &responses);
+
+    /**
+     * Blocks calling coroutine until socket gets some of the events. Returns false if server is stopping
+     */
+    bool Wait(Connection *pc, uint32_t events);
+
+    /**
+     * Engine unblocker: waits for sockets to get ready and unblocks their coroutines
+     */
+    void Poll();
+
+private:
+    // Coroutine entry points, main one just launches acceptor remembering its routine
+    static void Main(ServerImpl &server) {
+        server._acceptor.routine = server._engine->run(&ServerImpl::Accept, server);
+    }
+    static void Accept(ServerImpl &server) { server.OnAccept(); }
+    static void Serve(ServerImpl &server, Connection *pc) { server.OnConnection(pc); }
+
+    // Socket is never read into less space than that
+    static const std::size_t min_read = 4096;
+
+    // logger to use
+    std::shared_ptr<spdlog::logger> _logger;
+
+    // Flag signals that server should continue to operate
+    std::atomic<bool> running;
+
+    // Socket to accept new connections on
+    Connection _acceptor;
+
+    // Curstom event "device" used to wakeup server on stop
+    int _event_fd;
+
+    // EPOLL descriptor waited by the engine unblocker
+    int _epoll_fd;
+
+    // Engine of the server thread, lives on that thread stack
+    Afina::Coroutine::Engine *_engine;
+
+    // IO thread
+    std::thread _work_thread;
+
+    // Connections being served
+    std::set<Connection *> _connections;
+
+    std::array<struct epoll_event, 64> _events;
+};
+
+} // namespace STcoroutine
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_ST_COROUTINE_SERVER_H
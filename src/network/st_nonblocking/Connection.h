@@ -4,15 +4,23 @@
 #include <cstring>
 #include <afina/Storage.h>
 #include <afina/execute/Command.h>
+#include <afina/execute/Response.h>
 #include <afina/logging/Service.h>
 
+#include "network/ClientBuffer.h"
+#include "network/OutputQueue.h"
 #include "protocol/Parser.h"
-#include "ClientBuffer.h"
 
 #include <sys/epoll.h>
 
 namespace Afina {
 namespace Network {
+
+// Forward declaration, see mt_reuseport/Worker.h
+namespace MTreuseport {
+class Worker;
+} // namespace MTreuseport
+
 namespace STnonblock {
 
 class Connection {
@@ -26,15 +34,20 @@ public:
     struct Masks {
         static const int read = ((EPOLLIN | EPOLLRDHUP) | EPOLLERR);
         static const int read_write = (((EPOLLIN | EPOLLRDHUP) | EPOLLERR) | EPOLLOUT);
+        static const int write = ((EPOLLRDHUP | EPOLLERR) | EPOLLOUT);
     };
 
-    Connection(int s, std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl) :
+    /**
+     * @param max_pending bytes of responses connection could keep unsent before it stops reading
+     */
+    Connection(int s, std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl,
+               std::size_t max_pending) :
                 _socket(s),
                 _storage(ps),
-                pLogging(pl) {
+                pLogging(pl),
+                results_to_write(max_pending) {
         std::memset(&_event, 0, sizeof(struct epoll_event));
         _event.data.ptr = this;
-        client_buffer.reset();
     }
 
     inline bool isAlive() const {
@@ -52,9 +65,15 @@ protected:
     void DoRead();
     void DoWrite();
 
+    // Sets events to wait for: reading stops while output queue is full
+    void UpdateEvents();
+
 private:
+    // Socket is never read into less space than that
+    static const std::size_t min_read = 4096;
 
     friend class ServerImpl;
+    friend class MTreuseport::Worker;
 
     int _socket;
     struct epoll_event _event;
@@ -64,11 +83,19 @@ private:
     std::string argument_for_command;
     std::unique_ptr<Execute::Command> command_to_execute;
     std::shared_ptr<Afina::Storage> _storage;
+
+    // Storage memory large argument of the current command is read into, taken after storage so it is
+    // released first
+    std::unique_ptr<Afina::Storage::Reservation> reservation;
     std::shared_ptr<Logging::Service> pLogging;
     std::shared_ptr<spdlog::logger> _logger;
-    std::vector<std::string> results_to_write;
-    STnonblock::ClientBuffer client_buffer;
-    int write_position = 0;
+
+    // Responses not sent yet, they could reference storage memory and keep it alive until sent
+    OutputQueue results_to_write;
+    ClientBuffer client_buffer;
+
+    // Whether connection stopped reading as client doesn't take responses, socket could have data then
+    bool throttled = false;
 };
 
 } // namespace STnonblock
@@ -158,7 +158,10 @@ void ServerImpl::OnRun() {
                 if (current_event.events & EPOLLIN) {
                     pc->DoRead();
                 }
-                if (current_event.events & EPOLLOUT) {
+
+                // Responses to commands just read go out right away by a single writev, most of the time
+                // they fit into the socket
+                if (pc->isAlive() && ((current_event.events & EPOLLOUT) || !pc->results_to_write.empty())) {
                     pc->DoWrite();
                 }
             }
@@ -221,7 +224,7 @@ void ServerImpl::OnNewConnection(int epoll_descr) {
         }
 
         // Register the new FD to be monitored by epoll.
-        Connection *pc = new Connection(infd, pStorage, pLogging);
+        Connection *pc = new Connection(infd, pStorage, pLogging, max_pending);
         if (pc == nullptr) {
             throw std::runtime_error("Failed to allocate connection");
         }
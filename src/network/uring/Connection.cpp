@@ -0,0 +1,168 @@
+#include "Connection.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include <spdlog/logger.h>
+
+#include <afina/Storage.h>
+#include <afina/execute/Command.h>
+#include <afina/logging/Service.h>
+
+#include "protocol/Parser.h"
+
+namespace Afina {
+namespace Network {
+namespace Uring {
+
+const std::size_t Connection::min_reserve;
+const std::size_t Connection::max_iovecs;
+const std::size_t Connection::max_messages;
+
+// See Connection.h
+void Connection::Start() {
+    _logger = pLogging->select("network.connection");
+    _logger->info("Connection starts");
+    state = State::Alive;
+    command_to_execute.reset();
+    reservation.reset();
+    argument_for_command.resize(0);
+    parser.Reset();
+    results_to_write.clear();
+    pausing = false;
+    client_buffer.reset();
+}
+
+// See Connection.h
+void Connection::OnError() {
+    _logger->info("Connection error");
+    // Responses are kept as sends in flight could still reference them
+    this->state = State::Dead;
+}
+
+// See Connection.h
+void Connection::OnClose() {
+    _logger->info("Connection closing");
+    this->state = State::Dead;
+}
+
+// See Connection.h
+void Connection::OnReceive(const char *data, std::size_t size) {
+    _logger->info("Connection reading");
+    try {
+        // Rest of the reserved argument goes right into the storage memory. Trailing \r\n goes through the
+        // buffer as it is usually followed by the next command
+        if (reservation && arg_remains > 2) {
+            std::size_t to_copy = std::min(size, arg_remains - 2);
+            std::memcpy(reservation->data() + (reservation->size() + 2 - arg_remains), data, to_copy);
+            arg_remains -= to_copy;
+            data += to_copy;
+            size -= to_copy;
+        }
+        if (size == 0) {
+            return;
+        }
+
+        client_buffer.reserve(size);
+        std::memcpy(client_buffer.read_ptr(), data, size);
+        client_buffer.read(size);
+
+        // Single receive could finish several commands, parser consumes them right from the buffer
+        while (client_buffer.parse_size() > 0) {
+            if (!command_to_execute) {
+                std::size_t parsed = 0;
+                if (parser.Parse(client_buffer.parse_ptr(), client_buffer.parse_size(), parsed)) {
+                    command_to_execute = parser.Build(arg_remains);
+
+                    // Small arguments come along with the command, copying them costs less than the
+                    // reservation
+                    if (arg_remains >= min_reserve) {
+                        reservation = command_to_execute->Reserve(*_storage, arg_remains);
+                    }
+                    if (arg_remains > 0) {
+                        arg_remains += 2;
+                        if (!reservation) {
+                            argument_for_command.reserve(arg_remains);
+                        }
+                    }
+                }
+
+                if (parsed == 0) {
+                    break;
+                }
+                client_buffer.parsed(parsed);
+            }
+
+            if (command_to_execute && arg_remains > 0) {
+                std::size_t to_read = std::min(arg_remains, client_buffer.parse_size());
+                if (reservation) {
+                    std::size_t position = reservation->size() + 2 - arg_remains;
+                    if (position < reservation->size()) {
+                        std::size_t to_copy = std::min(to_read, reservation->size() - position);
+                        std::memcpy(reservation->data() + position, client_buffer.parse_ptr(), to_copy);
+                    }
+                } else {
+                    argument_for_command.append(client_buffer.parse_ptr(), to_read);
+                }
+
+                arg_remains -= to_read;
+                client_buffer.parsed(to_read);
+            }
+
+            if (command_to_execute && arg_remains == 0) {
+                Execute::Response result_to_write;
+                if (reservation) {
+                    std::string result;
+                    command_to_execute->Complete(*reservation, result);
+                    result_to_write.append(result);
+                    reservation.reset();
+                } else {
+                    // Argument is followed by \r\n which isn't a part of it
+                    if (argument_for_command.size() >= 2) {
+                        argument_for_command.resize(argument_for_command.size() - 2);
+                    }
+                    command_to_execute->Execute(*_storage, argument_for_command, result_to_write);
+                }
+                result_to_write.append("\r\n");
+                results_to_write.push(std::move(result_to_write));
+
+                command_to_execute.reset();
+                argument_for_command.resize(0);
+                parser.Reset();
+            }
+        }
+    } catch (std::runtime_error &ex) {
+        _logger->error("Failed to process connection on descriptor {}: {}", _socket, ex.what());
+        state = State::Dead;
+    }
+}
+
+// See Connection.h
+std::size_t Connection::PrepareSend() {
+    // Values referenced by responses go to the socket right from the storage memory
+    std::size_t count = 0, offset = 0;
+    while (count < max_messages && offset < results_to_write.size()) {
+        struct iovec *iov = iovecs[count];
+        std::size_t used = results_to_write.gather(offset, iov, max_iovecs);
+        for (std::size_t i = 0; i < used; i++) {
+            offset += iov[i].iov_len;
+        }
+
+        std::memset(&messages[count], 0, sizeof(messages[count]));
+        messages[count].msg_iov = iov;
+        messages[count].msg_iovlen = used;
+        count++;
+    }
+    return count;
+}
+
+// See Connection.h
+void Connection::OnSent(std::size_t sent) {
+    _logger->info("Connection writing");
+    results_to_write.sent(sent);
+}
+
+} // namespace Uring
+} // namespace Network
+} // namespace Afina
@@ -0,0 +1,113 @@
+#ifndef AFINA_NETWORK_URING_CONNECTION_H
+#define AFINA_NETWORK_URING_CONNECTION_H
+
+#include <cstring>
+#include <afina/Storage.h>
+#include <afina/execute/Command.h>
+#include <afina/execute/Response.h>
+#include <afina/logging/Service.h>
+
+#include "network/ClientBuffer.h"
+#include "network/OutputQueue.h"
+#include "protocol/Parser.h"
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+namespace Afina {
+namespace Network {
+namespace Uring {
+
+/**
+ * # Connection served through io_uring
+ * Connection does no syscalls itself: worker hands it bytes received by the ring and submits the
+ * messages it prepares. Everything submitted must stay in place until the kernel completes it, so
+ * responses are queued in the output queue which never moves them, and messages live in the connection.
+ */
+class Connection {
+public:
+    enum class State {
+        Embryo,
+        Alive,
+        Dead
+    };
+
+    /**
+     * @param max_pending bytes of responses connection could keep unsent before it stops receiving
+     */
+    Connection(int s, std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl,
+               std::size_t max_pending) :
+                _socket(s),
+                _storage(ps),
+                pLogging(pl),
+                results_to_write(max_pending) {}
+
+    inline bool isAlive() const {
+        if (state == State::Alive) {
+            return true;
+        }
+        return false;
+    }
+
+    void Start();
+
+protected:
+    void OnError();
+    void OnClose();
+
+    // Parses and executes commands from the received bytes, responses are queued for sending
+    void OnReceive(const char *data, std::size_t size);
+
+    // Fills messages with queued responses, returns number of messages to be sent in order
+    std::size_t PrepareSend();
+
+    // Drops bytes sent by the kernel from the queue
+    void OnSent(std::size_t sent);
+
+private:
+    // Arguments of at least that size are received right into the storage
+    static const std::size_t min_reserve = 4096;
+
+    // Number of response segments in a single message
+    static const std::size_t max_iovecs = OutputQueue::max_iovecs;
+
+    // Number of messages linked together by a single PrepareSend
+    static const std::size_t max_messages = 4;
+
+    friend class Worker;
+
+    int _socket;
+    State state = State::Embryo;
+    std::size_t arg_remains;
+    Protocol::Parser parser;
+    std::string argument_for_command;
+    std::unique_ptr<Execute::Command> command_to_execute;
+    std::shared_ptr<Afina::Storage> _storage;
+
+    // Storage memory large argument of the current command is received into, taken after storage so it
+    // is released first
+    std::unique_ptr<Afina::Storage::Reservation> reservation;
+    std::shared_ptr<Logging::Service> pLogging;
+    std::shared_ptr<spdlog::logger> _logger;
+
+    // Responses not sent yet, they could reference storage memory and keep it alive until sent
+    OutputQueue results_to_write;
+    ClientBuffer client_buffer;
+
+    // Operations submitted and not completed yet, connection is destroyed only once there are none
+    bool receiving = false;
+    std::size_t sending = 0;
+
+    // Whether receive is being cancelled as client doesn't take responses
+    bool pausing = false;
+
+    // Messages of the send operations in flight
+    struct msghdr messages[max_messages];
+    struct iovec iovecs[max_messages][max_iovecs];
+};
+
+} // namespace Uring
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_URING_CONNECTION_H
@@ -0,0 +1,235 @@
+#include "Ring.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace Afina {
+namespace Network {
+namespace Uring {
+
+namespace {
+
+int io_uring_setup(unsigned entries, struct io_uring_params *params) {
+    return int(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return int(syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+int io_uring_register(int fd, unsigned opcode, void *arg, unsigned nr_args) {
+    return int(syscall(__NR_io_uring_register, fd, opcode, arg, nr_args));
+}
+
+template <typename T> T *offset_of(void *base, uint32_t offset) {
+    return reinterpret_cast<T *>(static_cast<char *>(base) + offset);
+}
+
+} // namespace
+
+// See Ring.h
+Ring::Ring(unsigned entries) : _sq_ring(MAP_FAILED), _cq_ring(MAP_FAILED), _sq_local_tail(0) {
+    std::memset(&_params, 0, sizeof(_params));
+    _params.flags =
+        IORING_SETUP_CQSIZE | IORING_SETUP_R_DISABLED | IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_DEFER_TASKRUN;
+    _params.cq_entries = entries * 4;
+
+    _fd = io_uring_setup(entries, &_params);
+    if (_fd == -1) {
+        throw std::runtime_error("io_uring_setup() failed: " + std::string(strerror(errno)));
+    }
+
+    _sq_ring_size = _params.sq_off.array + _params.sq_entries * sizeof(unsigned);
+    _cq_ring_size = _params.cq_off.cqes + _params.cq_entries * sizeof(struct io_uring_cqe);
+    if (_params.features & IORING_FEAT_SINGLE_MMAP) {
+        _sq_ring_size = _cq_ring_size = std::max(_sq_ring_size, _cq_ring_size);
+    }
+
+    _sq_ring = mmap(nullptr, _sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd,
+                    IORING_OFF_SQ_RING);
+    if (_sq_ring != MAP_FAILED && (_params.features & IORING_FEAT_SINGLE_MMAP)) {
+        _cq_ring = _sq_ring;
+    } else if (_sq_ring != MAP_FAILED) {
+        _cq_ring = mmap(nullptr, _cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd,
+                        IORING_OFF_CQ_RING);
+    }
+
+    void *sqes = MAP_FAILED;
+    if (_cq_ring != MAP_FAILED) {
+        sqes = mmap(nullptr, _params.sq_entries * sizeof(struct io_uring_sqe), PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_SQES);
+    }
+    if (sqes == MAP_FAILED) {
+        int error = errno;
+        if (_cq_ring != MAP_FAILED && _cq_ring != _sq_ring) {
+            munmap(_cq_ring, _cq_ring_size);
+        }
+        if (_sq_ring != MAP_FAILED) {
+            munmap(_sq_ring, _sq_ring_size);
+        }
+        close(_fd);
+        throw std::runtime_error("Failed to map io_uring queues: " + std::string(strerror(error)));
+    }
+    _sqes = static_cast<struct io_uring_sqe *>(sqes);
+
+    _sq_head = offset_of<unsigned>(_sq_ring, _params.sq_off.head);
+    _sq_tail = offset_of<unsigned>(_sq_ring, _params.sq_off.tail);
+    _sq_mask = *offset_of<unsigned>(_sq_ring, _params.sq_off.ring_mask);
+    _sq_array = offset_of<unsigned>(_sq_ring, _params.sq_off.array);
+    _sq_local_tail = *_sq_tail;
+
+    _cq_head = offset_of<unsigned>(_cq_ring, _params.cq_off.head);
+    _cq_tail = offset_of<unsigned>(_cq_ring, _params.cq_off.tail);
+    _cq_mask = *offset_of<unsigned>(_cq_ring, _params.cq_off.ring_mask);
+    _cqes = offset_of<struct io_uring_cqe>(_cq_ring, _params.cq_off.cqes);
+}
+
+// See Ring.h
+Ring::~Ring() {
+    munmap(_sqes, _params.sq_entries * sizeof(struct io_uring_sqe));
+    if (_cq_ring != _sq_ring) {
+        munmap(_cq_ring, _cq_ring_size);
+    }
+    munmap(_sq_ring, _sq_ring_size);
+    close(_fd);
+}
+
+// See Ring.h
+bool Ring::Supported() {
+    try {
+        Ring ring(8);
+
+        std::vector<char> memory(sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op));
+        struct io_uring_probe *probe = reinterpret_cast<struct io_uring_probe *>(&memory[0]);
+        if (io_uring_register(ring.fd(), IORING_REGISTER_PROBE, probe, 256) == -1) {
+            return false;
+        }
+
+        // There is no way to probe operation flags, but multishot recv came along with zero copy send
+        // and both provided buffer rings and multishot accept are older. Ring setup flags are checked by
+        // the ring creation above
+        return probe->last_op >= IORING_OP_SEND_ZC;
+    } catch (std::runtime_error &) {
+        return false;
+    }
+}
+
+// See Ring.h
+void Ring::enable() {
+    if (io_uring_register(_fd, IORING_REGISTER_ENABLE_RINGS, nullptr, 0) == -1) {
+        throw std::runtime_error("Failed to enable io_uring: " + std::string(strerror(errno)));
+    }
+}
+
+// See Ring.h
+struct io_uring_sqe *Ring::get_sqe() {
+    reserve(1);
+
+    unsigned index = _sq_local_tail & _sq_mask;
+    _sq_array[index] = index;
+    _sq_local_tail++;
+
+    struct io_uring_sqe *sqe = &_sqes[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+    return sqe;
+}
+
+// See Ring.h
+void Ring::reserve(unsigned count) {
+    while (_sq_local_tail - __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE) + count > _params.sq_entries) {
+        enter(0);
+    }
+}
+
+// See Ring.h
+bool Ring::enter(unsigned wait_nr) {
+    unsigned to_submit = _sq_local_tail - *_sq_tail;
+    __atomic_store_n(_sq_tail, _sq_local_tail, __ATOMIC_RELEASE);
+
+    unsigned flags = wait_nr > 0 ? IORING_ENTER_GETEVENTS : 0;
+    while (io_uring_enter(_fd, to_submit, wait_nr, flags) == -1) {
+        if (errno == EBUSY || errno == EAGAIN) {
+            return false;
+        } else if (errno != EINTR) {
+            throw std::runtime_error("io_uring_enter() failed: " + std::string(strerror(errno)));
+        }
+
+        // Entries were consumed by the interrupted call, only waiting has to be repeated
+        to_submit = _sq_local_tail - __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE);
+    }
+    return true;
+}
+
+// See Ring.h
+struct io_uring_cqe *Ring::peek() {
+    unsigned head = *_cq_head;
+    if (head == __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE)) {
+        return nullptr;
+    }
+    return &_cqes[head & _cq_mask];
+}
+
+// See Ring.h
+void Ring::advance() {
+    __atomic_store_n(_cq_head, *_cq_head + 1, __ATOMIC_RELEASE);
+}
+
+// See Ring.h
+BufferRing::BufferRing(Ring &ring, uint16_t group, unsigned count, unsigned size)
+    : _ring(ring), _group(group), _count(count), _size(size), _tail(0),
+      _buffers(new char[std::size_t(count) * size]) {
+    // Descriptors have to be page aligned, anonymous mapping is
+    void *descriptors = mmap(nullptr, count * sizeof(struct io_uring_buf), PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (descriptors == MAP_FAILED) {
+        throw std::runtime_error("Failed to map buffer ring: " + std::string(strerror(errno)));
+    }
+    _descriptors = static_cast<struct io_uring_buf *>(descriptors);
+
+    struct io_uring_buf_reg reg;
+    std::memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = reinterpret_cast<uint64_t>(_descriptors);
+    reg.ring_entries = count;
+    reg.bgid = group;
+    if (io_uring_register(_ring.fd(), IORING_REGISTER_PBUF_RING, &reg, 1) == -1) {
+        int error = errno;
+        munmap(_descriptors, count * sizeof(struct io_uring_buf));
+        throw std::runtime_error("Failed to register buffer ring: " + std::string(strerror(error)));
+    }
+
+    for (unsigned id = 0; id < count; id++) {
+        recycle(uint16_t(id));
+    }
+}
+
+// See Ring.h
+BufferRing::~BufferRing() {
+    struct io_uring_buf_reg reg;
+    std::memset(&reg, 0, sizeof(reg));
+    reg.bgid = _group;
+    io_uring_register(_ring.fd(), IORING_UNREGISTER_PBUF_RING, &reg, 1);
+    munmap(_descriptors, _count * sizeof(struct io_uring_buf));
+}
+
+// See Ring.h
+void BufferRing::recycle(uint16_t id) {
+    // Tail overlays reserved field of the first descriptor, so it is written only once descriptor is ready
+    struct io_uring_buf &buf = _descriptors[_tail & (_count - 1)];
+    buf.addr = reinterpret_cast<uint64_t>(buffer(id));
+    buf.len = _size;
+    buf.bid = id;
+    _tail++;
+    __atomic_store_n(&_descriptors[0].resv, _tail, __ATOMIC_RELEASE);
+}
+
+} // namespace Uring
+} // namespace Network
+} // namespace Afina
@@ -0,0 +1,149 @@
+#ifndef AFINA_NETWORK_URING_RING_H
+#define AFINA_NETWORK_URING_RING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include <linux/io_uring.h>
+
+namespace Afina {
+namespace Network {
+namespace Uring {
+
+/**
+ * # io_uring instance
+ * Thin wrapper over raw io_uring syscalls, so there is no dependency on liburing. Submission entries are
+ * filled right in the shared submission queue and handed to the kernel in batches by enter(), completions
+ * are consumed right from the shared completion queue.
+ *
+ * Instance isn't thread safe, it is meant to be used by a single thread.
+ */
+class Ring {
+public:
+    /**
+     * Creates disabled ring with the given number of submission entries and 4 times more completion
+     * entries. Buffers could be registered right away, but operations are accepted only after enable()
+     *
+     * @throw std::runtime_error if kernel refuses to set up the ring
+     */
+    Ring(unsigned entries);
+    ~Ring();
+
+    /**
+     * True if kernel supports everything network backend relies on: multishot accept and recv along with
+     * provided buffer rings
+     */
+    static bool Supported();
+
+    /**
+     * Enables the ring, the calling thread becomes the only one allowed to submit. Completions are posted
+     * only while that thread waits for them in enter(), so they never interrupt request processing
+     */
+    void enable();
+
+    /**
+     * Zeroed entry to fill, it is submitted on the next enter(). If queue is full, pending entries are
+     * submitted right away to make room
+     */
+    struct io_uring_sqe *get_sqe();
+
+    /**
+     * Makes sure next count get_sqe() calls submit nothing, so linked entries reach the kernel together
+     */
+    void reserve(unsigned count);
+
+    /**
+     * Submits pending entries and blocks until at least wait_nr completions are available. Returns false
+     * if completion queue is overflown and some completions have to be consumed first
+     *
+     * @throw std::runtime_error on unexpected io_uring_enter failure
+     */
+    bool enter(unsigned wait_nr);
+
+    // Oldest completion not consumed yet, nullptr if there is none
+    struct io_uring_cqe *peek();
+
+    // Consumes completion returned by peek(), entry must not be used afterwards
+    void advance();
+
+    // Ring descriptor for registrations
+    int fd() const { return _fd; }
+
+private:
+    Ring(const Ring &) = delete;
+    Ring &operator=(const Ring &) = delete;
+
+    int _fd;
+    struct io_uring_params _params;
+
+    // Shared mappings, completion queue shares the first one if kernel supports single mmap
+    void *_sq_ring;
+    std::size_t _sq_ring_size;
+    void *_cq_ring;
+    std::size_t _cq_ring_size;
+    struct io_uring_sqe *_sqes;
+
+    // Submission queue fields
+    unsigned *_sq_head;
+    unsigned *_sq_tail;
+    unsigned _sq_mask;
+    unsigned *_sq_array;
+
+    // Tail of the filled entries, published to the kernel by enter()
+    unsigned _sq_local_tail;
+
+    // Completion queue fields
+    unsigned *_cq_head;
+    unsigned *_cq_tail;
+    unsigned _cq_mask;
+    struct io_uring_cqe *_cqes;
+};
+
+/**
+ * # Provided buffer ring
+ * Group of equally sized buffers registered in the ring. Receive operations marked with the group take
+ * buffer from it at the moment data arrives, so idle connections don't hold any receive memory. Buffer
+ * must be recycled once completion data is consumed.
+ */
+class BufferRing {
+public:
+    /**
+     * Registers count buffers of size bytes each, count must be power of 2
+     *
+     * @throw std::runtime_error if kernel refuses registration
+     */
+    BufferRing(Ring &ring, uint16_t group, unsigned count, unsigned size);
+    ~BufferRing();
+
+    // Group to put into submission entry
+    uint16_t group() const { return _group; }
+
+    // Buffer with the given id, as reported by the completion flags
+    char *buffer(uint16_t id) { return _buffers.get() + std::size_t(id) * _size; }
+
+    // Gives buffer back to the kernel
+    void recycle(uint16_t id);
+
+private:
+    BufferRing(const BufferRing &) = delete;
+    BufferRing &operator=(const BufferRing &) = delete;
+
+    Ring &_ring;
+    const uint16_t _group;
+    const unsigned _count;
+    const unsigned _size;
+
+    // Ring of buffer descriptors shared with the kernel. It is struct io_uring_buf_ring, but its flexible
+    // array is declared in a way which doesn't keep layout in C++, so descriptors are addressed directly
+    struct io_uring_buf *_descriptors;
+    uint16_t _tail;
+
+    std::unique_ptr<char[]> _buffers;
+};
+
+} // namespace Uring
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_URING_RING_H
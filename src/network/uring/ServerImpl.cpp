@@ -0,0 +1,97 @@
+#include "ServerImpl.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <pthread.h>
+#include <signal.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <spdlog/logger.h>
+
+#include <afina/Storage.h>
+#include <afina/logging/Service.h>
+
+#include "Ring.h"
+#include "Worker.h"
+#include "network/mt_reuseport/ServerImpl.h"
+
+namespace Afina {
+namespace Network {
+namespace Uring {
+
+// See Server.h
+ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl)
+    : Server(ps, pl), _event_fd(-1) {}
+
+// See Server.h
+ServerImpl::~ServerImpl() {}
+
+// See Server.h
+void ServerImpl::Start(uint16_t port, uint32_t n_acceptors, uint32_t n_workers) {
+    _logger = pLogging->select("network");
+    if (!Ring::Supported()) {
+        _logger->warn("io_uring is not supported by the kernel, falling back to epoll");
+        _fallback.reset(new MTreuseport::ServerImpl(pStorage, pLogging));
+        _fallback->SetMaxPending(max_pending);
+        _fallback->Start(port, n_acceptors, n_workers);
+        return;
+    }
+    _logger->info("Start network service");
+
+    sigset_t sig_mask;
+    sigemptyset(&sig_mask);
+    sigaddset(&sig_mask, SIGPIPE);
+    if (pthread_sigmask(SIG_BLOCK, &sig_mask, NULL) != 0) {
+        throw std::runtime_error("Unable to mask SIGPIPE");
+    }
+
+    _event_fd = eventfd(0, EFD_NONBLOCK);
+    if (_event_fd == -1) {
+        throw std::runtime_error("Failed to create event file descriptor: " + std::string(strerror(errno)));
+    }
+
+    _workers.reserve(n_workers);
+    for (uint32_t i = 0; i < n_workers; i++) {
+        _workers.emplace_back(new Worker(pStorage, pLogging, max_pending));
+        _workers.back()->Start(port, _event_fd);
+    }
+}
+
+// See Server.h
+void ServerImpl::Stop() {
+    if (_fallback) {
+        _fallback->Stop();
+        return;
+    }
+    _logger->warn("Stop network service");
+
+    for (auto &w : _workers) {
+        w->Stop();
+    }
+
+    // Event is never read, so it completes poll of every worker
+    if (eventfd_write(_event_fd, 1)) {
+        throw std::runtime_error("Failed to wakeup workers");
+    }
+}
+
+// See Server.h
+void ServerImpl::Join() {
+    if (_fallback) {
+        _fallback->Join();
+        return;
+    }
+
+    for (auto &w : _workers) {
+        w->Join();
+    }
+    _workers.clear();
+    close(_event_fd);
+}
+
+} // namespace Uring
+} // namespace Network
+} // namespace Afina
@@ -0,0 +1,63 @@
+#ifndef AFINA_NETWORK_URING_SERVER_H
+#define AFINA_NETWORK_URING_SERVER_H
+
+#include <memory>
+#include <vector>
+
+#include <afina/network/Server.h>
+
+namespace spdlog {
+class logger;
+}
+
+namespace Afina {
+namespace Network {
+namespace Uring {
+
+// Forward declaration, see Worker.h
+class Worker;
+
+/**
+ * # Network resource manager implementation
+ * Multi reactor server over io_uring: every worker thread has its own listening socket bound to the same
+ * port with SO_REUSEPORT and its own ring. Accepts and receives are multishot, so they are submitted once
+ * per listener and connection rather than once per event, receive buffers are provided by the ring and
+ * responses are sent by linked sendmsg. Worker does a single io_uring_enter per loop iteration, which
+ * both submits new operations and waits for completions.
+ *
+ * Kernel without multishot receive (before 6.0) or with io_uring disabled gets reuseport epoll server
+ * instead. Every worker accepts, acceptors count is ignored.
+ */
+class ServerImpl : public Server {
+public:
+    ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl);
+    ~ServerImpl();
+
+    // See Server.h
+    void Start(uint16_t port, uint32_t acceptors, uint32_t workers) override;
+
+    // See Server.h
+    void Stop() override;
+
+    // See Server.h
+    void Join() override;
+
+private:
+    // logger to use
+    std::shared_ptr<spdlog::logger> _logger;
+
+    // Curstom event "device" used to wakeup workers, polled by every worker ring
+    int _event_fd;
+
+    // Reactors, each allocated separately so worker never moves once its thread started
+    std::vector<std::unique_ptr<Worker>> _workers;
+
+    // Server doing the job if kernel lacks io_uring features
+    std::unique_ptr<Server> _fallback;
+};
+
+} // namespace Uring
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_URING_SERVER_H
@@ -0,0 +1,361 @@
+#include "Worker.h"
+
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <spdlog/logger.h>
+
+#include <afina/logging/Service.h>
+
+#include "Connection.h"
+#include "Ring.h"
+
+namespace Afina {
+namespace Network {
+namespace Uring {
+
+namespace {
+
+// Ring sizes: submission entries, and receive buffers shared by all connections of the worker
+const unsigned ring_entries = 1024;
+const unsigned buffer_count = 512;
+const unsigned buffer_size = 4096;
+
+// Completion user data is the pointer to the worker or connection with the operation in lower bits
+enum Operation : uint64_t { accept_op = 0, receive_op = 1, send_op = 2, other_op = 3 };
+const uint64_t operation_mask = 3;
+
+template <typename T> uint64_t user_data(T *p, Operation op) {
+    return reinterpret_cast<uint64_t>(p) | op;
+}
+
+} // namespace
+
+// See Worker.h
+Worker::Worker(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Afina::Logging::Service> pl,
+               std::size_t max_pending)
+    : _pStorage(ps), _pLogging(pl), _max_pending(max_pending), isRunning(false), _server_socket(-1),
+      _event_fd(-1), _accepting(false) {}
+
+// See Worker.h
+Worker::~Worker() {
+    isRunning = false;
+}
+
+// See Worker.h
+void Worker::Start(uint16_t port, int event_fd) {
+    assert(!_ring);
+    _logger = _pLogging->select("network.worker");
+
+    struct sockaddr_in server_addr;
+    std::memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;         // IPv4
+    server_addr.sin_port = htons(port);       // TCP port number
+    server_addr.sin_addr.s_addr = INADDR_ANY; // Bind to any address
+
+    _server_socket = socket(PF_INET, SOCK_STREAM | SOCK_CLOEXEC, IPPROTO_TCP);
+    if (_server_socket == -1) {
+        throw std::runtime_error("Failed to open socket: " + std::string(strerror(errno)));
+    }
+
+    // Every worker binds the same port, kernel balances connections between listeners
+    int opts = 1;
+    if (setsockopt(_server_socket, SOL_SOCKET, SO_REUSEPORT, &opts, sizeof(opts)) == -1 ||
+        setsockopt(_server_socket, SOL_SOCKET, SO_KEEPALIVE, &opts, sizeof(opts)) == -1) {
+        close(_server_socket);
+        throw std::runtime_error("Socket setsockopt() failed: " + std::string(strerror(errno)));
+    }
+
+    if (bind(_server_socket, (struct sockaddr *)&server_addr, sizeof(server_addr)) == -1) {
+        close(_server_socket);
+        throw std::runtime_error("Socket bind() failed: " + std::string(strerror(errno)));
+    }
+
+    if (listen(_server_socket, SOMAXCONN) == -1) {
+        close(_server_socket);
+        throw std::runtime_error("Socket listen() failed: " + std::string(strerror(errno)));
+    }
+
+    try {
+        _ring.reset(new Ring(ring_entries));
+        _buffers.reset(new BufferRing(*_ring, 0, buffer_count, buffer_size));
+    } catch (std::runtime_error &) {
+        _ring.reset();
+        close(_server_socket);
+        throw;
+    }
+
+    _event_fd = event_fd;
+    isRunning = true;
+    _thread = std::thread(&Worker::OnRun, this);
+}
+
+// See Worker.h
+void Worker::Stop() {
+    isRunning = false;
+}
+
+// See Worker.h
+void Worker::Join() {
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+}
+
+// See Worker.h
+void Worker::OnRun() {
+    assert(_ring);
+    _logger->trace("OnRun");
+
+    try {
+        _ring->enable();
+    } catch (std::runtime_error &ex) {
+        _logger->error("Worker failed: {}", ex.what());
+        _buffers.reset();
+        _ring.reset();
+        close(_server_socket);
+        return;
+    }
+    Accept();
+
+    // Event is never read, so poll completes in every worker
+    struct io_uring_sqe *sqe = _ring->get_sqe();
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = _event_fd;
+    sqe->poll32_events = POLLIN;
+    sqe->user_data = user_data<Worker>(nullptr, other_op);
+
+    // Once stopped, worker lives until every operation it submitted is completed, as kernel could still
+    // access connection memory
+    bool stopping = false;
+    while (!stopping || _accepting || !_connections.empty()) {
+        _ring->enter(1);
+
+        std::size_t ncompleted = 0;
+        for (struct io_uring_cqe *cqe = _ring->peek(); cqe != nullptr; cqe = _ring->peek()) {
+            uint64_t data = cqe->user_data;
+            int32_t res = cqe->res;
+            uint32_t flags = cqe->flags;
+            _ring->advance();
+            ncompleted++;
+
+            Connection *pc = reinterpret_cast<Connection *>(data & ~operation_mask);
+            switch (data & operation_mask) {
+            case accept_op:
+                OnAccept(res, flags);
+                break;
+            case receive_op:
+                OnReceive(pc, res, flags);
+                break;
+            case send_op:
+                OnSend(pc, res);
+                break;
+            default:
+                break;
+            }
+        }
+        _logger->debug("Worker wokeup: {} completions", ncompleted);
+
+        if (!isRunning && !stopping) {
+            stopping = true;
+
+            sqe = _ring->get_sqe();
+            sqe->opcode = IORING_OP_ASYNC_CANCEL;
+            sqe->addr = user_data(this, accept_op);
+            sqe->user_data = user_data<Worker>(nullptr, other_op);
+
+            // Pending receives complete with end of stream, pending sends with an error
+            for (Connection *pc : _connections) {
+                pc->OnClose();
+                shutdown(pc->_socket, SHUT_RDWR);
+            }
+        }
+    }
+
+    _buffers.reset();
+    _ring.reset();
+    close(_server_socket);
+    _logger->warn("Worker stopped");
+}
+
+// See Worker.h
+void Worker::Accept() {
+    struct io_uring_sqe *sqe = _ring->get_sqe();
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = _server_socket;
+    sqe->accept_flags = SOCK_CLOEXEC;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->user_data = user_data(this, accept_op);
+    _accepting = true;
+}
+
+// See Worker.h
+void Worker::Receive(Connection *pc) {
+    struct io_uring_sqe *sqe = _ring->get_sqe();
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = pc->_socket;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = _buffers->group();
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->user_data = user_data(pc, receive_op);
+    pc->receiving = true;
+}
+
+// See Worker.h
+void Worker::Send(Connection *pc) {
+    if (pc->sending > 0) {
+        return;
+    }
+
+    std::size_t count = pc->PrepareSend();
+    _ring->reserve(count);
+    for (std::size_t i = 0; i < count; i++) {
+        // Message of a single segment, which is typical for small values, is sent by plain send as it
+        // needs no iovec import
+        struct io_uring_sqe *sqe = _ring->get_sqe();
+        struct msghdr &message = pc->messages[i];
+        if (message.msg_iovlen == 1) {
+            sqe->opcode = IORING_OP_SEND;
+            sqe->addr = reinterpret_cast<uint64_t>(message.msg_iov[0].iov_base);
+            sqe->len = message.msg_iov[0].iov_len;
+        } else {
+            sqe->opcode = IORING_OP_SENDMSG;
+            sqe->addr = reinterpret_cast<uint64_t>(&message);
+            sqe->len = 1;
+        }
+        sqe->fd = pc->_socket;
+        sqe->msg_flags = MSG_WAITALL | MSG_NOSIGNAL;
+        // Short send breaks the link, so the rest of the chain is cancelled rather than sent out of order
+        sqe->flags = i + 1 < count ? IOSQE_IO_LINK : 0;
+        sqe->user_data = user_data(pc, send_op);
+    }
+    pc->sending = count;
+}
+
+// See Worker.h
+void Worker::Pause(Connection *pc) {
+    if (!pc->receiving || pc->pausing) {
+        return;
+    }
+
+    // Data arriving meanwhile stays in the socket, receive completes with ECANCELED once cancelled
+    struct io_uring_sqe *sqe = _ring->get_sqe();
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->addr = user_data(pc, receive_op);
+    sqe->user_data = user_data<Worker>(nullptr, other_op);
+    pc->pausing = true;
+}
+
+// See Worker.h
+void Worker::OnAccept(int32_t res, uint32_t flags) {
+    if (!(flags & IORING_CQE_F_MORE)) {
+        _accepting = false;
+        if (isRunning) {
+            Accept();
+        }
+    }
+
+    if (res < 0) {
+        if (res != -ECANCELED) {
+            _logger->error("Failed to accept socket: {}", strerror(-res));
+        }
+        return;
+    } else if (!isRunning) {
+        close(res);
+        return;
+    }
+
+    Connection *pc = new Connection(res, _pStorage, _pLogging, _max_pending);
+    _connections.insert(pc);
+    pc->Start();
+    Receive(pc);
+}
+
+// See Worker.h
+void Worker::OnReceive(Connection *pc, int32_t res, uint32_t flags) {
+    if (!(flags & IORING_CQE_F_MORE)) {
+        pc->receiving = false;
+    }
+
+    if (res > 0) {
+        uint16_t id = uint16_t(flags >> IORING_CQE_BUFFER_SHIFT);
+        if (pc->isAlive()) {
+            pc->OnReceive(_buffers->buffer(id), res);
+        }
+        _buffers->recycle(id);
+
+        if (pc->isAlive()) {
+            Send(pc);
+            if (pc->results_to_write.full()) {
+                Pause(pc);
+            }
+        }
+    } else if (res == 0) {
+        _logger->debug("Connection closed");
+        pc->OnClose();
+    } else if (res != -ENOBUFS && res != -ECANCELED) {
+        // Running out of buffers just stops multishot receive, it is restarted below
+        _logger->error("Failed to receive on descriptor {}: {}", pc->_socket, strerror(-res));
+        pc->OnError();
+    }
+
+    if (!pc->receiving) {
+        pc->pausing = false;
+    }
+    if (pc->isAlive() && !pc->receiving && !pc->results_to_write.full()) {
+        Receive(pc);
+    }
+    Release(pc);
+}
+
+// See Worker.h
+void Worker::OnSend(Connection *pc, int32_t res) {
+    pc->sending--;
+    if (res > 0) {
+        pc->OnSent(res);
+    } else if (res < 0 && res != -ECANCELED && pc->isAlive()) {
+        _logger->error("Failed to send response: {}", strerror(-res));
+        pc->OnError();
+    }
+
+    // Whatever wasn't sent by the chain, including responses queued meanwhile, goes with the next one
+    if (pc->sending == 0 && pc->isAlive()) {
+        Send(pc);
+    }
+
+    // Client took enough responses to get more commands executed
+    if (pc->isAlive() && !pc->receiving && !pc->results_to_write.full()) {
+        Receive(pc);
+    }
+    Release(pc);
+}
+
+// See Worker.h
+void Worker::Release(Connection *pc) {
+    if (pc->isAlive()) {
+        return;
+    }
+
+    // Socket shutdown makes pending operations complete soon
+    if (pc->receiving || pc->sending > 0) {
+        shutdown(pc->_socket, SHUT_RDWR);
+        return;
+    }
+
+    close(pc->_socket);
+    _connections.erase(pc);
+    delete pc;
+}
+
+} // namespace Uring
+} // namespace Network
+} // namespace Afina
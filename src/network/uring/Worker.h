@@ -0,0 +1,137 @@
+#ifndef AFINA_NETWORK_URING_WORKER_H
+#define AFINA_NETWORK_URING_WORKER_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <thread>
+
+namespace spdlog {
+class logger;
+}
+
+namespace Afina {
+
+// Forward declaration, see afina/Storage.h
+class Storage;
+namespace Logging {
+class Service;
+}
+
+namespace Network {
+namespace Uring {
+
+// Forward declaration, see Connection.h
+class Connection;
+
+// Forward declaration, see Ring.h
+class Ring;
+class BufferRing;
+
+/**
+ * # Reactor thread over io_uring
+ * Owns listening socket, ring and all connections accepted on that socket. Listener has a single
+ * multishot accept and every connection a single multishot recv taking buffers from the worker buffer
+ * ring, so steady state costs one io_uring_enter per loop iteration no matter how many connections are
+ * served. Responses are sent by chains of linked sendmsg, at most one chain per connection at a time.
+ */
+class Worker {
+public:
+    /**
+     * @param max_pending bytes of responses connection could keep unsent before it stops reading
+     */
+    Worker(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Afina::Logging::Service> pl,
+           std::size_t max_pending);
+    ~Worker();
+
+    /**
+     * Opens listening socket on the given port along with the ring and spawns background thread serving
+     * them. Event descriptor wakes thread up on stop
+     *
+     * @throw std::runtime_error if socket or ring can't be created
+     */
+    void Start(uint16_t port, int event_fd);
+
+    /**
+     * Signal background thread to stop, it must be woken up through the event descriptor afterwards.
+     * Thread shuts all connections down and waits for their operations to complete before exit
+     */
+    void Stop();
+
+    /**
+     * Blocks calling thread until background one for this worker is actually
+     * been destoryed
+     */
+    void Join();
+
+protected:
+    /**
+     * Method executing by background thread
+     */
+    void OnRun();
+
+    // Submits multishot accept on the listener
+    void Accept();
+
+    // Submits multishot recv on the connection
+    void Receive(Connection *pc);
+
+    // Submits chain of messages with responses queued by the connection, if there is no chain in flight
+    void Send(Connection *pc);
+
+    // Cancels receive of the connection which output queue is full, it is submitted again once client takes
+    // enough responses
+    void Pause(Connection *pc);
+
+    // Handlers of the completions
+    void OnAccept(int32_t res, uint32_t flags);
+    void OnReceive(Connection *pc, int32_t res, uint32_t flags);
+    void OnSend(Connection *pc, int32_t res);
+
+    // Shuts dead connection down, it is destroyed once all its operations are completed
+    void Release(Connection *pc);
+
+private:
+    Worker(Worker &) = delete;
+    Worker &operator=(Worker &) = delete;
+
+    // afina services
+    std::shared_ptr<Afina::Storage> _pStorage;
+
+    // afina services
+    std::shared_ptr<Afina::Logging::Service> _pLogging;
+
+    // Limit of unsent response bytes per connection
+    std::size_t _max_pending;
+
+    // Logger to be used
+    std::shared_ptr<spdlog::logger> _logger;
+
+    // Flag signals that thread should continue to operate
+    std::atomic<bool> isRunning;
+
+    // Thread serving requests in this worker
+    std::thread _thread;
+
+    // Socket bound to the server port along with listeners of other workers
+    int _server_socket;
+
+    // Descriptor signaled on stop
+    int _event_fd;
+
+    // True while multishot accept is in flight
+    bool _accepting;
+
+    std::unique_ptr<Ring> _ring;
+    std::unique_ptr<BufferRing> _buffers;
+
+    // Connections served by this worker
+    std::set<Connection *> _connections;
+};
+
+} // namespace Uring
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_URING_WORKER_H
@@ -1,5 +1,6 @@
 #include "Parser.h"
 
+#include <cstdint>
 #include <iostream>
 #include <sstream>
 #include <stdexcept>
@@ -9,6 +10,7 @@
 #include <afina/execute/Command.h>
 #include <afina/execute/Delete.h>
 #include <afina/execute/Get.h>
+#include <afina/execute/Replace.h>
 #include <afina/execute/Set.h>
 #include <afina/execute/Stats.h>
 
@@ -28,7 +30,7 @@ bool Parser::Parse(const char *input, const size_t size, size_t &parsed) {
         case State::sName: {
             if (c == ' ' || c == '\r') {
                 // std::cout << "parser debug: name='" << name << "'" << std::endl;
-                if (name == "set" || name == "add" || name == "append" || name == "prepend") {
+                if (name == "set" || name == "add" || name == "replace" || name == "append" || name == "prepend") {
                     state = State::spKey;
                 } else if (name == "get" || name == "gets") {
                     state = State::sgKey;
@@ -57,7 +59,7 @@ bool Parser::Parse(const char *input, const size_t size, size_t &parsed) {
 
         case State::sgKey: {
             if (c == '\r') {
-                keys.push_back(curKey);
+                keys.push_back(std::move(curKey));
                 // std::cout << "parser debug: total '" << keys.size() << " keys" << std::endl;
 
                 if (keys.size() == 0) {
@@ -69,7 +71,7 @@ bool Parser::Parse(const char *input, const size_t size, size_t &parsed) {
             } else if (c == ' ') {
                 // std::cout << "parser debug: key[" << keys.size() << "]='" << curKey << "'" << std::endl;
                 state = State::sgKey;
-                keys.push_back(curKey);
+                keys.push_back(std::move(curKey));
                 curKey.clear();
             } else {
                 curKey.push_back(c);
@@ -109,19 +111,16 @@ bool Parser::Parse(const char *input, const size_t size, size_t &parsed) {
                 state = State::spBytes;
                 // std::cout << "parser debug: ExprTime='" << exprtime << "'" << std::endl;
             } else if (c >= '0' && c <= '9') {
-                int32_t et = exprtime;
+                int64_t et = int64_t(exprtime) * 10;
                 if (negative) {
                     et -= (c - '0');
-                    if (et > exprtime) {
-                        throw std::runtime_error("Expire time field overflow");
-                    }
                 } else {
                     et += (c - '0');
-                    if (et < exprtime) {
-                        throw std::runtime_error("Expire time field overflow");
-                    }
                 }
-                exprtime = et;
+                if (et > INT32_MAX || et < INT32_MIN) {
+                    throw std::runtime_error("Expire time field overflow");
+                }
+                exprtime = int32_t(et);
             }
             break;
         }
@@ -172,10 +171,12 @@ std::unique_ptr<Execute::Command> Parser::Build(size_t &body_size) const {
         return std::unique_ptr<Execute::Command>(new Execute::Set(keys[0], flags, exprtime));
     } else if (name == "add") {
         return std::unique_ptr<Execute::Command>(new Execute::Add(keys[0], flags, exprtime));
+    } else if (name == "replace") {
+        return std::unique_ptr<Execute::Command>(new Execute::Replace(keys[0], flags, exprtime));
     } else if (name == "append") {
         return std::unique_ptr<Execute::Command>(new Execute::Append(keys[0], flags, exprtime));
-    } else if (name == "get") {
-        return std::unique_ptr<Execute::Command>(new Execute::Get(keys));
+    } else if (name == "get" || name == "gets") {
+        return std::unique_ptr<Execute::Command>(new Execute::Get(keys, name == "gets"));
     } else if (name == "stats") {
         return std::unique_ptr<Execute::Command>(new Execute::Stats());
     } else {
@@ -0,0 +1,528 @@
+#include "ArenaLRU.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <afina/allocator/Error.h>
+
+namespace Afina {
+namespace Backend {
+
+// See ArenaLRU.h
+class ArenaLRU::reservation : public Storage::Reservation {
+public:
+    reservation(ArenaLRU &owner, WriteMode mode, node_id id, char *data, std::size_t size, int32_t ttl)
+        : _owner(owner), _mode(mode), _id(id), _data(data), _size(size), _ttl(ttl), _committed(false) {}
+
+    ~reservation() {
+        if (!_committed) {
+            _owner.cancel(_id);
+        }
+    }
+
+    char *data() override { return _data; }
+
+    std::size_t size() const override { return _size; }
+
+    bool Commit() override {
+        _committed = true;
+        return _owner.commit(_mode, _id, _ttl);
+    }
+
+private:
+    ArenaLRU &_owner;
+    const WriteMode _mode;
+    const node_id _id;
+
+    // Arena doesn't move blocks while reservation is pending
+    char *const _data;
+    const std::size_t _size;
+    const int32_t _ttl;
+
+    bool _committed;
+};
+
+const std::size_t ArenaLRU::expected_entry_size;
+
+// See ArenaLRU.h
+ArenaLRU::ArenaLRU(size_t max_size, size_t max_entries)
+    : _max_entries(max_entries > 0 ? max_entries : std::max<size_t>(max_size / expected_entry_size, 1)),
+      _overhead(std::min(Overhead(_max_entries), max_size)), _max_size(max_size - _overhead),
+      _memory(new char[_max_size]), _arena(_memory.get(), _max_size), _pinned(0), _free(npos), _lru_head(npos),
+      _lru_tail(npos), _index(_max_entries), _wheel(_max_entries) {
+    _nodes.reserve(_max_entries);
+}
+
+// See ArenaLRU.h
+std::size_t ArenaLRU::Overhead(std::size_t max_entries) {
+    return max_entries * sizeof(arena_node) + HashIndex::memory(max_entries) + TimingWheel::memory(max_entries);
+}
+
+// See ArenaLRU.h
+ArenaLRU::~ArenaLRU() { _sweeper.Stop(); }
+
+// See ArenaLRU.h
+void ArenaLRU::Start() {
+    _sweeper.Start([this]() { Expire(); });
+}
+
+// See ArenaLRU.h
+void ArenaLRU::Stop() { _sweeper.Stop(); }
+
+// See Storage.h
+bool ArenaLRU::Put(const std::string &key, const std::string &value) {
+    return ArenaLRU::Put(StringView(key), StringView(value), 0, 0);
+}
+
+// See Storage.h
+bool ArenaLRU::PutIfAbsent(const std::string &key, const std::string &value) {
+    return ArenaLRU::PutIfAbsent(StringView(key), StringView(value), 0, 0);
+}
+
+// See Storage.h
+bool ArenaLRU::Set(const std::string &key, const std::string &value) {
+    uint32_t hash = HashIndex::hash(key);
+    std::lock_guard<std::mutex> lock(_lock);
+    size_t pos = find_alive(key, hash);
+    if (pos == npos) { // key not present
+        return false;
+    }
+
+    // Plain Set keeps flags and expiration time of the entry
+    const arena_node &node = _nodes[_index.node(pos)];
+    return put(key, value, node.flags, node.expire, hash, pos);
+}
+
+// See Storage.h
+bool ArenaLRU::Delete(const std::string &key) { return ArenaLRU::Delete(StringView(key)); }
+
+// See Storage.h
+bool ArenaLRU::Get(const std::string &key, std::string &value) const {
+    return ArenaLRU::Get(StringView(key), value);
+}
+
+// See Storage.h
+bool ArenaLRU::Put(StringView key, StringView value, uint32_t flags, int32_t ttl) {
+    uint32_t hash = HashIndex::hash(key);
+    std::lock_guard<std::mutex> lock(_lock);
+    return put(key, value, flags, TimingWheel::deadline(ttl), hash, find_alive(key, hash));
+}
+
+// See Storage.h
+bool ArenaLRU::PutIfAbsent(StringView key, StringView value, uint32_t flags, int32_t ttl) {
+    uint32_t hash = HashIndex::hash(key);
+    std::lock_guard<std::mutex> lock(_lock);
+    if (find_alive(key, hash) != npos) { // key exists
+        return false;
+    }
+    return put(key, value, flags, TimingWheel::deadline(ttl), hash, npos);
+}
+
+// See Storage.h
+bool ArenaLRU::Set(StringView key, StringView value, uint32_t flags, int32_t ttl) {
+    uint32_t hash = HashIndex::hash(key);
+    std::lock_guard<std::mutex> lock(_lock);
+    size_t pos = find_alive(key, hash);
+    if (pos == npos) { // key not present
+        return false;
+    }
+    return put(key, value, flags, TimingWheel::deadline(ttl), hash, pos);
+}
+
+// See Storage.h
+bool ArenaLRU::Delete(StringView key) {
+    uint32_t hash = HashIndex::hash(key);
+    std::lock_guard<std::mutex> lock(_lock);
+    size_t pos = find_alive(key, hash);
+    if (pos == npos) { // key not present
+        return false;
+    }
+
+    remove(pos);
+    return true;
+}
+
+// See Storage.h
+bool ArenaLRU::Append(StringView key, StringView data) {
+    std::lock_guard<std::mutex> lock(_lock);
+    return append(key, data);
+}
+
+// See Storage.h
+bool ArenaLRU::Get(StringView key, std::string &value) const {
+    uint32_t hash = HashIndex::hash(key);
+    std::lock_guard<std::mutex> lock(_lock);
+    size_t pos = find(key, hash);
+    if (pos == npos || TimingWheel::expired(_nodes[_index.node(pos)].expire)) { // key not found
+        return false;
+    }
+
+    StringView stored = value_of(_nodes[_index.node(pos)]);
+    value.assign(stored.data(), stored.size());
+    return true;
+}
+
+// See Storage.h
+bool ArenaLRU::Get(StringView key, const Reader &reader) const {
+    uint32_t hash = HashIndex::hash(key);
+    std::lock_guard<std::mutex> lock(_lock);
+    size_t pos = find(key, hash);
+    if (pos == npos || TimingWheel::expired(_nodes[_index.node(pos)].expire)) { // key not found
+        return false;
+    }
+
+    const arena_node &node = _nodes[_index.node(pos)];
+    reader(value_of(node), node.flags);
+    return true;
+}
+
+// See Storage.h
+std::size_t ArenaLRU::GetMany(const std::vector<StringView> &keys, std::size_t min_size,
+                              const BatchReader &reader) const {
+    std::vector<uint32_t> hashes(keys.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+        hashes[i] = HashIndex::hash(keys[i]);
+    }
+
+    std::lock_guard<std::mutex> lock(_lock);
+    for (size_t i = 0; i < keys.size() && i < HashIndex::prefetch_distance; i++) {
+        _index.prefetch(hashes[i]);
+    }
+
+    std::size_t found = 0;
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (i + HashIndex::prefetch_distance < keys.size()) {
+            _index.prefetch(hashes[i + HashIndex::prefetch_distance]);
+        }
+
+        size_t pos = find(keys[i], hashes[i]);
+        if (pos == npos || TimingWheel::expired(_nodes[_index.node(pos)].expire)) { // key not found
+            continue;
+        }
+
+        const arena_node &node = _nodes[_index.node(pos)];
+        reader(i, value_of(node), node.flags, nullptr);
+        found++;
+    }
+    return found;
+}
+
+// See Storage.h
+std::unique_ptr<Storage::Reservation> ArenaLRU::Reserve(WriteMode mode, StringView key, std::size_t size,
+                                                        uint32_t flags, int32_t ttl) {
+    if (key.size() + size > _max_size) { // would never fit
+        return nullptr;
+    }
+
+    uint32_t hash = HashIndex::hash(key);
+    std::lock_guard<std::mutex> lock(_lock);
+    node_id id = node_alloc();
+    if (id == npos) {
+        return nullptr;
+    }
+    if (!place(id, key.size() + size, npos)) {
+        node_free(id);
+        return nullptr;
+    }
+
+    // Node stays out of index, list and wheel until commit, so it is never evicted or expired
+    arena_node &node = _nodes[id];
+    std::memcpy(node.data.get(), key.data(), key.size());
+    node.key_size = uint32_t(key.size());
+    node.value_size = uint32_t(size);
+    node.flags = flags;
+    node.expire = 0;
+    node.hash = hash;
+    _pinned++;
+
+    char *data = static_cast<char *>(node.data.get()) + key.size();
+    return std::unique_ptr<Reservation>(new reservation(*this, mode, id, data, size, ttl));
+}
+
+// See ArenaLRU.h
+std::size_t ArenaLRU::Size() const {
+    std::lock_guard<std::mutex> lock(_lock);
+    return _overhead + _arena.used();
+}
+
+// See ArenaLRU.h
+void ArenaLRU::Expire() {
+    std::lock_guard<std::mutex> lock(_lock);
+    expire();
+}
+
+// See ArenaLRU.h
+bool ArenaLRU::put(StringView key, StringView value, uint32_t flags, uint64_t expire, uint32_t hash, size_t pos) {
+    if (key.size() + value.size() > _max_size) { // new size is really big
+        return false;
+    }
+
+    // Entry would be invisible right away, no reason to store it
+    if (TimingWheel::expired(expire)) {
+        if (pos != npos) {
+            remove(pos);
+        }
+        return true;
+    }
+
+    node_id id;
+    if (pos != npos) { // key exists, override
+        id = _index.node(pos);
+
+        // Node being updated must survive eviction, so it is taken out of the wheel. Key is already in
+        // place, only value gets copied
+        _wheel.cancel(id);
+        if (!place(id, key.size() + value.size(), id)) {
+            remove(find(key, hash));
+            return false;
+        }
+
+        arena_node &node = _nodes[id];
+        std::memcpy(static_cast<char *>(node.data.get()) + key.size(), value.data(), value.size());
+        node.value_size = uint32_t(value.size());
+        node.flags = flags;
+        node.expire = expire;
+        list_unlink(id);
+    } else {
+        id = node_alloc();
+        if (id == npos) {
+            return false;
+        }
+        if (!place(id, key.size() + value.size(), id)) {
+            node_free(id);
+            return false;
+        }
+
+        arena_node &node = _nodes[id];
+        std::memcpy(node.data.get(), key.data(), key.size());
+        std::memcpy(static_cast<char *>(node.data.get()) + key.size(), value.data(), value.size());
+        node.key_size = uint32_t(key.size());
+        node.value_size = uint32_t(value.size());
+        node.flags = flags;
+        node.expire = expire;
+        node.hash = hash;
+        _index.insert(id, hash);
+    }
+
+    list_append(id);
+    if (expire != 0) {
+        _wheel.schedule(id, expire);
+    }
+    return true;
+}
+
+// See ArenaLRU.h
+bool ArenaLRU::append(StringView key, StringView data) {
+    size_t pos = find_alive(key, HashIndex::hash(key));
+    if (pos == npos) { // key not present
+        return false;
+    }
+
+    node_id id = _index.node(pos);
+    size_t size = size_t(_nodes[id].key_size) + _nodes[id].value_size;
+    if (size + data.size() > _max_size) {
+        return false;
+    }
+
+    // Node being updated must survive eviction, so it is taken out of the wheel for a while
+    _wheel.cancel(id);
+    bool placed = place(id, size + data.size(), id);
+
+    arena_node &node = _nodes[id];
+    if (placed) {
+        std::memcpy(static_cast<char *>(node.data.get()) + size, data.data(), data.size());
+        node.value_size += uint32_t(data.size());
+        list_unlink(id);
+        list_append(id);
+    }
+    if (node.expire != 0) {
+        _wheel.schedule(id, node.expire);
+    }
+    return placed;
+}
+
+// See ArenaLRU.h
+bool ArenaLRU::commit(WriteMode mode, node_id id, int32_t ttl) {
+    std::lock_guard<std::mutex> lock(_lock);
+    if (mode == WriteMode::Append) { // existing entry grows, reserved block is only the source of data
+        // Block is read after making room for the entry, so it stays pinned until then
+        const arena_node &node = _nodes[id];
+        bool stored = append(key_of(node), value_of(node));
+        _pinned--;
+        node_free(id);
+        return stored;
+    }
+
+    _pinned--;
+
+    uint32_t hash = _nodes[id].hash;
+    size_t pos = find_alive(key_of(_nodes[id]), hash);
+    if ((mode == WriteMode::PutIfAbsent && pos != npos) || (mode == WriteMode::Set && pos == npos)) {
+        node_free(id);
+        return false;
+    }
+    if (pos != npos) {
+        remove(pos);
+    }
+
+    // Entry would be invisible right away, no reason to store it
+    uint64_t expire = TimingWheel::deadline(ttl);
+    if (TimingWheel::expired(expire)) {
+        node_free(id);
+        return true;
+    }
+
+    _nodes[id].expire = expire;
+    _index.insert(id, hash);
+    list_append(id);
+    if (expire != 0) {
+        _wheel.schedule(id, expire);
+    }
+    return true;
+}
+
+// See ArenaLRU.h
+void ArenaLRU::cancel(node_id id) {
+    std::lock_guard<std::mutex> lock(_lock);
+    _pinned--;
+    node_free(id);
+}
+
+// See ArenaLRU.h
+size_t ArenaLRU::find(StringView key, uint32_t hash) const {
+    return _index.find(key, hash, [this](node_id id) { return key_of(_nodes[id]); });
+}
+
+// See ArenaLRU.h
+size_t ArenaLRU::find_alive(StringView key, uint32_t hash) {
+    size_t pos = find(key, hash);
+    if (pos != npos && TimingWheel::expired(_nodes[_index.node(pos)].expire)) {
+        remove(pos);
+        return npos;
+    }
+    return pos;
+}
+
+// See ArenaLRU.h
+void ArenaLRU::expire() {
+    _wheel.advance(TimingWheel::now(), [this](node_id id) {
+        const arena_node &node = _nodes[id];
+        remove(find(key_of(node), node.hash));
+    });
+}
+
+// See ArenaLRU.h
+ArenaLRU::node_id ArenaLRU::node_alloc() {
+    if (_free == npos && _nodes.size() == _max_entries) {
+        expire();
+    }
+    if (_free == npos && _nodes.size() == _max_entries && _lru_head != npos) {
+        const arena_node &node = _nodes[_lru_head];
+        remove(find(key_of(node), node.hash));
+    }
+
+    if (_free != npos) {
+        node_id id = _free;
+        _free = _nodes[id].next;
+        return id;
+    }
+
+    if (_nodes.size() == _max_entries) {
+        return npos;
+    }
+    _nodes.emplace_back();
+    return node_id(_nodes.size() - 1);
+}
+
+// See ArenaLRU.h
+void ArenaLRU::node_free(node_id id) {
+    arena_node &node = _nodes[id];
+    _arena.free(node.data);
+
+    node.prev = npos;
+    node.next = _free;
+    _free = id;
+}
+
+// See ArenaLRU.h
+void ArenaLRU::list_unlink(node_id id) {
+    arena_node &node = _nodes[id];
+    if (node.prev == npos) {
+        _lru_head = node.next;
+    } else {
+        _nodes[node.prev].next = node.next;
+    }
+
+    if (node.next == npos) {
+        _lru_tail = node.prev;
+    } else {
+        _nodes[node.next].prev = node.prev;
+    }
+}
+
+// See ArenaLRU.h
+void ArenaLRU::list_append(node_id id) {
+    arena_node &node = _nodes[id];
+    node.prev = _lru_tail;
+    node.next = npos;
+
+    if (_lru_tail == npos) {
+        _lru_head = id;
+    } else {
+        _nodes[_lru_tail].next = id;
+    }
+    _lru_tail = id;
+}
+
+// See ArenaLRU.h
+void ArenaLRU::remove(size_t pos) {
+    node_id id = _index.node(pos);
+
+    _index.erase(pos);
+    _wheel.cancel(id);
+    list_unlink(id);
+    node_free(id);
+}
+
+// See ArenaLRU.h
+bool ArenaLRU::place(node_id id, size_t size, node_id keep) {
+    bool expired = false;
+    bool compacted = false;
+    while (true) {
+        try {
+            _arena.realloc(_nodes[id].data, size);
+            return true;
+        } catch (Allocator::AllocError &) {
+        }
+
+        if (!expired) {
+            expire();
+            expired = true;
+            continue;
+        }
+
+        // Compaction moves every block, so it is worth only if a noticeable part of arena is wasted
+        if (!compacted && _pinned == 0 && _arena.size() - _arena.used() >= size + _arena.size() / 8) {
+            _arena.defrag();
+            compacted = true;
+            continue;
+        }
+
+        node_id victim = _lru_head;
+        if (victim == keep) {
+            victim = _nodes[victim].next;
+        }
+        if (victim == npos) {
+            return false;
+        }
+
+        const arena_node &node = _nodes[victim];
+        remove(find(key_of(node), node.hash));
+
+        // Once enough was evicted, free space could be scattered again
+        compacted = false;
+    }
+}
+
+} // namespace Backend
+} // namespace Afina
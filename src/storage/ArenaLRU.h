@@ -0,0 +1,223 @@
+#ifndef AFINA_STORAGE_ARENA_LRU_H
+#define AFINA_STORAGE_ARENA_LRU_H
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <afina/Storage.h>
+#include <afina/allocator/Pointer.h>
+#include <afina/allocator/Simple.h>
+
+#include "HashIndex.h"
+#include "Sweeper.h"
+#include "TimingWheel.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # LRU over fixed memory arena
+ * Storage never takes more than max_size bytes, whatever is stored. Budget is split at construction:
+ * entry bookkeeping (LRU links, flags, expiration time, hash index and timing wheel slots, under 100 bytes
+ * per entry) is allocated up front for a fixed number of entries, the rest is a single memory arena
+ * managed by Allocator::Simple where keys and values live. So there is no heap allocation per entry and
+ * neither part grows past its share. Arena accounting includes everything allocator spends on the entry:
+ * block header, size class rounding and descriptor, so Size() reports real usage rather than payload
+ * bytes. Memory is not touched until it is needed, so resident memory grows along with the data. Only
+ * fixed size parts, like the object itself and timing wheel slots, are on top of the budget.
+ *
+ * Unless number of entries is given, it is derived from the budget assuming an entry takes 256 bytes
+ * together with its bookkeeping.
+ *
+ * Once arena can't fit a new value or all entries are taken, expired entries are reclaimed first. If
+ * there is enough free space in arena, but it is scattered over free lists of other size classes, arena
+ * gets compacted. Only then least recently used entries are evicted.
+ *
+ * Reservations take arena block right away, so value is received where it is going to be stored. Block
+ * of the reservation must stay in place, so arena isn't compacted while any reservation is pending.
+ *
+ * All operations are serialized by a single lock.
+ */
+class ArenaLRU : public Afina::Storage {
+public:
+    ArenaLRU(size_t max_size = 1024, size_t max_entries = 0);
+    ~ArenaLRU();
+
+    // Bytes of the budget taken by bookkeeping of the given number of entries
+    static std::size_t Overhead(std::size_t max_entries);
+
+    // Starts background reclaiming of expired entries
+    void Start() override;
+
+    // Stops background reclaiming of expired entries
+    void Stop() override;
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) const override;
+
+    // Implements Afina::Storage interface
+    bool Put(StringView key, StringView value, uint32_t flags, int32_t ttl) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(StringView key, StringView value, uint32_t flags, int32_t ttl) override;
+
+    // Implements Afina::Storage interface
+    bool Set(StringView key, StringView value, uint32_t flags, int32_t ttl) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(StringView key) override;
+
+    // Implements Afina::Storage interface
+    bool Get(StringView key, std::string &value) const override;
+
+    // Implements Afina::Storage interface
+    bool Append(StringView key, StringView data) override;
+
+    // Implements Afina::Storage interface, reader is called under the lock
+    bool Get(StringView key, const Reader &reader) const override;
+
+    // Implements Afina::Storage interface, whole batch is looked up under the lock taken once. Values are
+    // never pinned as arena moves them on compaction
+    std::size_t GetMany(const std::vector<StringView> &keys, std::size_t min_size,
+                        const BatchReader &reader) const override;
+
+    // Implements Afina::Storage interface, memory is taken from the arena until commit
+    std::unique_ptr<Reservation> Reserve(WriteMode mode, StringView key, std::size_t size, uint32_t flags,
+                                         int32_t ttl) override;
+
+    // Number of budget bytes taken: bookkeeping of all entries plus arena bytes taken by entries, including
+    // expired ones not reclaimed yet and pending reservations
+    std::size_t Size() const;
+
+    // Removes all entries which expiration time has passed
+    void Expire();
+
+private:
+    // Reservation owning node which isn't linked anywhere until commit
+    class reservation;
+
+    using node_id = HashIndex::node_id;
+    static const node_id npos = HashIndex::npos;
+
+    // Cache node, key and value bytes follow each other in the arena block
+    struct arena_node {
+        Allocator::Pointer data;
+
+        // Moment entry expires at as returned by TimingWheel::now(), 0 if it lives forever
+        uint64_t expire;
+        uint32_t flags;
+
+        uint32_t key_size;
+        uint32_t value_size;
+
+        // Lower bits of the key hash, to avoid rehashing keys on table growth
+        uint32_t hash;
+
+        // Neighbours in the LRU list, or next free node for nodes in free list
+        node_id prev;
+        node_id next;
+    };
+
+    inline StringView key_of(const arena_node &node) const {
+        return StringView(static_cast<const char *>(node.data.get()), node.key_size);
+    }
+
+    inline StringView value_of(const arena_node &node) const {
+        return StringView(static_cast<const char *>(node.data.get()) + node.key_size, node.value_size);
+    }
+
+    // Inserts or updates element, pos is current index position of the key or npos if key is absent
+    bool put(StringView key, StringView value, uint32_t flags, uint64_t expire, uint32_t hash, size_t pos);
+
+    // Same as Append, but lock must be held already
+    bool append(StringView key, StringView data);
+
+    // Stores node of the reservation according to the write mode, frees node if it isn't stored
+    bool commit(WriteMode mode, node_id id, int32_t ttl);
+
+    // Frees node of the reservation which wasn't committed
+    void cancel(node_id id);
+
+    // Returns index position of the given key or npos if key is absent
+    size_t find(StringView key, uint32_t hash) const;
+
+    // Same as find, but expired entry gets removed and reported as absent
+    size_t find_alive(StringView key, uint32_t hash);
+
+    // Same as Expire, but lock must be held already
+    void expire();
+
+    // Takes free node, evicting expired and then least recently used entry if all of them are taken.
+    // Returns npos if every node is held by a pending reservation
+    node_id node_alloc();
+    void node_free(node_id id);
+
+    void list_unlink(node_id id);
+    void list_append(node_id id);
+
+    // Removes given element from index, list, pool and arena
+    void remove(size_t pos);
+
+    // Resizes block of the node to size bytes keeping its content, allocates block if node has none.
+    // Makes room in the arena if needed, never evicting node keep. Returns false if block doesn't fit
+    // even into the empty arena
+    bool place(node_id id, size_t size, node_id keep);
+
+    // Entry footprint, bookkeeping included, number of entries is derived from budget with
+    static const std::size_t expected_entry_size = 256;
+
+    // Maximum number of entries, including pending reservations
+    std::size_t _max_entries;
+
+    // Bytes of the budget taken by bookkeeping of max entries
+    std::size_t _overhead;
+
+    // Maximum number of bytes arena could hold, including allocator overhead
+    std::size_t _max_size;
+
+    // Arena memory, owned by storage, not by allocator
+    std::unique_ptr<char[]> _memory;
+    Allocator::Simple _arena;
+
+    // Number of pending reservations, arena is never compacted unless it is 0
+    std::size_t _pinned;
+
+    // Pool of all nodes, both used and free, never takes more than max entries
+    std::vector<arena_node> _nodes;
+
+    // Head of the free nodes list, linked through arena_node#next
+    node_id _free;
+
+    // LRU list, least recently used element in the head
+    node_id _lru_head;
+    node_id _lru_tail;
+
+    HashIndex _index;
+
+    // Expiration times of nodes with time to live
+    TimingWheel _wheel;
+
+    mutable std::mutex _lock;
+
+    Sweeper _sweeper;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_ARENA_LRU_H
@@ -0,0 +1,378 @@
+#include "ClockLRU.h"
+
+namespace Afina {
+namespace Backend {
+
+namespace {
+
+// RAII holders for pthread_rwlock_t, C++11 has no shared_mutex
+class read_lock {
+public:
+    read_lock(pthread_rwlock_t &lock) : _lock(lock) { pthread_rwlock_rdlock(&_lock); }
+    ~read_lock() { pthread_rwlock_unlock(&_lock); }
+
+private:
+    pthread_rwlock_t &_lock;
+};
+
+class write_lock {
+public:
+    write_lock(pthread_rwlock_t &lock) : _lock(lock) { pthread_rwlock_wrlock(&_lock); }
+    ~write_lock() { pthread_rwlock_unlock(&_lock); }
+
+private:
+    pthread_rwlock_t &_lock;
+};
+
+} // namespace
+
+// See ClockLRU.h
+ClockLRU::ClockLRU(size_t max_size) : _max_size(max_size), _act_size(0), _hand(0) {
+    pthread_rwlock_init(&_lock, nullptr);
+}
+
+// See ClockLRU.h
+ClockLRU::~ClockLRU() {
+    _sweeper.Stop();
+    pthread_rwlock_destroy(&_lock);
+}
+
+// See ClockLRU.h
+void ClockLRU::Start() {
+    _sweeper.Start([this]() { Expire(); });
+}
+
+// See ClockLRU.h
+void ClockLRU::Stop() { _sweeper.Stop(); }
+
+// See Storage.h
+bool ClockLRU::Put(const std::string &key, const std::string &value) {
+    return ClockLRU::Put(StringView(key), StringView(value), 0, 0);
+}
+
+// See Storage.h
+bool ClockLRU::PutIfAbsent(const std::string &key, const std::string &value) {
+    return ClockLRU::PutIfAbsent(StringView(key), StringView(value), 0, 0);
+}
+
+// See Storage.h
+bool ClockLRU::Set(const std::string &key, const std::string &value) {
+    uint32_t hash = HashIndex::hash(key);
+    write_lock lock(_lock);
+    size_t pos = find_alive(key, hash);
+    if (pos == npos) { // key not present
+        return false;
+    }
+
+    // Plain Set keeps flags and expiration time of the entry
+    const Entry &entry = _nodes[_index.node(pos)].entry;
+    return put(key, value, entry.flags, entry.expire, hash, pos);
+}
+
+// See Storage.h
+bool ClockLRU::Delete(const std::string &key) { return ClockLRU::Delete(StringView(key)); }
+
+// See Storage.h
+bool ClockLRU::Get(const std::string &key, std::string &value) const {
+    return ClockLRU::Get(StringView(key), value);
+}
+
+// See Storage.h
+bool ClockLRU::Put(StringView key, StringView value, uint32_t flags, int32_t ttl) {
+    uint32_t hash = HashIndex::hash(key);
+    write_lock lock(_lock);
+    return put(key, value, flags, TimingWheel::deadline(ttl), hash, find_alive(key, hash));
+}
+
+// See Storage.h
+bool ClockLRU::PutIfAbsent(StringView key, StringView value, uint32_t flags, int32_t ttl) {
+    uint32_t hash = HashIndex::hash(key);
+    write_lock lock(_lock);
+    if (find_alive(key, hash) != npos) { // key exists
+        return false;
+    }
+    return put(key, value, flags, TimingWheel::deadline(ttl), hash, npos);
+}
+
+// See Storage.h
+bool ClockLRU::Set(StringView key, StringView value, uint32_t flags, int32_t ttl) {
+    uint32_t hash = HashIndex::hash(key);
+    write_lock lock(_lock);
+    size_t pos = find_alive(key, hash);
+    if (pos == npos) { // key not present
+        return false;
+    }
+    return put(key, value, flags, TimingWheel::deadline(ttl), hash, pos);
+}
+
+// See Storage.h
+bool ClockLRU::Delete(StringView key) {
+    uint32_t hash = HashIndex::hash(key);
+    write_lock lock(_lock);
+    size_t pos = find_alive(key, hash);
+    if (pos == npos) { // key not present
+        return false;
+    }
+
+    remove(pos);
+    return true;
+}
+
+// See Storage.h
+bool ClockLRU::Append(StringView key, StringView data) {
+    uint32_t hash = HashIndex::hash(key);
+    write_lock lock(_lock);
+    size_t pos = find_alive(key, hash);
+    if (pos == npos) { // key not present
+        return false;
+    }
+
+    node_id id = _index.node(pos);
+    if (_nodes[id].entry.size() + data.size() > _max_size) {
+        return false;
+    }
+
+    _wheel.cancel(id);
+    evict_for(data.size(), id);
+
+    clock_node &node = _nodes[id];
+    node.entry.append_value(data);
+    node.referenced.store(true, std::memory_order_relaxed);
+    _act_size += data.size();
+    if (node.entry.expire != 0) {
+        _wheel.schedule(id, node.entry.expire);
+    }
+    return true;
+}
+
+// See Storage.h
+bool ClockLRU::Get(StringView key, std::string &value) const {
+    uint32_t hash = HashIndex::hash(key);
+    read_lock lock(_lock);
+    size_t pos = find(key, hash);
+    if (pos == npos) { // key not found
+        return false;
+    }
+
+    const clock_node &node = _nodes[_index.node(pos)];
+    if (TimingWheel::expired(node.entry.expire)) {
+        return false;
+    }
+
+    touch(node);
+    StringView stored = node.entry.value();
+    value.assign(stored.data(), stored.size());
+    return true;
+}
+
+// See Storage.h
+bool ClockLRU::Get(StringView key, const Reader &reader) const {
+    uint32_t hash = HashIndex::hash(key);
+    read_lock lock(_lock);
+    size_t pos = find(key, hash);
+    if (pos == npos) { // key not found
+        return false;
+    }
+
+    const clock_node &node = _nodes[_index.node(pos)];
+    if (TimingWheel::expired(node.entry.expire)) {
+        return false;
+    }
+
+    touch(node);
+    reader(node.entry.value(), node.entry.flags);
+    return true;
+}
+
+// See Storage.h
+bool ClockLRU::Pin(StringView key, std::size_t min_size, const PinReader &reader) const {
+    uint32_t hash = HashIndex::hash(key);
+    read_lock lock(_lock);
+    size_t pos = find(key, hash);
+    if (pos == npos) { // key not found
+        return false;
+    }
+
+    const clock_node &node = _nodes[_index.node(pos)];
+    if (TimingWheel::expired(node.entry.expire)) {
+        return false;
+    }
+
+    touch(node);
+    const Entry &entry = node.entry;
+    reader(entry.value(), entry.flags, entry.value().size() < min_size ? nullptr : entry.pin());
+    return true;
+}
+
+// See Storage.h
+std::size_t ClockLRU::GetMany(const std::vector<StringView> &keys, std::size_t min_size,
+                              const BatchReader &reader) const {
+    std::vector<uint32_t> hashes(keys.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+        hashes[i] = HashIndex::hash(keys[i]);
+    }
+
+    read_lock lock(_lock);
+    for (size_t i = 0; i < keys.size() && i < HashIndex::prefetch_distance; i++) {
+        _index.prefetch(hashes[i]);
+    }
+
+    std::size_t found = 0;
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (i + HashIndex::prefetch_distance < keys.size()) {
+            _index.prefetch(hashes[i + HashIndex::prefetch_distance]);
+        }
+
+        size_t pos = find(keys[i], hashes[i]);
+        if (pos == npos || TimingWheel::expired(_nodes[_index.node(pos)].entry.expire)) { // key not found
+            continue;
+        }
+
+        const clock_node &node = _nodes[_index.node(pos)];
+        touch(node);
+        const Entry &entry = node.entry;
+        reader(i, entry.value(), entry.flags, entry.value().size() < min_size ? nullptr : entry.pin());
+        found++;
+    }
+    return found;
+}
+
+// See ClockLRU.h
+std::size_t ClockLRU::Size() const {
+    read_lock lock(_lock);
+    return _act_size;
+}
+
+// See ClockLRU.h
+void ClockLRU::Expire() {
+    write_lock lock(_lock);
+    expire();
+}
+
+// See ClockLRU.h
+bool ClockLRU::put(StringView key, StringView value, uint32_t flags, uint64_t expire, uint32_t hash, size_t pos) {
+    if (key.size() + value.size() > _max_size) { // new size is really big
+        return false;
+    }
+
+    // Entry would be invisible right away, no reason to store it
+    if (TimingWheel::expired(expire)) {
+        if (pos != npos) {
+            remove(pos);
+        }
+        return true;
+    }
+
+    node_id id;
+    if (pos != npos) { // key exists, override
+        id = _index.node(pos);
+
+        _act_size -= _nodes[id].entry.value().size();
+        _wheel.cancel(id);
+        evict_for(value.size(), id);
+
+        clock_node &node = _nodes[id];
+        node.entry.assign_value(value);
+        node.entry.flags = flags;
+        node.entry.expire = expire;
+        node.referenced.store(true, std::memory_order_relaxed);
+        _act_size += value.size();
+    } else {
+        evict_for(key.size() + value.size(), npos);
+
+        if (_free.empty()) {
+            _nodes.emplace_back();
+            id = node_id(_nodes.size() - 1);
+        } else {
+            id = _free.back();
+            _free.pop_back();
+        }
+
+        // New node starts unreferenced: it has to be read at least once to survive the next sweep, so
+        // one-off writes don't push out the working set
+        clock_node &node = _nodes[id];
+        node.entry.assign(key, value);
+        node.entry.flags = flags;
+        node.entry.expire = expire;
+        node.hash = hash;
+        node.used = true;
+        node.referenced.store(false, std::memory_order_relaxed);
+        _act_size += key.size() + value.size();
+        _index.insert(id, hash);
+    }
+
+    if (expire != 0) {
+        _wheel.schedule(id, expire);
+    }
+    return true;
+}
+
+// See ClockLRU.h
+size_t ClockLRU::find(StringView key, uint32_t hash) const {
+    return _index.find(key, hash, [this](node_id id) { return _nodes[id].entry.key(); });
+}
+
+// See ClockLRU.h
+size_t ClockLRU::find_alive(StringView key, uint32_t hash) {
+    size_t pos = find(key, hash);
+    if (pos != npos && TimingWheel::expired(_nodes[_index.node(pos)].entry.expire)) {
+        remove(pos);
+        return npos;
+    }
+    return pos;
+}
+
+// See ClockLRU.h
+void ClockLRU::expire() {
+    _wheel.advance(TimingWheel::now(), [this](node_id id) {
+        const clock_node &node = _nodes[id];
+        remove(find(node.entry.key(), node.hash));
+    });
+}
+
+// See ClockLRU.h
+void ClockLRU::remove(size_t pos) {
+    node_id id = _index.node(pos);
+    clock_node &node = _nodes[id];
+
+    _act_size -= node.entry.size();
+    _index.erase(pos);
+    _wheel.cancel(id);
+
+    node.entry.clear();
+    node.used = false;
+    _free.push_back(id);
+}
+
+// See ClockLRU.h
+void ClockLRU::evict_for(std::size_t need, node_id keep) {
+    if (_act_size + need > _max_size) {
+        expire();
+    }
+
+    while (_act_size + need > _max_size) {
+        // Nothing could be evicted besides the node being updated
+        if (_index.size() == 0 || (_index.size() == 1 && keep != npos)) {
+            return;
+        }
+
+        node_id id = _hand;
+        _hand = (_hand + 1 < _nodes.size()) ? _hand + 1 : 0;
+
+        clock_node &node = _nodes[id];
+        if (!node.used || id == keep) {
+            continue;
+        }
+
+        // Referenced nodes get second chance
+        if (node.referenced.load(std::memory_order_relaxed)) {
+            node.referenced.store(false, std::memory_order_relaxed);
+            continue;
+        }
+
+        remove(find(node.entry.key(), node.hash));
+    }
+}
+
+} // namespace Backend
+} // namespace Afina
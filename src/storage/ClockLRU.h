@@ -0,0 +1,164 @@
+#ifndef AFINA_STORAGE_CLOCK_LRU_H
+#define AFINA_STORAGE_CLOCK_LRU_H
+
+#include <atomic>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <pthread.h>
+
+#include <afina/Storage.h>
+
+#include "Entry.h"
+#include "HashIndex.h"
+#include "Sweeper.h"
+#include "TimingWheel.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Approximate LRU with concurrent readers
+ * Recency is tracked with CLOCK algorithm: instead of moving node to the list head every read just sets
+ * node "referenced" bit. On eviction clock hand sweeps over the node pool, clearing referenced bits and
+ * evicting first node which wasn't referenced since the previous sweep. Nodes read often survive, nodes
+ * nobody touched go away, which is close to the true LRU order.
+ *
+ * As reads don't change anything besides atomic bit, Get is done under shared lock and readers never
+ * block each other. Writes are exclusive.
+ *
+ * Expired entries are hidden from readers right away, but memory is reclaimed only under exclusive lock:
+ * by writes touching the key, by eviction before the clock hand starts and by background sweeper.
+ */
+class ClockLRU : public Afina::Storage {
+public:
+    ClockLRU(size_t max_size = 1024);
+    ~ClockLRU();
+
+    // Starts background reclaiming of expired entries
+    void Start() override;
+
+    // Stops background reclaiming of expired entries
+    void Stop() override;
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) const override;
+
+    // Implements Afina::Storage interface
+    bool Put(StringView key, StringView value, uint32_t flags, int32_t ttl) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(StringView key, StringView value, uint32_t flags, int32_t ttl) override;
+
+    // Implements Afina::Storage interface
+    bool Set(StringView key, StringView value, uint32_t flags, int32_t ttl) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(StringView key) override;
+
+    // Implements Afina::Storage interface
+    bool Get(StringView key, std::string &value) const override;
+
+    // Implements Afina::Storage interface
+    bool Append(StringView key, StringView data) override;
+
+    // Implements Afina::Storage interface, reader is called under the shared lock
+    bool Get(StringView key, const Reader &reader) const override;
+
+    // Implements Afina::Storage interface, values kept in the heap are pinned
+    bool Pin(StringView key, std::size_t min_size, const PinReader &reader) const override;
+
+    // Implements Afina::Storage interface, whole batch is looked up under the shared lock taken once
+    std::size_t GetMany(const std::vector<StringView> &keys, std::size_t min_size,
+                        const BatchReader &reader) const override;
+
+    // Number of bytes (keys + values) currently stored, including expired entries not reclaimed yet
+    std::size_t Size() const;
+
+    // Removes all entries which expiration time has passed
+    void Expire();
+
+private:
+    using node_id = HashIndex::node_id;
+    static const node_id npos = HashIndex::npos;
+
+    // Cache node, never moves in memory once created
+    struct clock_node {
+        clock_node() : hash(0), used(false), referenced(false) {}
+
+        Entry entry;
+        uint32_t hash;
+
+        // False for nodes in the free list
+        bool used;
+
+        // Set by readers, cleared by clock hand
+        mutable std::atomic<bool> referenced;
+    };
+
+    // Marks node as recently used, skips the store if bit is set already to keep cache line shared
+    static void touch(const clock_node &node) {
+        if (!node.referenced.load(std::memory_order_relaxed)) {
+            node.referenced.store(true, std::memory_order_relaxed);
+        }
+    }
+
+    // Inserts or updates element, pos is current index position of the key or npos if key is absent
+    bool put(StringView key, StringView value, uint32_t flags, uint64_t expire, uint32_t hash, size_t pos);
+
+    // Returns index position of the given key or npos if key is absent
+    size_t find(StringView key, uint32_t hash) const;
+
+    // Same as find, but expired entry gets removed and reported as absent
+    size_t find_alive(StringView key, uint32_t hash);
+
+    // Same as Expire, but lock must be held already
+    void expire();
+
+    // Removes given element from index and pool
+    void remove(size_t pos);
+
+    // Sweeps clock hand until extra need bytes fits into the cache. Node keep is never evicted
+    void evict_for(std::size_t need, node_id keep);
+
+    // Maximum number of bytes could be stored in this cache.
+    std::size_t _max_size;
+    std::size_t _act_size;
+
+    // Pool of all nodes, deque never relocates existing elements so atomics stay in place
+    std::deque<clock_node> _nodes;
+
+    // Free positions in the pool
+    std::vector<node_id> _free;
+
+    // Position of the clock hand in the pool
+    node_id _hand;
+
+    HashIndex _index;
+
+    // Expiration times of nodes with time to live
+    TimingWheel _wheel;
+
+    // Shared for reads, exclusive for everything else
+    mutable pthread_rwlock_t _lock;
+
+    Sweeper _sweeper;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_CLOCK_LRU_H
@@ -0,0 +1,154 @@
+#include "Entry.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace Afina {
+namespace Backend {
+
+// See Entry.h
+Entry::Entry(Entry &&other) noexcept
+    : expire(other.expire), flags(other.flags), _key_size(other._key_size), _value_size(other._value_size),
+      _capacity(other._capacity) {
+    if (is_inline()) {
+        std::memcpy(_inline, other._inline, size());
+    } else {
+        _heap = other._heap;
+    }
+
+    other._key_size = other._value_size = 0;
+    other._capacity = inline_size;
+}
+
+// See Entry.h
+Entry &Entry::operator=(Entry &&other) noexcept {
+    if (this == &other) {
+        return *this;
+    }
+
+    clear();
+    expire = other.expire;
+    flags = other.flags;
+    _key_size = other._key_size;
+    _value_size = other._value_size;
+    _capacity = other._capacity;
+    if (is_inline()) {
+        std::memcpy(_inline, other._inline, size());
+    } else {
+        _heap = other._heap;
+    }
+
+    other._key_size = other._value_size = 0;
+    other._capacity = inline_size;
+    return *this;
+}
+
+// See Entry.h
+char *Entry::prepare(StringView key, size_t value_size) {
+    _key_size = _value_size = 0;
+    reserve(key.size() + value_size);
+
+    std::memcpy(data(), key.data(), key.size());
+    _key_size = uint32_t(key.size());
+    _value_size = uint32_t(value_size);
+    return data() + _key_size;
+}
+
+// See Entry.h
+void Entry::assign(StringView key, StringView value) {
+    _key_size = _value_size = 0;
+    reserve(key.size() + value.size());
+
+    std::memcpy(data(), key.data(), key.size());
+    std::memcpy(data() + key.size(), value.data(), value.size());
+    _key_size = uint32_t(key.size());
+    _value_size = uint32_t(value.size());
+}
+
+// See Entry.h
+void Entry::assign_value(StringView value) {
+    _value_size = 0;
+    reserve(_key_size + value.size());
+
+    std::memcpy(data() + _key_size, value.data(), value.size());
+    _value_size = uint32_t(value.size());
+}
+
+// See Entry.h
+void Entry::append_value(StringView value) {
+    reserve(size() + value.size());
+
+    std::memcpy(data() + size(), value.data(), value.size());
+    _value_size += uint32_t(value.size());
+}
+
+// See Entry.h
+void Entry::clear() {
+    if (!is_inline()) {
+        release(_heap);
+    }
+
+    _key_size = _value_size = 0;
+    _capacity = inline_size;
+}
+
+// See Entry.h
+std::shared_ptr<const void> Entry::pin() const {
+    if (is_inline()) {
+        return nullptr;
+    }
+
+    header(_heap)->refs.fetch_add(1, std::memory_order_relaxed);
+    return std::shared_ptr<const void>(_heap, [](const void *heap) { release(static_cast<const char *>(heap)); });
+}
+
+// See Entry.h
+char *Entry::allocate(size_t capacity) {
+    char *memory = static_cast<char *>(std::malloc(sizeof(std::max_align_t) + capacity));
+    if (memory == nullptr) {
+        throw std::bad_alloc();
+    }
+
+    heap_header *h = new (memory) heap_header;
+    h->refs.store(1, std::memory_order_relaxed);
+    return memory + sizeof(std::max_align_t);
+}
+
+// See Entry.h
+void Entry::release(const char *heap) {
+    heap_header *h = header(heap);
+    if (h->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        h->~heap_header();
+        std::free(h);
+    }
+}
+
+// See Entry.h
+void Entry::reserve(size_t need) {
+    // Pins are taken under the storage lock, so the only reference can't become shared meanwhile
+    bool shared = !is_inline() && header(_heap)->refs.load(std::memory_order_acquire) > 1;
+    bool fits = !shared && need <= _capacity && (is_inline() || need > _capacity / 2);
+    if (fits) {
+        return;
+    }
+
+    if (need <= inline_size) { // heap buffer is too large or shared, move content back inline
+        char *heap = _heap;
+        std::memcpy(_inline, heap, size());
+        release(heap);
+        _capacity = inline_size;
+        return;
+    }
+
+    char *buffer = allocate(need);
+    std::memcpy(buffer, data(), size());
+    if (!is_inline()) {
+        release(_heap);
+    }
+    _heap = buffer;
+    _capacity = uint32_t(need);
+}
+
+} // namespace Backend
+} // namespace Afina
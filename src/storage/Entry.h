@@ -0,0 +1,110 @@
+#ifndef AFINA_STORAGE_ENTRY_H
+#define AFINA_STORAGE_ENTRY_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include <afina/StringView.h>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Stored key/value pair
+ * Entry metadata (client flags, expiration time) lives inline next to the key/value bytes. Small pairs
+ * fit into the entry itself, larger ones take a single heap buffer holding both key and value, so
+ * metadata never costs an extra allocation and lookup touches at most one cache line besides the buffer.
+ *
+ * Heap buffer is reference counted, so value could be pinned and used outside of the storage lock. Entry
+ * never changes buffer which is pinned by someone else: it gets a copy instead, and pinned buffer is freed
+ * by the last unpin. Counter is atomic, pins could be released from any thread.
+ *
+ * Entry is embedded into storage nodes, whole structure is 64 bytes.
+ */
+class Entry {
+public:
+    Entry() : expire(0), flags(0), _key_size(0), _value_size(0), _capacity(inline_size) {}
+    Entry(Entry &&other) noexcept;
+    ~Entry() { clear(); }
+
+    // Takes content of the other entry, releasing own one
+    Entry &operator=(Entry &&other) noexcept;
+
+    Entry(const Entry &) = delete;
+    Entry &operator=(const Entry &) = delete;
+
+    inline StringView key() const { return StringView(data(), _key_size); }
+    inline StringView value() const { return StringView(data() + _key_size, _value_size); }
+
+    // Number of key and value bytes
+    inline size_t size() const { return size_t(_key_size) + _value_size; }
+
+    // Sets both key and value
+    void assign(StringView key, StringView value);
+
+    // Sets key and value of value_size bytes which content is undefined, returns value bytes to fill in
+    char *prepare(StringView key, size_t value_size);
+
+    // Replaces value keeping the key
+    void assign_value(StringView value);
+
+    // Adds data to the end of the value
+    void append_value(StringView data);
+
+    // Makes entry empty and releases all memory it holds
+    void clear();
+
+    // Keeps key and value bytes in place until the last copy of the returned pointer is gone, whatever
+    // happens to the entry. Returns empty pointer if entry is inline and can't be pinned
+    std::shared_ptr<const void> pin() const;
+
+    // Moment entry expires at as returned by TimingWheel::now(), 0 if it lives forever
+    uint64_t expire;
+
+    // Opaque client flags
+    uint32_t flags;
+
+private:
+    static const size_t inline_size = 40;
+
+    // Precedes heap buffer
+    struct heap_header {
+        std::atomic<uint32_t> refs;
+    };
+
+    static inline heap_header *header(const char *heap) {
+        return reinterpret_cast<heap_header *>(const_cast<char *>(heap) - sizeof(std::max_align_t));
+    }
+
+    // Allocates heap buffer of the given capacity with a single reference
+    static char *allocate(size_t capacity);
+
+    // Drops reference to the heap buffer, frees it once there are no references left
+    static void release(const char *heap);
+
+    inline bool is_inline() const { return _capacity <= inline_size; }
+    inline char *data() { return is_inline() ? _inline : _heap; }
+    inline const char *data() const { return is_inline() ? _inline : _heap; }
+
+    // Makes sure entry could hold size bytes keeping current content and could change it in place,
+    // releases memory if most of it would be unused
+    void reserve(size_t size);
+
+    uint32_t _key_size;
+    uint32_t _value_size;
+
+    // Bytes available for key and value
+    uint32_t _capacity;
+
+    union {
+        char _inline[inline_size];
+        char *_heap;
+    };
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_ENTRY_H
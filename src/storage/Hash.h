@@ -0,0 +1,68 @@
+#ifndef AFINA_STORAGE_HASH_H
+#define AFINA_STORAGE_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Hash function for storage keys
+ * 64 bit MurmurHash2 variant (MurmurHash64A). Works over raw bytes so the same value is produced no
+ * matter how key is represented by caller
+ */
+inline uint64_t hash_bytes(const char *data, size_t len) {
+    const uint64_t m = 0xc6a4a7935bd1e995ull;
+    const int r = 47;
+
+    uint64_t h = 0x8445d61a4e774912ull ^ (len * m);
+
+    const char *end = data + (len & ~size_t(7));
+    for (; data != end; data += 8) {
+        uint64_t k;
+        std::memcpy(&k, data, sizeof(k));
+
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+
+        h ^= k;
+        h *= m;
+    }
+
+    switch (len & 7) {
+    case 7:
+        h ^= uint64_t(uint8_t(data[6])) << 48;
+        // fallthrough
+    case 6:
+        h ^= uint64_t(uint8_t(data[5])) << 40;
+        // fallthrough
+    case 5:
+        h ^= uint64_t(uint8_t(data[4])) << 32;
+        // fallthrough
+    case 4:
+        h ^= uint64_t(uint8_t(data[3])) << 24;
+        // fallthrough
+    case 3:
+        h ^= uint64_t(uint8_t(data[2])) << 16;
+        // fallthrough
+    case 2:
+        h ^= uint64_t(uint8_t(data[1])) << 8;
+        // fallthrough
+    case 1:
+        h ^= uint64_t(uint8_t(data[0]));
+        h *= m;
+    }
+
+    h ^= h >> r;
+    h *= m;
+    h ^= h >> r;
+    return h;
+}
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_HASH_H
@@ -0,0 +1,89 @@
+#include "HashIndex.h"
+
+namespace Afina {
+namespace Backend {
+
+namespace {
+
+// Initial number of hash table cells, must be power of two
+const std::size_t initial_table_size = 16;
+
+} // namespace
+
+// See HashIndex.h
+HashIndex::HashIndex() : _table(initial_table_size, slot{npos, 0}), _used(0) {}
+
+// See HashIndex.h
+HashIndex::HashIndex(size_t capacity) : _table(table_size(capacity), slot{npos, 0}), _used(0) {}
+
+// See HashIndex.h
+size_t HashIndex::memory(size_t capacity) { return table_size(capacity) * sizeof(slot); }
+
+// See HashIndex.h
+void HashIndex::insert(node_id id, uint32_t hash) {
+    // Keep load factor below 3/4 so probe sequences stay short
+    if ((_used + 1) * 4 > _table.size() * 3) {
+        grow();
+    }
+
+    size_t mask = _table.size() - 1;
+    size_t pos = hash & mask;
+    while (_table[pos].node != npos) {
+        pos = (pos + 1) & mask;
+    }
+
+    _table[pos].node = id;
+    _table[pos].hash = hash;
+    _used++;
+}
+
+// Linear probing doesn't need tombstones: elements following erased one are shifted back to fill the hole
+// if their home position allows it
+void HashIndex::erase(size_t pos) {
+    size_t mask = _table.size() - 1;
+    size_t hole = pos;
+    for (size_t next = (hole + 1) & mask; _table[next].node != npos; next = (next + 1) & mask) {
+        size_t home = _table[next].hash & mask;
+
+        // Element stays if its home is cyclically within (hole, next]
+        bool stays = (hole <= next) ? (hole < home && home <= next) : (hole < home || home <= next);
+        if (!stays) {
+            _table[hole] = _table[next];
+            hole = next;
+        }
+    }
+
+    _table[hole].node = npos;
+    _used--;
+}
+
+// See HashIndex.h
+void HashIndex::grow() {
+    std::vector<slot> old(_table.size() * 2, slot{npos, 0});
+    old.swap(_table);
+
+    size_t mask = _table.size() - 1;
+    for (const slot &s : old) {
+        if (s.node == npos) {
+            continue;
+        }
+
+        size_t pos = s.hash & mask;
+        while (_table[pos].node != npos) {
+            pos = (pos + 1) & mask;
+        }
+        _table[pos] = s;
+    }
+}
+
+// See HashIndex.h
+size_t HashIndex::table_size(size_t capacity) {
+    size_t size = initial_table_size;
+    while (capacity * 4 > size * 3) {
+        size *= 2;
+    }
+    return size;
+}
+
+} // namespace Backend
+} // namespace Afina
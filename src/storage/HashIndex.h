@@ -0,0 +1,95 @@
+#ifndef AFINA_STORAGE_HASH_INDEX_H
+#define AFINA_STORAGE_HASH_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <afina/StringView.h>
+
+#include "Hash.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Open addressing index over node pool
+ * Maps keys to positions in some external node pool. Table uses linear probing, keeps load factor
+ * below 3/4 and doesn't need tombstones on erase. Keys themselves are owned by the pool, index only
+ * stores node position together with lower bits of the key hash so most of the probes don't touch nodes.
+ *
+ * Not thread safe.
+ */
+class HashIndex {
+public:
+    // Position in the node pool
+    using node_id = uint32_t;
+    static const node_id npos = UINT32_MAX;
+
+    // Batched lookups prefetch slots that many keys ahead of the one being probed
+    static const size_t prefetch_distance = 4;
+
+    HashIndex();
+
+    // Table sized for capacity nodes up front, it never grows unless more nodes are inserted
+    explicit HashIndex(size_t capacity);
+
+    // Bytes taken by the table sized for capacity nodes
+    static size_t memory(size_t capacity);
+
+    // Key hash as stored in the index
+    static inline uint32_t hash(StringView key) { return uint32_t(hash_bytes(key.data(), key.size())); }
+
+    /**
+     * Returns table position of the given key or npos if key is absent. key_of must map node_id to
+     * the StringView of node key
+     */
+    template <typename KeyOf> size_t find(StringView key, uint32_t hash, KeyOf key_of) const {
+        size_t mask = _table.size() - 1;
+        for (size_t pos = hash & mask;; pos = (pos + 1) & mask) {
+            const slot &s = _table[pos];
+            if (s.node == npos) {
+                return npos;
+            }
+            if (s.hash == hash && key_of(s.node) == key) {
+                return pos;
+            }
+        }
+    }
+
+    // Hints CPU to load table slot of the given hash, so find following a bit later doesn't wait for memory
+    inline void prefetch(uint32_t hash) const { __builtin_prefetch(&_table[hash & (_table.size() - 1)]); }
+
+    // Node stored in the given table position
+    node_id node(size_t pos) const { return _table[pos].node; }
+
+    // Adds node to the index, key must not be present yet
+    void insert(node_id id, uint32_t hash);
+
+    // Removes element at the given table position
+    void erase(size_t pos);
+
+    // Number of nodes in the index
+    size_t size() const { return _used; }
+
+private:
+    // Hash table cell
+    struct slot {
+        node_id node;
+        uint32_t hash;
+    };
+
+    void grow();
+
+    // Smallest table size keeping load factor of capacity nodes below 3/4
+    static size_t table_size(size_t capacity);
+
+    // Size is always power of two
+    std::vector<slot> _table;
+    std::size_t _used;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_HASH_INDEX_H
@@ -0,0 +1,254 @@
+#include "ShardedLRU.h"
+
+#include <cstdint>
+#include <string>
+
+#include "Hash.h"
+
+namespace Afina {
+namespace Backend {
+
+const size_t ShardedLRU::min_shard_size;
+
+// See ShardedLRU.h
+ShardedLRU::ShardedLRU(size_t max_size, size_t shards) : _shard_bits(0) {
+    while ((size_t(1) << _shard_bits) < shards) {
+        _shard_bits++;
+    }
+
+    // Small budget split too thin would reject all but the tiniest entries
+    while (_shard_bits > 0 && (max_size >> _shard_bits) < min_shard_size) {
+        _shard_bits--;
+    }
+
+    size_t count = size_t(1) << _shard_bits;
+    _shards.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        _shards.emplace_back(new shard(max_size / count));
+    }
+}
+
+// See Storage.h
+bool ShardedLRU::Put(const std::string &key, const std::string &value) {
+    shard &s = select(key);
+    std::unique_lock<std::mutex> lock(s.lock);
+    return s.lru.Put(key, value);
+}
+
+// See Storage.h
+bool ShardedLRU::PutIfAbsent(const std::string &key, const std::string &value) {
+    shard &s = select(key);
+    std::unique_lock<std::mutex> lock(s.lock);
+    return s.lru.PutIfAbsent(key, value);
+}
+
+// See Storage.h
+bool ShardedLRU::Set(const std::string &key, const std::string &value) {
+    shard &s = select(key);
+    std::unique_lock<std::mutex> lock(s.lock);
+    return s.lru.Set(key, value);
+}
+
+// See Storage.h
+bool ShardedLRU::Delete(const std::string &key) {
+    shard &s = select(key);
+    std::unique_lock<std::mutex> lock(s.lock);
+    return s.lru.Delete(key);
+}
+
+// See Storage.h
+bool ShardedLRU::Get(const std::string &key, std::string &value) const {
+    shard &s = select(key);
+    std::unique_lock<std::mutex> lock(s.lock);
+    return s.lru.Get(key, value);
+}
+
+// See Storage.h
+bool ShardedLRU::Put(StringView key, StringView value, uint32_t flags, int32_t ttl) {
+    shard &s = select(key);
+    std::unique_lock<std::mutex> lock(s.lock);
+    return s.lru.Put(key, value, flags, ttl);
+}
+
+// See Storage.h
+bool ShardedLRU::PutIfAbsent(StringView key, StringView value, uint32_t flags, int32_t ttl) {
+    shard &s = select(key);
+    std::unique_lock<std::mutex> lock(s.lock);
+    return s.lru.PutIfAbsent(key, value, flags, ttl);
+}
+
+// See Storage.h
+bool ShardedLRU::Set(StringView key, StringView value, uint32_t flags, int32_t ttl) {
+    shard &s = select(key);
+    std::unique_lock<std::mutex> lock(s.lock);
+    return s.lru.Set(key, value, flags, ttl);
+}
+
+// See Storage.h
+bool ShardedLRU::Delete(StringView key) {
+    shard &s = select(key);
+    std::unique_lock<std::mutex> lock(s.lock);
+    return s.lru.Delete(key);
+}
+
+// See Storage.h
+bool ShardedLRU::Get(StringView key, std::string &value) const {
+    shard &s = select(key);
+    std::unique_lock<std::mutex> lock(s.lock);
+    return s.lru.Get(key, value);
+}
+
+// See Storage.h
+bool ShardedLRU::Append(StringView key, StringView data) {
+    shard &s = select(key);
+    std::unique_lock<std::mutex> lock(s.lock);
+    return s.lru.Append(key, data);
+}
+
+// See Storage.h
+bool ShardedLRU::Get(StringView key, const Reader &reader) const {
+    shard &s = select(key);
+    std::unique_lock<std::mutex> lock(s.lock);
+    return s.lru.Get(key, reader);
+}
+
+// See ShardedLRU.h
+bool ShardedLRU::Pin(StringView key, std::size_t min_size, const PinReader &reader) const {
+    shard &s = select(key);
+    std::unique_lock<std::mutex> lock(s.lock);
+    return s.lru.Pin(key, min_size, reader);
+}
+
+// See ShardedLRU.h
+std::size_t ShardedLRU::GetMany(const std::vector<StringView> &keys, std::size_t min_size,
+                                const BatchReader &reader) const {
+    // Single hash gives both the shard and the key hash inside of it, see HashIndex::hash
+    std::vector<uint32_t> hashes(keys.size());
+    std::vector<uint32_t> owners(keys.size());
+    std::vector<uint32_t> counts(_shards.size() + 1, 0);
+    for (size_t i = 0; i < keys.size(); i++) {
+        uint64_t h = hash_bytes(keys[i].data(), keys[i].size());
+        hashes[i] = uint32_t(h);
+        owners[i] = uint32_t(shard_of(h));
+        counts[owners[i] + 1]++;
+    }
+
+    // Group keys by shard keeping their order inside of the group, group of shard s starts at counts[s]
+    for (size_t s = 1; s < counts.size(); s++) {
+        counts[s] += counts[s - 1];
+    }
+    std::vector<uint32_t> order(keys.size());
+    {
+        std::vector<uint32_t> next(counts.begin(), counts.end() - 1);
+        for (size_t i = 0; i < keys.size(); i++) {
+            order[next[owners[i]]++] = uint32_t(i);
+        }
+    }
+
+    // Values found stay here until all shards are probed: pinned ones are referenced, the rest is copied
+    // since entry could go away once the shard is unlocked
+    struct result {
+        result() : found(false), flags(0) {}
+
+        bool found;
+        uint32_t flags;
+        StringView value;
+        Holder holder;
+        std::string copy;
+    };
+    std::vector<result> results(keys.size());
+
+    // Shard is locked once for all of its keys and released before the next one, so writers of other shards
+    // are never blocked by the batch
+    std::size_t found = 0;
+    for (size_t s = 0; s < _shards.size(); s++) {
+        size_t first = counts[s], last = counts[s + 1];
+        if (first == last) {
+            continue;
+        }
+
+        const SimpleLRU &lru = _shards[s]->lru;
+        std::unique_lock<std::mutex> lock(_shards[s]->lock);
+        for (size_t j = first; j < last && j - first < HashIndex::prefetch_distance; j++) {
+            lru.prefetch(hashes[order[j]]);
+        }
+
+        for (size_t j = first; j < last; j++) {
+            size_t ahead = j + HashIndex::prefetch_distance;
+            if (ahead < last) {
+                lru.prefetch(hashes[order[ahead]]);
+            }
+
+            size_t i = order[j];
+            const Entry *entry = lru.lookup(keys[i], hashes[i]);
+            if (entry == nullptr) {
+                continue;
+            }
+
+            result &r = results[i];
+            r.found = true;
+            r.flags = entry->flags;
+            if (entry->value().size() >= min_size) {
+                r.holder = entry->pin();
+            }
+            if (r.holder) {
+                r.value = entry->value();
+            } else {
+                r.copy.assign(entry->value().data(), entry->value().size());
+            }
+            found++;
+        }
+    }
+
+    for (size_t i = 0; i < keys.size(); i++) {
+        result &r = results[i];
+        if (r.found) {
+            StringView value = r.holder ? r.value : StringView(r.copy);
+            reader(i, value, r.flags, std::move(r.holder));
+        }
+    }
+    return found;
+}
+
+// See ShardedLRU.h
+std::unique_ptr<Storage::Reservation> ShardedLRU::Reserve(WriteMode mode, StringView key, std::size_t size,
+                                                          uint32_t flags, int32_t ttl) {
+    shard &s = select(key);
+    return s.lru.reserve(mode, key, size, flags, ttl, &s.lock);
+}
+
+// See ShardedLRU.h
+void ShardedLRU::Start() {
+    _sweeper.Start([this]() { Expire(); });
+}
+
+// See ShardedLRU.h
+void ShardedLRU::Stop() { _sweeper.Stop(); }
+
+// See ShardedLRU.h
+void ShardedLRU::Expire() {
+    for (auto &s : _shards) {
+        std::unique_lock<std::mutex> lock(s->lock);
+        s->lru.Expire();
+    }
+}
+
+// Shard is selected by the high bits of the key hash mixed by fibonacci multiplier, so that keys
+// landing in the same shard still have well distributed low bits for per shard structures
+ShardedLRU::shard &ShardedLRU::select(StringView key) const {
+    if (_shard_bits == 0) {
+        return *_shards[0];
+    }
+    return *_shards[shard_of(hash_bytes(key.data(), key.size()))];
+}
+
+// See ShardedLRU.h
+std::size_t ShardedLRU::shard_of(uint64_t hash) const {
+    if (_shard_bits == 0) {
+        return 0;
+    }
+    return (hash * 0x9E3779B97F4A7C15ull) >> (64 - _shard_bits);
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,128 @@
+#ifndef AFINA_STORAGE_SHARDED_LRU_H
+#define AFINA_STORAGE_SHARDED_LRU_H
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <afina/Storage.h>
+
+#include "SimpleLRU.h"
+#include "Sweeper.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Lock striped LRU
+ * Keys are spread by hash across a number of independent SimpleLRU shards, each protected by
+ * its own lock and owning its own part of the byte budget. Operations on different shards never
+ * contend with each other, so throughput grows with number of worker threads instead of being
+ * serialized on a single global lock like in ThreadSafeSimplLRU.
+ *
+ * Eviction order is LRU inside of each shard only. As budget is split evenly, single key/value
+ * pair could not be larger than max_size / shards. Small budgets get fewer shards, so that each one
+ * has at least 4KB
+ */
+class ShardedLRU : public Afina::Storage {
+public:
+    /**
+     * @param max_size total number of bytes (keys + values) that could be stored
+     * @param shards number of independent shards, rounded up to the power of two, could be cut down for
+     * small max_size
+     */
+    ShardedLRU(size_t max_size = 1024, size_t shards = 16);
+    ~ShardedLRU() {}
+
+    // Starts background reclaiming of expired entries
+    void Start() override;
+
+    // Stops background reclaiming of expired entries
+    void Stop() override;
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) const override;
+
+    // Implements Afina::Storage interface
+    bool Put(StringView key, StringView value, uint32_t flags, int32_t ttl) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(StringView key, StringView value, uint32_t flags, int32_t ttl) override;
+
+    // Implements Afina::Storage interface
+    bool Set(StringView key, StringView value, uint32_t flags, int32_t ttl) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(StringView key) override;
+
+    // Implements Afina::Storage interface
+    bool Get(StringView key, std::string &value) const override;
+
+    // Implements Afina::Storage interface
+    bool Append(StringView key, StringView data) override;
+
+    // Implements Afina::Storage interface, reader is called under the shard lock
+    bool Get(StringView key, const Reader &reader) const override;
+
+    // Implements Afina::Storage interface, values kept in the heap are pinned
+    bool Pin(StringView key, std::size_t min_size, const PinReader &reader) const override;
+
+    // Implements Afina::Storage interface, keys are grouped by shard and each shard touched is locked once,
+    // one shard at a time. Reader is called once all shards are probed, not under any lock
+    std::size_t GetMany(const std::vector<StringView> &keys, std::size_t min_size,
+                        const BatchReader &reader) const override;
+
+    // Implements Afina::Storage interface, commit locks the shard of the key
+    std::unique_ptr<Reservation> Reserve(WriteMode mode, StringView key, std::size_t size, uint32_t flags,
+                                         int32_t ttl) override;
+
+    // Number of shards storage is split to
+    std::size_t Shards() const { return _shards.size(); }
+
+    // Removes expired entries from all shards, one shard at a time
+    void Expire();
+
+private:
+    // Smallest budget of a single shard
+    static const size_t min_shard_size = 4096;
+
+    // Single part of the storage
+    struct shard {
+        shard(size_t max_size) : lru(max_size) {}
+
+        std::mutex lock;
+        SimpleLRU lru;
+    };
+
+    // Selects shard responsible for the given key
+    shard &select(StringView key) const;
+
+    // Position of the shard responsible for the key with the given hash_bytes() hash
+    std::size_t shard_of(uint64_t hash) const;
+
+    // Number of high hash bits used to select shard
+    unsigned _shard_bits;
+
+    // All shards, each allocated separately so locks of different shards don't share cache lines
+    std::vector<std::unique_ptr<shard>> _shards;
+
+    Sweeper _sweeper;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_SHARDED_LRU_H
@@ -1,186 +1,442 @@
 #include "SimpleLRU.h"
-#include <iostream>
+
+#include <utility>
 
 namespace Afina {
 namespace Backend {
 
-// See MapBasedGlobalLockImpl.h
-bool SimpleLRU::Put(const std::string &key, const std::string &value) {
-    std::size_t add_val_size = value.size();
-    std::size_t add_size = add_val_size + key.size();
+// See SimpleLRU.h
+class SimpleLRU::reservation : public Storage::Reservation {
+public:
+    reservation(SimpleLRU &owner, std::mutex *lock, WriteMode mode, StringView key, std::size_t size,
+                uint32_t flags, int32_t ttl)
+        : _owner(owner), _lock(lock), _mode(mode), _ttl(ttl) {
+        _data = _entry.prepare(key, size);
+        _entry.flags = flags;
+    }
 
-    auto element = _lru_index.find(key);
+    char *data() override { return _data; }
 
-    if (element != this->_lru_index.end()) { // key exists, override
-        return Set(key, value);
-    }
-    else { // writing new key
-        return PutIfAbsent(key, value);
+    std::size_t size() const override { return _entry.value().size(); }
+
+    bool Commit() override {
+        if (_lock == nullptr) {
+            return _owner.publish(_mode, _entry, _ttl);
+        }
+
+        std::lock_guard<std::mutex> lock(*_lock);
+        return _owner.publish(_mode, _entry, _ttl);
     }
+
+private:
+    SimpleLRU &_owner;
+    std::mutex *_lock;
+    const WriteMode _mode;
+    const int32_t _ttl;
+
+    Entry _entry;
+    char *_data;
+};
+
+// See SimpleLRU.h
+SimpleLRU::SimpleLRU(size_t max_size)
+    : _max_size(max_size), _act_size(0), _free(npos), _lru_head(npos), _lru_tail(npos) {}
+
+// See Storage.h
+bool SimpleLRU::Put(const std::string &key, const std::string &value) {
+    return SimpleLRU::Put(StringView(key), StringView(value), 0, 0);
 }
 
-// See MapBasedGlobalLockImpl.h
+// See Storage.h
 bool SimpleLRU::PutIfAbsent(const std::string &key, const std::string &value) {
-    std::size_t add_val_size = value.size();
-    std::size_t add_size = add_val_size + key.size();
+    return SimpleLRU::PutIfAbsent(StringView(key), StringView(value), 0, 0);
+}
+
+// See Storage.h
+bool SimpleLRU::Set(const std::string &key, const std::string &value) {
+    uint32_t hash = HashIndex::hash(key);
+    size_t pos = find_alive(key, hash);
+    if (pos == npos) { // key not present
+        return false;
+    }
+
+    // Plain Set keeps flags and expiration time of the entry
+    const Entry &entry = _nodes[_index.node(pos)].entry;
+    return put(key, value, entry.flags, entry.expire, hash, pos);
+}
+
+// See Storage.h
+bool SimpleLRU::Delete(const std::string &key) { return SimpleLRU::Delete(StringView(key)); }
 
-    auto element = this->_lru_index.find(key);
+// See Storage.h
+bool SimpleLRU::Get(const std::string &key, std::string &value) const {
+    return SimpleLRU::Get(StringView(key), value);
+}
+
+// See Storage.h
+bool SimpleLRU::Put(StringView key, StringView value, uint32_t flags, int32_t ttl) {
+    uint32_t hash = HashIndex::hash(key);
+    return put(key, value, flags, TimingWheel::deadline(ttl), hash, find_alive(key, hash));
+}
 
-    if (element != this->_lru_index.end()) { // key exists
+// See Storage.h
+bool SimpleLRU::PutIfAbsent(StringView key, StringView value, uint32_t flags, int32_t ttl) {
+    uint32_t hash = HashIndex::hash(key);
+    if (find_alive(key, hash) != npos) { // key exists
         return false;
     }
-    else { // adding
-        if (this->_act_size + add_size <= this->_max_size) { // size is ok
-            if (!this->_lru_index.empty()) { // index is not empty
-                return new_head(key, value, add_size);
-            }
-            else {
-                return new_root(key, value, add_size);
-            }
-        }
-        else { // new size is too big
-            if (add_size > this->_max_size) { // new size is really big
-                return false;
-            }
-            else { // we can afford this
-                while (this->_act_size + add_size > this->_max_size) { // deleting tail elements
-                    this->Delete(this->_lru_head->next->key);
-                }
-
-                if (this->_lru_index.empty()) { // we deleted everything (creating new head)
-                    return new_root(key, value, add_size);
-                }
-                else { // creating new key-value
-                    return new_head(key, value, add_size);
-                }
-            }
-        }
+    return put(key, value, flags, TimingWheel::deadline(ttl), hash, npos);
+}
+
+// See Storage.h
+bool SimpleLRU::Set(StringView key, StringView value, uint32_t flags, int32_t ttl) {
+    uint32_t hash = HashIndex::hash(key);
+    size_t pos = find_alive(key, hash);
+    if (pos == npos) { // key not present
+        return false;
     }
+    return put(key, value, flags, TimingWheel::deadline(ttl), hash, pos);
 }
 
-// See MapBasedGlobalLockImpl.h
-bool SimpleLRU::Set(const std::string &key, const std::string &value) {
-    std::size_t add_val_size = value.size();
-    std::size_t add_size = add_val_size + key.size();
+// See Storage.h
+bool SimpleLRU::Delete(StringView key) {
+    size_t pos = find_alive(key, HashIndex::hash(key));
+    if (pos == npos) { // key not present
+        return false;
+    }
+
+    remove(pos);
+    return true;
+}
 
-    auto element = this->_lru_index.find(key);
+// See Storage.h
+bool SimpleLRU::Append(StringView key, StringView data) {
+    size_t pos = find_alive(key, HashIndex::hash(key));
+    if (pos == npos) { // key not present
+        return false;
+    }
 
-    if (element != this->_lru_index.end()) { // key exists, adding
-        lru_node& node = element->second;
-        std::size_t old_val_size = node.value.size();
+    node_id id = _index.node(pos);
+    if (_nodes[id].entry.size() + data.size() > _max_size) {
+        return false;
+    }
 
-        if (this->_act_size - old_val_size + add_val_size <= this->_max_size) { // value size is ok
-            node.value = value;
-            node_to_top(node);
-            this->_act_size -= old_val_size;
-            this->_act_size += add_val_size;
+    // Node being updated must survive eviction, so it is taken out of the wheel for a while
+    _wheel.cancel(id);
+    evict_for(data.size(), id);
 
-            return true;
-        }
-        else { // value is too big
-            if (add_size > this->_max_size) { // value is really big
-                return false;
-            }
-            else { // we can afford this
-                while (this->_act_size - old_val_size + add_val_size > this->_max_size) { // deleting tail elements
-                    this->Delete(this->_lru_head->next->key);
-                }
-
-                if (this->_lru_index.empty()) { // we deleted everything
-                    return new_root(key, value, add_size);
-                }
-                else { // we still have our node
-                    node.value = value;
-                    node_to_top(node);
-                    this->_act_size -= old_val_size;
-                    this->_act_size += add_val_size;
-
-                    return true;
-                }
-            }
-        }
+    lru_node &node = _nodes[id];
+    node.entry.append_value(data);
+    this->_act_size += data.size();
+    list_unlink(id);
+    list_append(id);
+    if (node.entry.expire != 0) {
+        _wheel.schedule(id, node.entry.expire);
+    }
+    return true;
+}
+
+// See Storage.h
+bool SimpleLRU::Get(StringView key, std::string &value) const {
+    size_t pos = find(key, HashIndex::hash(key));
+    if (pos == npos || TimingWheel::expired(_nodes[_index.node(pos)].entry.expire)) { // key not found
+        return false;
+    }
+
+    StringView stored = _nodes[_index.node(pos)].entry.value();
+    value.assign(stored.data(), stored.size());
+    return true;
+}
+
+// See Storage.h
+bool SimpleLRU::Get(StringView key, const Reader &reader) const {
+    const Entry *entry = lookup(key, HashIndex::hash(key));
+    if (entry == nullptr) { // key not found
+        return false;
     }
-    else { // key not present
+
+    reader(entry->value(), entry->flags);
+    return true;
+}
+
+// See Storage.h
+bool SimpleLRU::Pin(StringView key, std::size_t min_size, const PinReader &reader) const {
+    const Entry *entry = lookup(key, HashIndex::hash(key));
+    if (entry == nullptr) { // key not found
         return false;
     }
+
+    reader(entry->value(), entry->flags, entry->value().size() < min_size ? nullptr : entry->pin());
+    return true;
 }
 
-// See MapBasedGlobalLockImpl.h
-bool SimpleLRU::Delete(const std::string &key) {
-    auto element = this->_lru_index.find(key);
-    return false;
-    if (element != this->_lru_index.end()) { // key present
-        lru_node& node = element->second;
-        std::size_t el_size = node.key.size() + node.value.size();
-        node.prev->next = node.next;
-        if (node.next->prev == nullptr){ // if we deleting head
-            this->_lru_head = std::move(node.prev);
+// See Storage.h
+std::size_t SimpleLRU::GetMany(const std::vector<StringView> &keys, std::size_t min_size,
+                               const BatchReader &reader) const {
+    // Hashes are computed upfront, so slots of the following keys are loaded while current one is probed
+    std::vector<uint32_t> hashes(keys.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+        hashes[i] = HashIndex::hash(keys[i]);
+        if (i < HashIndex::prefetch_distance) {
+            prefetch(hashes[i]);
+        }
+    }
+
+    std::size_t found = 0;
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (i + HashIndex::prefetch_distance < keys.size()) {
+            prefetch(hashes[i + HashIndex::prefetch_distance]);
         }
-        else { // if we deleting regular node
-            node.next->prev = std::move(node.prev);
+
+        const Entry *entry = lookup(keys[i], hashes[i]);
+        if (entry != nullptr) {
+            reader(i, entry->value(), entry->flags, entry->value().size() < min_size ? nullptr : entry->pin());
+            found++;
         }
-        this->_lru_index.erase(key);
-        this->_act_size -= el_size;
+    }
+    return found;
+}
 
+// See SimpleLRU.h
+const Entry *SimpleLRU::lookup(StringView key, uint32_t hash) const {
+    size_t pos = find(key, hash);
+    if (pos == npos || TimingWheel::expired(_nodes[_index.node(pos)].entry.expire)) { // key not found
+        return nullptr;
+    }
+    return &_nodes[_index.node(pos)].entry;
+}
+
+// See Storage.h
+std::unique_ptr<Storage::Reservation> SimpleLRU::Reserve(WriteMode mode, StringView key, std::size_t size,
+                                                         uint32_t flags, int32_t ttl) {
+    return reserve(mode, key, size, flags, ttl, nullptr);
+}
+
+// See SimpleLRU.h
+std::unique_ptr<Storage::Reservation> SimpleLRU::reserve(WriteMode mode, StringView key, std::size_t size,
+                                                         uint32_t flags, int32_t ttl, std::mutex *lock) {
+    if (key.size() + size > this->_max_size) { // would never fit
+        return nullptr;
+    }
+    return std::unique_ptr<Reservation>(new reservation(*this, lock, mode, key, size, flags, ttl));
+}
+
+// See SimpleLRU.h
+void SimpleLRU::Expire() {
+    _wheel.advance(TimingWheel::now(), [this](node_id id) {
+        const Entry &entry = _nodes[id].entry;
+        remove(find(entry.key(), _nodes[id].hash));
+    });
+}
+
+// See SimpleLRU.h
+bool SimpleLRU::put(StringView key, StringView value, uint32_t flags, uint64_t expire, uint32_t hash, size_t pos) {
+    if (key.size() + value.size() > this->_max_size) { // new size is really big
+        return false;
+    }
+
+    // Entry would be invisible right away, no reason to store it
+    if (TimingWheel::expired(expire)) {
+        if (pos != npos) {
+            remove(pos);
+        }
         return true;
     }
-    else {
+
+    node_id id;
+    if (pos != npos) { // key exists, override
+        id = _index.node(pos);
+
+        // Node being updated must survive eviction, so only its value is requested and node is taken out
+        // of the wheel
+        this->_act_size -= _nodes[id].entry.value().size();
+        _wheel.cancel(id);
+        evict_for(value.size(), id);
+
+        lru_node &node = _nodes[id];
+        node.entry.assign_value(value);
+        node.entry.flags = flags;
+        node.entry.expire = expire;
+        this->_act_size += value.size();
+        list_unlink(id);
+    } else {
+        evict_for(key.size() + value.size(), npos);
+
+        id = node_alloc();
+        lru_node &node = _nodes[id];
+        node.entry.assign(key, value);
+        node.entry.flags = flags;
+        node.entry.expire = expire;
+        node.hash = hash;
+        this->_act_size += key.size() + value.size();
+        _index.insert(id, hash);
+    }
+
+    list_append(id);
+    if (expire != 0) {
+        _wheel.schedule(id, expire);
+    }
+    return true;
+}
+
+// See SimpleLRU.h
+bool SimpleLRU::publish(WriteMode mode, Entry &entry, int32_t ttl) {
+    if (mode == WriteMode::Append) { // existing entry grows, there is nothing to take from the reserved one
+        return SimpleLRU::Append(entry.key(), entry.value());
+    }
+
+    uint32_t hash = HashIndex::hash(entry.key());
+    size_t pos = find_alive(entry.key(), hash);
+    if (mode == WriteMode::PutIfAbsent && pos != npos) { // key exists
+        return false;
+    }
+    if (mode == WriteMode::Set && pos == npos) { // key not present
         return false;
     }
+    return put(entry, TimingWheel::deadline(ttl), hash, pos);
 }
 
-// See MapBasedGlobalLockImpl.h
-bool SimpleLRU::Get(const std::string &key, std::string &value) const { // const?
-    auto element = this->_lru_index.find(key);
-    if (element != this->_lru_index.end()) { // key present
-        lru_node& node = element->second;
-        value = node.value;
+// See SimpleLRU.h
+bool SimpleLRU::put(Entry &entry, uint64_t expire, uint32_t hash, size_t pos) {
+    std::size_t size = entry.size();
+    if (size > this->_max_size) { // new size is really big
+        return false;
+    }
 
+    // Entry would be invisible right away, no reason to store it
+    if (TimingWheel::expired(expire)) {
+        if (pos != npos) {
+            remove(pos);
+        }
         return true;
     }
-    else { // key not found
-        return false;
+
+    node_id id;
+    if (pos != npos) { // key exists, whole entry is replaced along with the same key
+        id = _index.node(pos);
+
+        this->_act_size -= _nodes[id].entry.size();
+        _wheel.cancel(id);
+        evict_for(size, id);
+        list_unlink(id);
+    } else {
+        evict_for(size, npos);
+
+        id = node_alloc();
+        _nodes[id].hash = hash;
+    }
+
+    lru_node &node = _nodes[id];
+    node.entry = std::move(entry);
+    node.entry.expire = expire;
+    this->_act_size += size;
+    if (pos == npos) {
+        _index.insert(id, hash);
     }
+
+    list_append(id);
+    if (expire != 0) {
+        _wheel.schedule(id, expire);
+    }
+    return true;
+}
+
+// See SimpleLRU.h
+size_t SimpleLRU::find(StringView key, uint32_t hash) const {
+    return _index.find(key, hash, [this](node_id id) { return _nodes[id].entry.key(); });
 }
 
-void SimpleLRU::node_to_top(lru_node& node) {
-    this->_lru_head->next = &node;
-    if (node.prev != nullptr) {
-        node.prev->next = node.next;
-        node.next->prev.swap(node.prev);
+// See SimpleLRU.h
+size_t SimpleLRU::find_alive(StringView key, uint32_t hash) {
+    size_t pos = find(key, hash);
+    if (pos != npos && TimingWheel::expired(_nodes[_index.node(pos)].entry.expire)) {
+        remove(pos);
+        return npos;
     }
-    else {
-        node.prev = std::move(node.next->prev);
-        node.next->prev = nullptr;
+    return pos;
+}
+
+// See SimpleLRU.h
+SimpleLRU::node_id SimpleLRU::node_alloc() {
+    if (_free != npos) {
+        node_id id = _free;
+        _free = _nodes[id].next;
+        return id;
     }
-    this->_lru_head.swap(node.prev);
+
+    _nodes.emplace_back();
+    return node_id(_nodes.size() - 1);
 }
 
-bool SimpleLRU::new_root(const std::string& key, const std::string& value, const std::size_t add_size) {
-    std::unique_ptr<lru_node> new_head(new lru_node);
-    new_head->key = key;
-    new_head->value = value;
-    new_head->next = new_head.get();
-    new_head->prev = nullptr;
-    this->_lru_head = std::move(new_head);
-    this->_act_size = add_size;
-    this->_lru_index.emplace(key, *(this->_lru_head));
+// See SimpleLRU.h
+void SimpleLRU::node_free(node_id id) {
+    lru_node &node = _nodes[id];
+    node.entry.clear();
 
-    return true;
+    node.prev = npos;
+    node.next = _free;
+    _free = id;
 }
 
-bool SimpleLRU::new_head(const std::string& key, const std::string& value, const std::size_t add_size) {
-    std::unique_ptr<lru_node> new_head(new lru_node);
-    new_head->key = key;
-    new_head->value = value;
-    new_head->next = this->_lru_head->next;
-    this->_lru_head->next = &(*new_head);
-    new_head->prev = std::move(this->_lru_head);
-    this->_lru_head = std::move(new_head);
-    this->_act_size += add_size;
-    this->_lru_index.emplace(key, *(this->_lru_head));
+// See SimpleLRU.h
+void SimpleLRU::list_unlink(node_id id) {
+    lru_node &node = _nodes[id];
+    if (node.prev == npos) {
+        _lru_head = node.next;
+    } else {
+        _nodes[node.prev].next = node.next;
+    }
 
-    return true;
+    if (node.next == npos) {
+        _lru_tail = node.prev;
+    } else {
+        _nodes[node.next].prev = node.prev;
+    }
+}
+
+// See SimpleLRU.h
+void SimpleLRU::list_append(node_id id) {
+    lru_node &node = _nodes[id];
+    node.prev = _lru_tail;
+    node.next = npos;
+
+    if (_lru_tail == npos) {
+        _lru_head = id;
+    } else {
+        _nodes[_lru_tail].next = id;
+    }
+    _lru_tail = id;
+}
+
+// See SimpleLRU.h
+void SimpleLRU::remove(size_t pos) {
+    node_id id = _index.node(pos);
+    const Entry &entry = _nodes[id].entry;
+
+    this->_act_size -= entry.size();
+    _index.erase(pos);
+    _wheel.cancel(id);
+    list_unlink(id);
+    node_free(id);
+}
+
+// See SimpleLRU.h
+void SimpleLRU::evict_for(std::size_t need, node_id keep) {
+    if (this->_act_size + need > this->_max_size) {
+        Expire();
+    }
+
+    while (this->_act_size + need > this->_max_size) {
+        node_id victim = _lru_head;
+        if (victim == keep) {
+            victim = _nodes[victim].next;
+        }
+        if (victim == npos) {
+            return;
+        }
+
+        remove(find(_nodes[victim].entry.key(), _nodes[victim].hash));
+    }
 }
 
 } // namespace Backend
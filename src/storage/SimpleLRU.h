@@ -1,35 +1,37 @@
 #ifndef AFINA_STORAGE_SIMPLE_LRU_H
 #define AFINA_STORAGE_SIMPLE_LRU_H
 
-#include <map>
+#include <cstdint>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <vector>
 
 #include <afina/Storage.h>
 
+#include "Entry.h"
+#include "HashIndex.h"
+#include "TimingWheel.h"
+
 namespace Afina {
 namespace Backend {
 
 /**
- * # Map based implementation
+ * # Hash table based implementation
+ * Index is an open addressing hash table with linear probing, nodes live in a pool and are linked
+ * into intrusive LRU list by their pool positions. So there is no allocation per node besides
+ * key/value payload which doesn't fit into the node Entry, lookup costs O(1).
+ *
+ * Entries with time to live are tracked by timing wheel: expired entries are hidden right away, writes
+ * touching them reclaim memory on access and the rest gets reclaimed by Expire(). Eviction calls Expire()
+ * first, so dead entries go away before any live one.
+ *
  * That is NOT thread safe implementaiton!!
  */
 class SimpleLRU : public Afina::Storage {
 public:
-    SimpleLRU(size_t max_size = 1024) : _max_size(max_size),
-                                        _act_size(0) {}
-
-    ~SimpleLRU() {
-        _lru_index.clear();
-        auto tail = _lru_head->next;
-        while (tail != _lru_head.get()) { // deleting from tail to the head
-            tail->prev.reset();
-            tail = tail->next;
-        }
-        tail->prev.reset();
-        _lru_head.reset();
-    }
+    SimpleLRU(size_t max_size = 1024);
+    ~SimpleLRU() {}
 
     // Implements Afina::Storage interface
     bool Put(const std::string &key, const std::string &value) override;
@@ -46,32 +48,126 @@ public:
     // Implements Afina::Storage interface
     bool Get(const std::string &key, std::string &value) const override;
 
+    // Implements Afina::Storage interface
+    bool Put(StringView key, StringView value, uint32_t flags, int32_t ttl) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(StringView key, StringView value, uint32_t flags, int32_t ttl) override;
+
+    // Implements Afina::Storage interface
+    bool Set(StringView key, StringView value, uint32_t flags, int32_t ttl) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(StringView key) override;
+
+    // Implements Afina::Storage interface
+    bool Get(StringView key, std::string &value) const override;
+
+    // Implements Afina::Storage interface
+    bool Append(StringView key, StringView data) override;
+
+    // Implements Afina::Storage interface
+    bool Get(StringView key, const Reader &reader) const override;
+
+    // Implements Afina::Storage interface, values kept in the heap are pinned
+    bool Pin(StringView key, std::size_t min_size, const PinReader &reader) const override;
+
+    // Implements Afina::Storage interface, hash table slots are prefetched ahead of lookups
+    std::size_t GetMany(const std::vector<StringView> &keys, std::size_t min_size,
+                        const BatchReader &reader) const override;
+
+    // Hints that key with the given hash is going to be looked up soon, see HashIndex::hash
+    inline void prefetch(uint32_t hash) const { _index.prefetch(hash); }
+
+    // Returns entry of the given key if it is present and alive, nullptr otherwise. Hash must be
+    // HashIndex::hash of the key, entry is valid until the next change of the storage
+    const Entry *lookup(StringView key, uint32_t hash) const;
+
+    // Implements Afina::Storage interface, value is received right into the entry stored later
+    std::unique_ptr<Reservation> Reserve(WriteMode mode, StringView key, std::size_t size, uint32_t flags,
+                                         int32_t ttl) override;
+
+    // Same as Reserve, but commit takes given lock if it isn't null. Reservation itself is taken without
+    // touching the cache, so no lock is needed to call this method
+    std::unique_ptr<Reservation> reserve(WriteMode mode, StringView key, std::size_t size, uint32_t flags,
+                                         int32_t ttl, std::mutex *lock);
+
+    // Number of bytes (keys + values) currently stored, including expired entries not reclaimed yet
+    std::size_t Size() const { return _act_size; }
+
+    // Removes all entries which expiration time has passed
+    void Expire();
+
 private:
+    // Reservation holding entry detached from the cache until commit
+    class reservation;
+
+    // Position in the node pool, used instead of pointers so pool could grow
+    using node_id = HashIndex::node_id;
+    static const node_id npos = HashIndex::npos;
+
     // LRU cache node
     using lru_node = struct lru_node {
-        std::string key;
-        std::string value;
-        std::unique_ptr<lru_node> prev;
-        lru_node* next;
+        // Key, value and metadata, empty for nodes in free list
+        Entry entry;
+
+        // Lower bits of the key hash, to avoid rehashing keys on table growth
+        uint32_t hash;
+
+        // Neighbours in the LRU list, or next free node for nodes in free list
+        node_id prev;
+        node_id next;
     };
 
-    void node_to_top(lru_node& node);
-    bool new_head(const std::string& key, const std::string& value, std::size_t add_size);
-    bool new_root(const std::string& key, const std::string& value, std::size_t add_size);
+    // Inserts or updates element, pos is current table position of the key or npos if key is absent
+    bool put(StringView key, StringView value, uint32_t flags, uint64_t expire, uint32_t hash, size_t pos);
+
+    // Stores entry prepared by reservation according to the write mode, entry content is taken
+    bool publish(WriteMode mode, Entry &entry, int32_t ttl);
+
+    // Same as put, but takes the whole entry instead of copying key and value
+    bool put(Entry &entry, uint64_t expire, uint32_t hash, size_t pos);
+
+    // Returns index position of the given key or npos if key is absent
+    size_t find(StringView key, uint32_t hash) const;
+
+    // Same as find, but expired entry gets removed and reported as absent
+    size_t find_alive(StringView key, uint32_t hash);
+
+    node_id node_alloc();
+    void node_free(node_id id);
+
+    void list_unlink(node_id id);
+    void list_append(node_id id);
+
+    // Removes given element from index, list and pool
+    void remove(size_t pos);
+
+    // Removes least recently used elements until extra need bytes fits into the cache. Node keep is never
+    // evicted
+    void evict_for(std::size_t need, node_id keep);
 
     // Maximum number of bytes could be stored in this cache.
     // i.e all (keys+values) must be less the _max_size
     std::size_t _max_size;
     std::size_t _act_size;
 
-    // Main storage of lru_nodes, elements in this list ordered descending by "freshness": in the head
-    // element that wasn't used for longest time.
-    //
-    // List owns all nodes
-    std::unique_ptr<lru_node> _lru_head;
+    // Pool of all nodes, both used and free
+    std::vector<lru_node> _nodes;
+
+    // Head of the free nodes list, linked through lru_node#next
+    node_id _free;
+
+    // LRU list, elements ordered by "freshness": in the head element that wasn't used for longest time, in the
+    // tail the most recently used one.
+    node_id _lru_head;
+    node_id _lru_tail;
+
+    // Index of nodes from list above
+    HashIndex _index;
 
-    // Index of nodes from list above, allows fast random access to elements by lru_node#key
-    std::map<const std::string, std::reference_wrapper<lru_node>> _lru_index;
+    // Expiration times of nodes with time to live
+    TimingWheel _wheel;
 };
 
 } // namespace Backend
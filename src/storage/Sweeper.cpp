@@ -0,0 +1,38 @@
+#include "Sweeper.h"
+
+namespace Afina {
+namespace Backend {
+
+// See Sweeper.h
+void Sweeper::Start(std::function<void()> sweep, std::chrono::milliseconds period) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (_running) {
+        return;
+    }
+
+    _running = true;
+    _thread = std::thread([this, sweep, period]() {
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (!_stopped.wait_for(lock, period, [this]() { return !_running; })) {
+            lock.unlock();
+            sweep();
+            lock.lock();
+        }
+    });
+}
+
+// See Sweeper.h
+void Sweeper::Stop() {
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _running = false;
+    }
+    _stopped.notify_all();
+
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,44 @@
+#ifndef AFINA_STORAGE_SWEEPER_H
+#define AFINA_STORAGE_SWEEPER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Background expiration thread
+ * Periodically calls given function until stopped, used by thread safe storages to reclaim expired
+ * entries nobody accesses anymore
+ */
+class Sweeper {
+public:
+    Sweeper() : _running(false) {}
+    ~Sweeper() { Stop(); }
+
+    /**
+     * Starts background thread, does nothing if it is running already
+     *
+     * @param sweep function to call, must do all required synchronization itself
+     * @param period delay between calls
+     */
+    void Start(std::function<void()> sweep, std::chrono::milliseconds period = std::chrono::milliseconds(1000));
+
+    // Stops background thread and waits for it to finish
+    void Stop();
+
+private:
+    std::mutex _mutex;
+    std::condition_variable _stopped;
+    bool _running;
+    std::thread _thread;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_SWEEPER_H
@@ -6,6 +6,7 @@
 #include <string>
 
 #include "SimpleLRU.h"
+#include "Sweeper.h"
 
 namespace Afina {
 namespace Backend {
@@ -20,6 +21,17 @@ public:
     ThreadSafeSimplLRU(size_t max_size = 1024) : SimpleLRU(max_size) {}
     ~ThreadSafeSimplLRU() {}
 
+    // Starts background reclaiming of expired entries
+    void Start() override {
+        _sweeper.Start([this]() {
+            std::unique_lock<std::mutex> lock(lc);
+            SimpleLRU::Expire();
+        });
+    }
+
+    // Stops background reclaiming of expired entries
+    void Stop() override { _sweeper.Stop(); }
+
     // see SimpleLRU.h
     bool Put(const std::string &key, const std::string &value) override {
         // TODO: sinchronization
@@ -60,9 +72,72 @@ public:
         return result;
     }
 
+    // see SimpleLRU.h
+    bool Put(StringView key, StringView value, uint32_t flags, int32_t ttl) override {
+        std::unique_lock<std::mutex> lock(lc);
+        return SimpleLRU::Put(key, value, flags, ttl);
+    }
+
+    // see SimpleLRU.h
+    bool PutIfAbsent(StringView key, StringView value, uint32_t flags, int32_t ttl) override {
+        std::unique_lock<std::mutex> lock(lc);
+        return SimpleLRU::PutIfAbsent(key, value, flags, ttl);
+    }
+
+    // see SimpleLRU.h
+    bool Set(StringView key, StringView value, uint32_t flags, int32_t ttl) override {
+        std::unique_lock<std::mutex> lock(lc);
+        return SimpleLRU::Set(key, value, flags, ttl);
+    }
+
+    // see SimpleLRU.h
+    bool Delete(StringView key) override {
+        std::unique_lock<std::mutex> lock(lc);
+        return SimpleLRU::Delete(key);
+    }
+
+    // see SimpleLRU.h
+    bool Get(StringView key, std::string &value) const override {
+        std::unique_lock<std::mutex> lock(lc);
+        return SimpleLRU::Get(key, value);
+    }
+
+    // see SimpleLRU.h
+    bool Append(StringView key, StringView data) override {
+        std::unique_lock<std::mutex> lock(lc);
+        return SimpleLRU::Append(key, data);
+    }
+
+    // see SimpleLRU.h, commit is done under the lock
+    std::unique_ptr<Reservation> Reserve(WriteMode mode, StringView key, std::size_t size, uint32_t flags,
+                                         int32_t ttl) override {
+        return SimpleLRU::reserve(mode, key, size, flags, ttl, &lc);
+    }
+
+    // see SimpleLRU.h, reader is called under the lock
+    bool Get(StringView key, const Reader &reader) const override {
+        std::unique_lock<std::mutex> lock(lc);
+        return SimpleLRU::Get(key, reader);
+    }
+
+    // see SimpleLRU.h, reader is called under the lock
+    bool Pin(StringView key, std::size_t min_size, const PinReader &reader) const override {
+        std::unique_lock<std::mutex> lock(lc);
+        return SimpleLRU::Pin(key, min_size, reader);
+    }
+
+    // see SimpleLRU.h, whole batch is looked up under the lock taken once
+    std::size_t GetMany(const std::vector<StringView> &keys, std::size_t min_size,
+                        const BatchReader &reader) const override {
+        std::unique_lock<std::mutex> lock(lc);
+        return SimpleLRU::GetMany(keys, min_size, reader);
+    }
+
 private:
     // TODO: sinchronization primitives
     mutable std::mutex lc;
+
+    Sweeper _sweeper;
 };
 
 } // namespace Backend
@@ -0,0 +1,101 @@
+#include "TimingWheel.h"
+
+namespace Afina {
+namespace Backend {
+
+const TimingWheel::node_id TimingWheel::npos;
+const uint64_t TimingWheel::tick_ms;
+
+// See TimingWheel.h
+TimingWheel::TimingWheel(size_t capacity)
+    : _buckets(levels << slot_bits, npos), _tick(now() / tick_ms), _count(0) {
+    _entries.reserve(capacity);
+}
+
+// See TimingWheel.h
+size_t TimingWheel::memory(size_t capacity) { return capacity * sizeof(entry); }
+
+// See TimingWheel.h
+void TimingWheel::schedule(node_id id, uint64_t expire_ms) {
+    if (id >= _entries.size()) {
+        _entries.resize(id + 1, entry{0, npos, npos, no_bucket});
+    }
+
+    // Round up, so node never gets reported before its expiration moment
+    _entries[id].expire = (expire_ms + tick_ms - 1) / tick_ms;
+    place(id);
+    _count++;
+}
+
+// See TimingWheel.h
+void TimingWheel::cancel(node_id id) {
+    if (id < _entries.size() && _entries[id].bucket != no_bucket) {
+        unlink(id);
+    }
+}
+
+// See TimingWheel.h
+void TimingWheel::place(node_id id) {
+    entry &e = _entries[id];
+    uint64_t delta = e.expire > _tick ? e.expire - _tick : 0;
+    uint64_t tick = _tick + delta;
+
+    unsigned level = 0;
+    while (level + 1 < levels && delta >= (uint64_t(1) << (slot_bits * (level + 1)))) {
+        level++;
+    }
+
+    // Too far in the future, park node in the farthest slot, it gets placed again once cascaded
+    uint64_t limit = uint64_t(1) << (slot_bits * levels);
+    if (delta >= limit) {
+        tick = _tick + limit - 1;
+    }
+
+    e.bucket = uint16_t((level << slot_bits) + ((tick >> (slot_bits * level)) & slot_mask));
+    e.prev = npos;
+    e.next = _buckets[e.bucket];
+    if (e.next != npos) {
+        _entries[e.next].prev = id;
+    }
+    _buckets[e.bucket] = id;
+}
+
+// See TimingWheel.h
+void TimingWheel::unlink(node_id id) {
+    entry &e = _entries[id];
+    if (e.prev == npos) {
+        _buckets[e.bucket] = e.next;
+    } else {
+        _entries[e.prev].next = e.next;
+    }
+
+    if (e.next != npos) {
+        _entries[e.next].prev = e.prev;
+    }
+
+    e.bucket = no_bucket;
+    _count--;
+}
+
+// Slot of level L spans 64^L ticks, so it has to be redistributed once all lower levels turned around
+void TimingWheel::cascade() {
+    for (unsigned level = 1; level < levels; level++) {
+        if ((_tick & ((uint64_t(1) << (slot_bits * level)) - 1)) != 0) {
+            return;
+        }
+
+        // Detach whole slot first: node parked because of the limit could land into the same slot again
+        size_t bucket = (level << slot_bits) + ((_tick >> (slot_bits * level)) & slot_mask);
+        node_id id = _buckets[bucket];
+        _buckets[bucket] = npos;
+
+        while (id != npos) {
+            node_id next = _entries[id].next;
+            place(id);
+            id = next;
+        }
+    }
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,133 @@
+#ifndef AFINA_STORAGE_TIMING_WHEEL_H
+#define AFINA_STORAGE_TIMING_WHEEL_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Hierarchical timing wheel
+ * Tracks expiration times of the storage nodes. There are several levels of 64 slots each, level 0 slot
+ * spans a single tick, every next level slot spans the whole previous level. Node is linked into slot
+ * by its expiration tick, once wheel turns around level slots of the upper level get cascaded down.
+ *
+ * Schedule and cancel are O(1), each node gets cascaded at most once per level, so the amortized cost of
+ * expiration is O(1) per node too.
+ *
+ * Not thread safe.
+ */
+class TimingWheel {
+public:
+    // Position in the node pool of the owning storage
+    using node_id = uint32_t;
+    static const node_id npos = UINT32_MAX;
+
+    // Wheel resolution in milliseconds
+    static const uint64_t tick_ms = 100;
+
+    // Current time in milliseconds of the monotonic clock, never returns 0
+    static inline uint64_t now() {
+        auto since = std::chrono::steady_clock::now().time_since_epoch();
+        return uint64_t(std::chrono::duration_cast<std::chrono::milliseconds>(since).count()) + 1;
+    }
+
+    // Converts time to live in seconds into expiration moment, 0 means never, see Storage.h for ttl semantics
+    static inline uint64_t deadline(int32_t ttl) {
+        if (ttl == 0) {
+            return 0;
+        }
+        return ttl < 0 ? 1 : now() + uint64_t(ttl) * 1000;
+    }
+
+    // Checks if moment returned by deadline() has passed
+    static inline bool expired(uint64_t deadline) { return deadline != 0 && deadline <= now(); }
+
+    // Room for nodes with id below capacity is reserved up front
+    explicit TimingWheel(size_t capacity = 0);
+
+    // Bytes taken by bookkeeping of capacity nodes, slots of the wheel itself are not included
+    static size_t memory(size_t capacity);
+
+    /**
+     * Makes wheel report node once expire_ms moment has passed, node must not be scheduled
+     *
+     * @param id node to track
+     * @param expire_ms expiration moment as returned by now()
+     */
+    void schedule(node_id id, uint64_t expire_ms);
+
+    // Stops tracking the node, does nothing for nodes not scheduled
+    void cancel(node_id id);
+
+    // Number of nodes scheduled
+    size_t size() const { return _count; }
+
+    /**
+     * Turns wheel up to the given moment, on_expire(node_id) gets called for every expired node. Node is
+     * not tracked by the wheel anymore once it is reported
+     */
+    template <typename F> void advance(uint64_t now_ms, F on_expire) {
+        uint64_t target = now_ms / tick_ms;
+        if (_count == 0 && _tick <= target) {
+            _tick = target + 1;
+            return;
+        }
+
+        for (; _tick <= target && _count > 0; _tick++) {
+            cascade();
+
+            size_t bucket = _tick & slot_mask;
+            node_id id;
+            while ((id = _buckets[bucket]) != npos) {
+                unlink(id);
+                on_expire(id);
+            }
+        }
+
+        if (_tick <= target) {
+            _tick = target + 1;
+        }
+    }
+
+private:
+    static const unsigned slot_bits = 6;
+    static const unsigned levels = 6;
+    static const uint64_t slot_mask = (uint64_t(1) << slot_bits) - 1;
+    static const uint16_t no_bucket = UINT16_MAX;
+
+    // Wheel bookkeeping of the single node
+    struct entry {
+        uint64_t expire;
+        node_id prev;
+        node_id next;
+        uint16_t bucket;
+    };
+
+    // Links node into the slot matching its expiration tick
+    void place(node_id id);
+
+    void unlink(node_id id);
+
+    // Moves nodes from upper levels slots started by the current tick down to lower levels
+    void cascade();
+
+    // Expiration ticks of all nodes, indexed by node_id
+    std::vector<entry> _entries;
+
+    // Heads of slot lists, level after level
+    std::vector<node_id> _buckets;
+
+    // Next tick to process
+    uint64_t _tick;
+
+    size_t _count;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_TIMING_WHEEL_H
@@ -0,0 +1,115 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include <afina/allocator/Error.h>
+#include <afina/allocator/Pointer.h>
+#include <afina/allocator/Simple.h>
+
+using namespace Afina::Allocator;
+
+// Usable capacity of the allocator under cache-like churn: area is kept full, every step replaces random
+// block by a new one, if it doesn't fit random blocks get evicted until it does. Block sizes drift from
+// phase to phase, so space freed by the old sizes has to be reused by new ones. Result is the share of
+// the area occupied by live payload, averaged over the run, number of blocks evicted and number of blocks
+// which didn't fit even into the empty area, with and without periodic defrag
+//
+// Usage: runAllocatorBenchmark [area_mb] [steps]
+
+namespace {
+
+struct item {
+    Pointer ptr;
+    size_t size;
+};
+
+// Tiny xorshift generator
+uint64_t next_random(uint64_t &state) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+void run(size_t area_size, long steps, long defrag_period) {
+    std::vector<char> area(area_size);
+    Simple allocator(area.data(), area.size());
+
+    std::vector<item> items;
+    uint64_t state = 88172645463325252ull;
+    size_t live = 0;
+    long evictions = 0;
+    long rejected = 0;
+    long defrags = 0;
+    double usage = 0;
+    std::chrono::nanoseconds defrag_time(0);
+
+    const long phases = 8;
+    for (long step = 0; step < steps; step++) {
+        // Each phase doubles typical block size: 32..64 bytes first, 4..8KB in the end
+        size_t base = size_t(32) << (step * phases / steps);
+        size_t size = base + next_random(state) % base;
+
+        if (!items.empty() && next_random(state) % 2 == 0) {
+            size_t victim = next_random(state) % items.size();
+            live -= items[victim].size;
+            allocator.free(items[victim].ptr);
+            items[victim] = items.back();
+            items.pop_back();
+        }
+
+        while (true) {
+            try {
+                items.push_back(item{allocator.alloc(size), size});
+                live += size;
+                break;
+            } catch (AllocError &) {
+                // Space is held by free blocks of other classes, nothing could be done
+                if (items.empty()) {
+                    rejected++;
+                    break;
+                }
+
+                size_t victim = next_random(state) % items.size();
+                live -= items[victim].size;
+                allocator.free(items[victim].ptr);
+                items[victim] = items.back();
+                items.pop_back();
+                evictions++;
+            }
+        }
+
+        if (defrag_period > 0 && step % defrag_period == defrag_period - 1) {
+            auto start = std::chrono::steady_clock::now();
+            allocator.defrag();
+            defrag_time += std::chrono::steady_clock::now() - start;
+            defrags++;
+        }
+
+        usage += double(live) / area_size;
+    }
+
+    std::cout << std::setw(14) << (defrag_period > 0 ? std::to_string(defrag_period) : std::string("never"))
+              << std::setw(12) << std::fixed << std::setprecision(1) << 100 * usage / steps << "%" << std::setw(12)
+              << evictions << std::setw(12) << rejected << std::setw(12) << defrags << std::setw(14)
+              << std::setprecision(3)
+              << (defrags > 0 ? std::chrono::duration<double, std::milli>(defrag_time).count() / defrags : 0.0)
+              << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    size_t area_mb = argc > 1 ? std::atoi(argv[1]) : 16;
+    long steps = argc > 2 ? std::atol(argv[2]) : 2000000;
+
+    std::cout << std::setw(14) << "defrag every" << std::setw(13) << "usable" << std::setw(12) << "evictions"
+              << std::setw(12) << "rejected" << std::setw(12) << "defrags" << std::setw(14) << "ms/defrag" << std::endl;
+    for (long period : {0L, 100000L, 10000L}) {
+        run(area_mb << 20, steps, period);
+    }
+    return 0;
+}
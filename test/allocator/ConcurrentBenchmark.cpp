@@ -0,0 +1,105 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <afina/allocator/Concurrent.h>
+#include <afina/allocator/Pointer.h>
+#include <afina/allocator/Simple.h>
+
+using namespace Afina::Allocator;
+
+// Multi-threaded alloc/free throughput: every worker keeps a window of live blocks of random size up to
+// 512 bytes, each step frees a random block and allocates a new one. Simple behind a global lock is
+// compared with Concurrent, result is total number of alloc/free pairs per second
+//
+// Usage: runConcurrentBenchmark [max_threads] [ops_per_thread]
+
+namespace {
+
+const size_t window = 256;
+
+// Tiny xorshift generator, each worker has its own one
+uint64_t next_random(uint64_t &state) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+// Simple allocator with a single lock around every call
+class Locked {
+public:
+    Locked(void *base, size_t size) : _simple(base, size) {}
+
+    Pointer alloc(size_t N) {
+        std::lock_guard<std::mutex> lock(_lock);
+        return _simple.alloc(N);
+    }
+
+    void free(Pointer &p) {
+        std::lock_guard<std::mutex> lock(_lock);
+        _simple.free(p);
+    }
+
+private:
+    std::mutex _lock;
+    Simple _simple;
+};
+
+template <typename A> double run(A &allocator, int threads, long ops) {
+    std::vector<std::thread> workers;
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&allocator, t, ops]() {
+            uint64_t state = 88172645463325252ull + t;
+            std::vector<Pointer> live(window);
+            for (Pointer &p : live) {
+                p = allocator.alloc(1 + next_random(state) % 512);
+            }
+
+            for (long i = 0; i < ops; i++) {
+                Pointer &p = live[next_random(state) % window];
+                allocator.free(p);
+                p = allocator.alloc(1 + next_random(state) % 512);
+            }
+
+            for (Pointer &p : live) {
+                allocator.free(p);
+            }
+        });
+    }
+
+    for (auto &w : workers) {
+        w.join();
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return threads * ops / elapsed.count();
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    int max_threads = argc > 1 ? std::atoi(argv[1]) : 8;
+    long ops = argc > 2 ? std::atol(argv[2]) : 1000000;
+
+    std::vector<char> area(size_t(256) << 20);
+    std::cout << std::setw(8) << "threads" << std::setw(16) << "locked" << std::setw(16) << "concurrent"
+              << std::endl;
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+        Locked locked(area.data(), area.size());
+        double locked_rate = run(locked, threads, ops);
+
+        Concurrent concurrent(area.data(), area.size());
+        double concurrent_rate = run(concurrent, threads, ops);
+
+        std::cout << std::setw(8) << threads << std::setw(16) << std::fixed << std::setprecision(0) << locked_rate
+                  << std::setw(16) << concurrent_rate << std::endl;
+    }
+    return 0;
+}
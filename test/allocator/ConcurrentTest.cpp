@@ -0,0 +1,97 @@
+#include "gtest/gtest.h"
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <afina/allocator/Concurrent.h>
+#include <afina/allocator/Error.h>
+#include <afina/allocator/Pointer.h>
+
+using namespace std;
+using namespace Afina::Allocator;
+
+static char area[8 << 20];
+
+TEST(ConcurrentTest, FreeThenAllocSameBlock) {
+    Concurrent a(area, sizeof(area));
+
+    Pointer p = a.alloc(100);
+    void *ptr = p.get();
+    a.free(p);
+    EXPECT_EQ(p.get(), nullptr);
+
+    // Freed block goes on top of the magazine
+    Pointer p2 = a.alloc(97);
+    EXPECT_EQ(p2.get(), ptr);
+    a.free(p2);
+}
+
+TEST(ConcurrentTest, NoMemory) {
+    char small[4096];
+    Concurrent a(small, sizeof(small));
+
+    vector<Pointer> ptrs;
+    try {
+        for (int i = 0; i < 100; i++) {
+            ptrs.push_back(a.alloc(100));
+        }
+        EXPECT_TRUE(false);
+    } catch (AllocError &e) {
+        EXPECT_EQ(e.getType(), AllocErrorType::NoMemory);
+    }
+
+    for (Pointer &p : ptrs) {
+        a.free(p);
+    }
+}
+
+TEST(ConcurrentTest, ManyThreads) {
+    Concurrent a(area, sizeof(area));
+
+    const int threads = 4;
+    vector<thread> workers;
+    vector<int> errors(threads, 0);
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&a, &errors, t]() {
+            vector<Pointer> live;
+            vector<size_t> sizes;
+            uint64_t state = 42 + t;
+            for (int i = 0; i < 20000; i++) {
+                state = state * 6364136223846793005ull + 1442695040888963407ull;
+                if (live.size() < 64 && (state >> 60) < 9) {
+                    size_t size = 1 + (state >> 33) % 500;
+                    live.push_back(a.alloc(size));
+                    sizes.push_back(size);
+                    memset(live.back().get(), t + 1, size);
+                } else if (!live.empty()) {
+                    size_t victim = (state >> 33) % live.size();
+                    const char *v = static_cast<const char *>(live[victim].get());
+                    for (size_t j = 0; j < sizes[victim]; j++) {
+                        errors[t] += v[j] != t + 1;
+                    }
+                    a.free(live[victim]);
+                    live[victim] = live.back();
+                    sizes[victim] = sizes.back();
+                    live.pop_back();
+                    sizes.pop_back();
+                }
+            }
+            for (Pointer &p : live) {
+                a.free(p);
+            }
+        });
+    }
+
+    for (auto &w : workers) {
+        w.join();
+    }
+
+    for (int t = 0; t < threads; t++) {
+        EXPECT_EQ(0, errors[t]);
+    }
+
+    // Blocks cached by exited threads are given back
+    EXPECT_NE(0, a.used());
+    a.defrag();
+    EXPECT_EQ(0, a.used());
+}
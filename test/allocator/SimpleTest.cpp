@@ -322,3 +322,89 @@ TEST(SimpleTest, ReallocGrow) {
     a.free(p);
     a.free(p2);
 }
+
+TEST(SimpleTest, FreeInvalid) {
+    Simple a(buf, sizeof(buf));
+
+    Pointer p = a.alloc(100);
+    Pointer copy = p;
+    a.free(p);
+
+    try {
+        a.free(copy);
+        EXPECT_TRUE(false);
+    } catch (AllocError &e) {
+        EXPECT_EQ(e.getType(), AllocErrorType::InvalidFree);
+    }
+}
+
+TEST(SimpleTest, SizeClassReuse) {
+    Simple a(buf, sizeof(buf));
+
+    Pointer p1 = a.alloc(100);
+    Pointer p2 = a.alloc(100);
+    void *ptr = p1.get();
+    a.free(p1);
+
+    // Any size of the same class gets the freed block back
+    Pointer p3 = a.alloc(97);
+    EXPECT_EQ(p3.get(), ptr);
+    EXPECT_NE(a.dump().find("class 104: 2 live, 0 free"), std::string::npos);
+
+    a.free(p2);
+    a.free(p3);
+}
+
+TEST(SimpleTest, DefragUpdatesCopies) {
+    Simple a(buf, sizeof(buf));
+
+    int size = 135;
+    Pointer p1 = a.alloc(size);
+    Pointer p2 = a.alloc(size);
+    Pointer copy = p2;
+    writeTo(p2, size);
+
+    void *ptr = p1.get();
+    a.free(p1);
+    a.defrag();
+
+    EXPECT_EQ(p2.get(), ptr);
+    EXPECT_EQ(copy.get(), ptr);
+    EXPECT_TRUE(isDataOk(copy, size));
+
+    a.free(p2);
+}
+
+// Free list block is not enough for alloc if there is no room left for the new descriptor slot
+TEST(SimpleTest, FreeListHitNeedsDescriptorRoom) {
+    // 16 bytes per 8 bytes block and 8 per descriptor
+    alignas(8) char area[72];
+    Simple a(area, sizeof(area));
+
+    Pointer p1 = a.alloc(8);
+    Pointer p2 = a.alloc(8);
+    writeTo(p2, 8);
+
+    // p1 moves to the top, its old block goes to the free list, table touches the top now
+    a.realloc(p1, 16);
+    writeTo(p1, 16);
+    EXPECT_NE(a.dump().find(" 0 untouched"), std::string::npos);
+
+    try {
+        Pointer p3 = a.alloc(8);
+        EXPECT_TRUE(false);
+    } catch (AllocError &e) {
+        EXPECT_EQ(e.getType(), AllocErrorType::NoMemory);
+    }
+    EXPECT_TRUE(isDataOk(p1, 16));
+    EXPECT_TRUE(isDataOk(p2, 8));
+
+    // Compaction gives free block back to the untouched area
+    a.defrag();
+    EXPECT_NE(a.dump().find(" 16 untouched"), std::string::npos);
+    EXPECT_TRUE(isDataOk(p1, 16));
+    EXPECT_TRUE(isDataOk(p2, 8));
+
+    a.free(p1);
+    a.free(p2);
+}
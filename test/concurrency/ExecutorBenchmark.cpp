@@ -0,0 +1,202 @@
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include <afina/Executor.h>
+
+// Task throughput of the work stealing executor compared with the pool of the same number of threads sharing
+// a single mutex protected deque of std::function, which is what executor used to be. Two loads:
+// - external: main thread submits tiny tasks one by one and waits for all of them to finish
+// - capture: same, but task carries 48 bytes of arguments, too much for std::function to keep inline
+// - nested: tasks spawn a binary tree of tasks from inside the pool, as a divide and conquer job does
+// Result is millions of tasks per second and number of heap allocations per task
+//
+// Usage: runExecutorBenchmark [threads] [tasks]
+
+namespace {
+
+// Fixed pool with one lock around the shared queue
+class Locked {
+public:
+    Locked(std::size_t threads) : _running(true) {
+        for (std::size_t i = 0; i < threads; i++) {
+            _threads.emplace_back(&Locked::OnRun, this);
+        }
+    }
+
+    ~Locked() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _running = false;
+        }
+        _empty_condition.notify_all();
+        for (auto &thread : _threads) {
+            thread.join();
+        }
+    }
+
+    template <typename F, typename... Types> bool Execute(F &&func, Types &&... args) {
+        auto exec = std::bind(std::forward<F>(func), std::forward<Types>(args)...);
+
+        std::unique_lock<std::mutex> lock(_mutex);
+        _tasks.push_back(exec);
+        _empty_condition.notify_one();
+        return true;
+    }
+
+private:
+    void OnRun() {
+        std::unique_lock<std::mutex> lock(_mutex);
+        for (;;) {
+            while (_running && _tasks.empty()) {
+                _empty_condition.wait(lock);
+            }
+            if (_tasks.empty()) {
+                return;
+            }
+
+            auto task = std::move(_tasks.front());
+            _tasks.pop_front();
+            lock.unlock();
+            task();
+            lock.lock();
+        }
+    }
+
+    std::mutex _mutex;
+    std::condition_variable _empty_condition;
+    std::deque<std::function<void()>> _tasks;
+    bool _running;
+    std::vector<std::thread> _threads;
+};
+
+std::atomic<long> allocations(0);
+std::atomic<long> done(0);
+
+void tick() { done.fetch_add(1, std::memory_order_relaxed); }
+
+void sum(long a, long b, long c, long d, long e, long f) {
+    done.fetch_add((a + b + c + d + e + f) / 21, std::memory_order_relaxed);
+}
+
+template <typename P> void spread(P &pool, int depth) {
+    done.fetch_add(1, std::memory_order_relaxed);
+    if (depth > 0) {
+        pool.Execute(spread<P>, std::ref(pool), depth - 1);
+        pool.Execute(spread<P>, std::ref(pool), depth - 1);
+    }
+}
+
+void await(long count) {
+    while (done.load() < count) {
+        std::this_thread::yield();
+    }
+}
+
+struct Result {
+    double rate;
+    double allocations;
+};
+
+template <typename P> Result external(P &pool, long tasks) {
+    done.store(0);
+    allocations.store(0);
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < tasks; i++) {
+        while (!pool.Execute(tick)) {
+            std::this_thread::yield();
+        }
+    }
+    await(tasks);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return {tasks / elapsed.count() / 1e6, double(allocations.load()) / tasks};
+}
+
+template <typename P> Result capture(P &pool, long tasks) {
+    done.store(0);
+    allocations.store(0);
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < tasks; i++) {
+        while (!pool.Execute(sum, 1l, 2l, 3l, 4l, 5l, 6l)) {
+            std::this_thread::yield();
+        }
+    }
+    await(tasks);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return {tasks / elapsed.count() / 1e6, double(allocations.load()) / tasks};
+}
+
+template <typename P> Result nested(P &pool, long tasks) {
+    int depth = 0;
+    while ((2l << (depth + 1)) - 1 <= tasks) {
+        depth++;
+    }
+    long count = (2l << depth) - 1;
+
+    done.store(0);
+    allocations.store(0);
+    auto start = std::chrono::steady_clock::now();
+    pool.Execute(spread<P>, std::ref(pool), depth);
+    await(count);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return {count / elapsed.count() / 1e6, double(allocations.load()) / count};
+}
+
+template <typename P> void run(P &pool, long tasks, Result *results) {
+    results[0] = external(pool, tasks);
+    results[1] = capture(pool, tasks);
+    results[2] = nested(pool, tasks);
+}
+
+} // namespace
+
+// Every allocation of the process is counted
+void *operator new(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    void *p = std::malloc(size);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+
+int main(int argc, char **argv) {
+    std::size_t threads = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : std::thread::hardware_concurrency();
+    long tasks = argc > 2 ? std::strtol(argv[2], nullptr, 10) : 1000000;
+    threads = std::max<std::size_t>(threads, 1);
+
+    Result locked[3], stealing[3];
+    {
+        Locked pool(threads);
+        run(pool, tasks, locked);
+    }
+    {
+        Afina::Executor pool("benchmark", threads, threads, 4096);
+        pool.Start();
+        run(pool, tasks, stealing);
+        pool.Stop(true);
+    }
+
+    const char *loads[] = {"external", "capture", "nested"};
+    std::cout << std::setw(10) << "load" << std::setw(14) << "locked, M/s" << std::setw(16) << "allocs/task"
+              << std::setw(16) << "stealing, M/s" << std::setw(16) << "allocs/task" << std::endl;
+    std::cout << std::fixed;
+    for (int i = 0; i < 3; i++) {
+        std::cout << std::setw(10) << loads[i] << std::setprecision(2) << std::setw(14) << locked[i].rate
+                  << std::setprecision(3) << std::setw(16) << locked[i].allocations << std::setprecision(2)
+                  << std::setw(16) << stealing[i].rate << std::setprecision(3) << std::setw(16)
+                  << stealing[i].allocations << std::endl;
+    }
+    return 0;
+}
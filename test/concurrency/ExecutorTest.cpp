@@ -0,0 +1,343 @@
+#include "gtest/gtest.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <thread>
+
+#include <afina/Executor.h>
+
+using namespace std;
+using namespace Afina;
+
+namespace {
+
+atomic<long> allocations(0);
+
+// Waits until predicate holds, gives up after a few seconds
+template <typename P> bool eventually(P predicate) {
+    for (int i = 0; i < 500; i++) {
+        if (predicate()) {
+            return true;
+        }
+        this_thread::sleep_for(chrono::milliseconds(10));
+    }
+    return predicate();
+}
+
+// Tasks waiting for the gate keep their threads busy until it opens
+class Gate {
+public:
+    Gate() : _open(false), _waiting(0) {}
+
+    void Wait() {
+        unique_lock<mutex> lock(_mutex);
+        _waiting++;
+        while (!_open) {
+            _condition.wait(lock);
+        }
+    }
+
+    void Open() {
+        lock_guard<mutex> lock(_mutex);
+        _open = true;
+        _condition.notify_all();
+    }
+
+    int waiting() {
+        lock_guard<mutex> lock(_mutex);
+        return _waiting;
+    }
+
+private:
+    mutex _mutex;
+    condition_variable _condition;
+    bool _open;
+    int _waiting;
+};
+
+void add(atomic<long> &sum, long value) { sum += value; }
+
+// Spawns whole binary tree of tasks of the given depth from inside the pool
+void spread(Executor &executor, atomic<long> &count, int depth) {
+    count++;
+    if (depth > 0) {
+        executor.Execute(spread, std::ref(executor), std::ref(count), depth - 1);
+        executor.Execute(spread, std::ref(executor), std::ref(count), depth - 1);
+    }
+}
+
+// Task constructed right in the queue slot
+class Job {
+public:
+    Job(atomic<long> &sum, long a, long b, long c, long d) : _sum(sum), _value(a + b + c + d) {}
+
+    void operator()() { _sum += _value; }
+
+private:
+    atomic<long> &_sum;
+    long _value;
+};
+
+// Sets the flag once destroyed without being executed
+class Flagged {
+public:
+    Flagged(atomic<long> &sum, atomic<bool> &dropped) : _sum(&sum), _dropped(&dropped) {}
+    Flagged(Flagged &&other) noexcept : _sum(other._sum), _dropped(other._dropped) { other._sum = nullptr; }
+    ~Flagged() {
+        if (_sum != nullptr) {
+            _dropped->store(true);
+        }
+    }
+
+    void operator()() {
+        (*_sum)++;
+        _sum = nullptr;
+    }
+
+private:
+    atomic<long> *_sum;
+    atomic<bool> *_dropped;
+};
+
+// Occupies the only thread of the pool with a task waiting for the gate and fills the queue of 2 slots
+void saturate(Executor &executor, Gate &gate, atomic<long> &sum) {
+    ASSERT_TRUE(executor.Execute([&gate]() { gate.Wait(); }));
+    ASSERT_TRUE(eventually([&]() { return gate.waiting() == 1; }));
+    ASSERT_TRUE(executor.Execute(add, std::ref(sum), 1));
+    ASSERT_TRUE(executor.Execute(add, std::ref(sum), 10));
+}
+
+} // namespace
+
+// Every allocation of the process is counted
+void *operator new(size_t size) {
+    allocations.fetch_add(1, memory_order_relaxed);
+    void *p = malloc(size);
+    if (p == nullptr) {
+        throw bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void *p) noexcept { free(p); }
+
+TEST(ExecutorTest, RejectsUnlessRunning) {
+    Executor executor("test", 2, 4, 16);
+    atomic<long> sum(0);
+    EXPECT_FALSE(executor.Execute(add, std::ref(sum), 1));
+
+    executor.Start();
+    EXPECT_EQ(executor.threads(), 2);
+    EXPECT_TRUE(executor.Execute(add, std::ref(sum), 1));
+
+    executor.Stop(true);
+    EXPECT_EQ(executor.threads(), 0);
+    EXPECT_FALSE(executor.Execute(add, std::ref(sum), 1));
+    EXPECT_EQ(sum.load(), 1);
+}
+
+TEST(ExecutorTest, ExecutesEverything) {
+    Executor executor("test", 2, 4, 100000);
+    executor.Start();
+
+    atomic<long> sum(0);
+    for (long i = 1; i <= 10000; i++) {
+        ASSERT_TRUE(executor.Execute(add, std::ref(sum), i));
+    }
+    executor.Stop(true);
+    EXPECT_EQ(sum.load(), 10000l * 10001 / 2);
+}
+
+TEST(ExecutorTest, NestedTasks) {
+    Executor executor("test", 4, 4, 16);
+    executor.Start();
+
+    // Nested tasks go to deques of pool threads which are unbounded
+    atomic<long> count(0);
+    ASSERT_TRUE(executor.Execute(spread, std::ref(executor), std::ref(count), 14));
+    EXPECT_TRUE(eventually([&]() { return count.load() == (1 << 15) - 1; }));
+    executor.Stop(true);
+    EXPECT_EQ(count.load(), (1 << 15) - 1);
+}
+
+TEST(ExecutorTest, StopCompletesQueuedTasks) {
+    Executor executor("test", 1, 1, 16);
+    executor.Start();
+
+    Gate gate;
+    atomic<long> sum(0);
+    ASSERT_TRUE(executor.Execute([&gate]() { gate.Wait(); }));
+    ASSERT_TRUE(eventually([&]() { return gate.waiting() == 1; }));
+    for (int i = 0; i < 10; i++) {
+        ASSERT_TRUE(executor.Execute(add, std::ref(sum), 1));
+    }
+
+    executor.Stop();
+    EXPECT_FALSE(executor.Execute(add, std::ref(sum), 1));
+    gate.Open();
+    executor.Stop(true);
+    EXPECT_EQ(sum.load(), 10);
+}
+
+TEST(ExecutorTest, QueueLimit) {
+    Executor executor("test", 1, 2, 3);
+    executor.Start();
+
+    Gate gate;
+    ASSERT_TRUE(executor.Execute([&gate]() { gate.Wait(); }));
+    ASSERT_TRUE(eventually([&]() { return gate.waiting() == 1; }));
+    ASSERT_TRUE(executor.Execute([&gate]() { gate.Wait(); }));
+    ASSERT_TRUE(eventually([&]() { return gate.waiting() == 2; }));
+    EXPECT_EQ(executor.threads(), 2);
+
+    // Both threads are busy, so shared queue fills up
+    atomic<long> sum(0);
+    for (int i = 0; i < 3; i++) {
+        EXPECT_TRUE(executor.Execute(add, std::ref(sum), 1));
+    }
+    EXPECT_FALSE(executor.Execute(add, std::ref(sum), 1));
+
+    gate.Open();
+    executor.Stop(true);
+    EXPECT_EQ(sum.load(), 3);
+}
+
+TEST(ExecutorTest, GrowsAndShrinks) {
+    Executor executor("test", 1, 4, 16, chrono::milliseconds(50));
+    executor.Start();
+    EXPECT_EQ(executor.threads(), 1);
+
+    // Each busy thread makes the next task start one more
+    Gate gate;
+    for (int i = 0; i < 4; i++) {
+        ASSERT_TRUE(executor.Execute([&gate]() { gate.Wait(); }));
+        ASSERT_TRUE(eventually([&]() { return gate.waiting() == i + 1; }));
+    }
+    EXPECT_EQ(executor.threads(), 4);
+
+    // Threads above low watermark finish once idle for long enough
+    gate.Open();
+    EXPECT_TRUE(eventually([&]() { return executor.threads() == 1; }));
+
+    atomic<long> sum(0);
+    ASSERT_TRUE(executor.Execute(add, std::ref(sum), 1));
+    executor.Stop(true);
+    EXPECT_EQ(sum.load(), 1);
+}
+
+TEST(ExecutorTest, NoAllocationPerTask) {
+    Executor executor("test", 1, 1, 1000);
+    executor.Start();
+
+    // Warm up so that pool thread has task nodes cached
+    atomic<long> sum(0);
+    for (int i = 0; i < 100; i++) {
+        ASSERT_TRUE(executor.Execute<Job>(std::ref(sum), 1, 0, 0, 0));
+    }
+    ASSERT_TRUE(eventually([&]() { return sum.load() == 100; }));
+
+    allocations.store(0);
+    for (int i = 0; i < 500; i++) {
+        ASSERT_TRUE(executor.Execute<Job>(std::ref(sum), 1, 2, 3, 4));
+        ASSERT_TRUE(executor.Execute(add, std::ref(sum), 1));
+    }
+    ASSERT_TRUE(eventually([&]() { return sum.load() == 100 + 500 * 11; }));
+    EXPECT_EQ(allocations.load(), 0);
+
+    executor.Stop(true);
+}
+
+TEST(ExecutorTest, OverflowReject) {
+    Executor executor("test", 1, 1, 2, chrono::milliseconds(1000), Executor::Overflow::kReject);
+    executor.Start();
+
+    Gate gate;
+    atomic<long> sum(0);
+    saturate(executor, gate, sum);
+    EXPECT_FALSE(executor.Execute(add, std::ref(sum), 100));
+    EXPECT_FALSE(executor.Execute(add, std::ref(sum), 100));
+
+    gate.Open();
+    executor.Stop(true);
+    EXPECT_EQ(sum.load(), 11);
+    Executor::Stats stats = executor.stats();
+    EXPECT_EQ(stats.rejected, 2);
+    EXPECT_EQ(stats.blocked + stats.timed_out + stats.ran_in_caller + stats.shed, 0);
+}
+
+TEST(ExecutorTest, OverflowBlock) {
+    Executor executor("test", 1, 1, 2, chrono::milliseconds(1000), Executor::Overflow::kBlock,
+                      chrono::milliseconds(50));
+    executor.Start();
+
+    Gate gate;
+    atomic<long> sum(0);
+    saturate(executor, gate, sum);
+
+    auto start = chrono::steady_clock::now();
+    EXPECT_FALSE(executor.Execute(add, std::ref(sum), 100));
+    EXPECT_GE(chrono::steady_clock::now() - start, chrono::milliseconds(50));
+
+    // Submitter waits until the queue gets a free slot
+    thread opener([&gate]() {
+        this_thread::sleep_for(chrono::milliseconds(10));
+        gate.Open();
+    });
+    EXPECT_TRUE(executor.Execute(add, std::ref(sum), 1000));
+    opener.join();
+
+    executor.Stop(true);
+    EXPECT_EQ(sum.load(), 1011);
+    Executor::Stats stats = executor.stats();
+    EXPECT_EQ(stats.blocked, 2);
+    EXPECT_EQ(stats.timed_out, 1);
+    EXPECT_EQ(stats.rejected + stats.ran_in_caller + stats.shed, 0);
+}
+
+TEST(ExecutorTest, OverflowRunInCaller) {
+    Executor executor("test", 1, 1, 2, chrono::milliseconds(1000), Executor::Overflow::kRunInCaller);
+    executor.Start();
+
+    Gate gate;
+    atomic<long> sum(0);
+    saturate(executor, gate, sum);
+
+    thread::id ran;
+    EXPECT_TRUE(executor.Execute([&ran]() { ran = this_thread::get_id(); }));
+    EXPECT_EQ(ran, this_thread::get_id());
+
+    gate.Open();
+    executor.Stop(true);
+    EXPECT_EQ(sum.load(), 11);
+    Executor::Stats stats = executor.stats();
+    EXPECT_EQ(stats.ran_in_caller, 1);
+    EXPECT_EQ(stats.rejected + stats.blocked + stats.timed_out + stats.shed, 0);
+}
+
+TEST(ExecutorTest, OverflowShedOldest) {
+    Executor executor("test", 1, 1, 2, chrono::milliseconds(1000), Executor::Overflow::kShedOldest);
+    executor.Start();
+
+    Gate gate;
+    atomic<long> sum(0);
+    saturate(executor, gate, sum);
+
+    // Oldest task adding 1 is dropped, dropped task is destroyed without execution
+    atomic<bool> dropped(false);
+    EXPECT_TRUE(executor.Execute<Flagged>(std::ref(sum), std::ref(dropped)));
+    EXPECT_FALSE(dropped.load());
+    EXPECT_TRUE(executor.Execute<Flagged>(std::ref(sum), std::ref(dropped)));
+    EXPECT_FALSE(dropped.load());
+    EXPECT_TRUE(executor.Execute(add, std::ref(sum), 100));
+    EXPECT_TRUE(dropped.load());
+
+    gate.Open();
+    executor.Stop(true);
+    EXPECT_EQ(sum.load(), 101);
+    Executor::Stats stats = executor.stats();
+    EXPECT_EQ(stats.shed, 3);
+    EXPECT_EQ(stats.rejected + stats.blocked + stats.timed_out + stats.ran_in_caller, 0);
+}
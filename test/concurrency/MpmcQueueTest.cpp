@@ -0,0 +1,116 @@
+#include "gtest/gtest.h"
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <afina/concurrency/MpmcQueue.h>
+
+using namespace std;
+using namespace Afina::Concurrency;
+
+namespace {
+
+// Fill function for the queue of plain values
+struct Put {
+    Put(long v) : value(v) {}
+    void operator()(long &slot) { slot = value; }
+    long value;
+};
+
+} // namespace
+
+TEST(MpmcQueueTest, FifoAcrossWrap) {
+    MpmcQueue<long> q(3);
+    EXPECT_EQ(q.capacity(), 3);
+    long value = -1;
+    EXPECT_FALSE(q.pop(value));
+
+    // Indices run over capacity many times, order must hold
+    long next = 0;
+    for (long round = 0; round < 100; round++) {
+        EXPECT_TRUE(q.push(Put(round * 2)));
+        EXPECT_TRUE(q.push(Put(round * 2 + 1)));
+        EXPECT_EQ(q.size(), 2);
+        for (int i = 0; i < 2; i++) {
+            ASSERT_TRUE(q.pop(value));
+            EXPECT_EQ(next++, value);
+        }
+    }
+    EXPECT_TRUE(q.empty());
+}
+
+TEST(MpmcQueueTest, FullThenDrained) {
+    MpmcQueue<long> q(2);
+    EXPECT_TRUE(q.push(Put(1)));
+    EXPECT_TRUE(q.push(Put(2)));
+    EXPECT_FALSE(q.push(Put(3)));
+
+    long value;
+    ASSERT_TRUE(q.pop(value));
+    EXPECT_EQ(value, 1);
+    EXPECT_TRUE(q.push(Put(3)));
+    ASSERT_TRUE(q.pop(value));
+    EXPECT_EQ(value, 2);
+    ASSERT_TRUE(q.pop(value));
+    EXPECT_EQ(value, 3);
+    EXPECT_FALSE(q.pop(value));
+}
+
+TEST(MpmcQueueTest, ThrowingFillKeepsQueueUsable) {
+    MpmcQueue<long> q(2);
+    EXPECT_TRUE(q.push(Put(7)));
+    EXPECT_THROW(q.push([](long &slot) { throw runtime_error("fill"); }), runtime_error);
+
+    // Cell claimed by failed fill is still published, so the queue moves on
+    long value;
+    ASSERT_TRUE(q.pop(value));
+    EXPECT_EQ(value, 7);
+    ASSERT_TRUE(q.pop(value));
+    EXPECT_TRUE(q.push(Put(8)));
+    ASSERT_TRUE(q.pop(value));
+    EXPECT_EQ(value, 8);
+}
+
+TEST(MpmcQueueTest, EveryValueTakenOnce) {
+    const long per_producer = 100000;
+    const int producers = 3, consumers = 3;
+
+    MpmcQueue<long> q(64);
+    vector<atomic<int>> taken(per_producer * producers);
+    for (auto &t : taken) {
+        t.store(0);
+    }
+
+    atomic<long> consumed(0);
+    vector<thread> threads;
+    for (int p = 0; p < producers; p++) {
+        threads.emplace_back([&q, p, per_producer]() {
+            for (long i = 0; i < per_producer; i++) {
+                while (!q.push(Put(p * per_producer + i))) {
+                    this_thread::yield();
+                }
+            }
+        });
+    }
+    for (int c = 0; c < consumers; c++) {
+        threads.emplace_back([&]() {
+            long value;
+            while (consumed.load() < per_producer * producers) {
+                if (q.pop(value)) {
+                    taken[value]++;
+                    consumed++;
+                } else {
+                    this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    for (long i = 0; i < per_producer * producers; i++) {
+        ASSERT_EQ(taken[i].load(), 1) << "value " << i;
+    }
+}
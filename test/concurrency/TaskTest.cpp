@@ -0,0 +1,112 @@
+#include "gtest/gtest.h"
+#include <functional>
+#include <string>
+
+#include <afina/concurrency/Task.h>
+
+using namespace std;
+using namespace Afina::Concurrency;
+
+namespace {
+
+// Counts instances alive to check that task destroys what it holds exactly once
+struct Tracked {
+    static int alive;
+
+    Tracked(int &calls) : calls(&calls) { alive++; }
+    Tracked(Tracked &&other) noexcept : calls(other.calls) { alive++; }
+    ~Tracked() { alive--; }
+
+    void operator()() { (*calls)++; }
+
+    int *calls;
+};
+
+int Tracked::alive = 0;
+
+// Doesn't fit into task of 64 bytes
+struct Big : Tracked {
+    Big(int &calls) : Tracked(calls) {}
+    Big(Big &&other) noexcept : Tracked(std::move(other)) {}
+
+    char padding[128];
+};
+
+class Counter {
+public:
+    Counter() : value(0) {}
+
+    void add(int delta, string &log) {
+        value += delta;
+        log += "+";
+    }
+
+    int get() const { return value; }
+
+    int value;
+};
+
+} // namespace
+
+TEST(TaskTest, InlineAndHeap) {
+    EXPECT_TRUE(Task<64>::fits<Tracked>::value);
+    EXPECT_FALSE(Task<64>::fits<Big>::value);
+
+    int calls = 0;
+    {
+        Task<64> small(InPlace<Tracked>(), calls);
+        Task<64> big(InPlace<Big>(), calls);
+        EXPECT_EQ(Tracked::alive, 2);
+        small();
+        big();
+        EXPECT_EQ(calls, 2);
+    }
+    EXPECT_EQ(Tracked::alive, 0);
+}
+
+TEST(TaskTest, MoveAndReset) {
+    int calls = 0;
+    Task<64> empty;
+    EXPECT_FALSE(empty);
+
+    Task<64> task(InPlace<Tracked>(), calls);
+    Task<64> moved(std::move(task));
+    EXPECT_FALSE(task);
+    ASSERT_TRUE(moved);
+    EXPECT_EQ(Tracked::alive, 1);
+
+    // Assignment destroys current callable of the target
+    Task<64> other(InPlace<Big>(), calls);
+    other = std::move(moved);
+    EXPECT_EQ(Tracked::alive, 1);
+    other();
+    EXPECT_EQ(calls, 1);
+
+    other.emplace<Big>(calls);
+    EXPECT_EQ(Tracked::alive, 1);
+    other.reset();
+    EXPECT_FALSE(other);
+    EXPECT_EQ(Tracked::alive, 0);
+}
+
+TEST(TaskTest, BoundCall) {
+    typedef BoundCall<void (Counter::*)(int, string &), Counter *, int, reference_wrapper<string>> Call;
+
+    Counter counter;
+    string log;
+    Task<64> task(InPlace<Call>(), &Counter::add, &counter, 5, std::ref(log));
+    task();
+    task();
+    EXPECT_EQ(counter.get(), 10);
+    EXPECT_EQ(log, "++");
+
+    typedef BoundCall<int (Counter::*)() const, Counter *> Getter;
+    Getter getter(&Counter::get, &counter);
+    getter();
+
+    int result = 0;
+    auto lambda = [&result](int a, int b) { result = a * b; };
+    BoundCall<decltype(lambda), int, int> call(lambda, 6, 7);
+    call();
+    EXPECT_EQ(result, 42);
+}
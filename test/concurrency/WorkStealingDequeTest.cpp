@@ -0,0 +1,104 @@
+#include "gtest/gtest.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "concurrency/WorkStealingDeque.h"
+
+using namespace std;
+using namespace Afina::Concurrency;
+
+TEST(WorkStealingDequeTest, OwnerIsLifoThiefIsFifo) {
+    WorkStealingDeque<long> q(4);
+    long value = -1;
+    EXPECT_FALSE(q.pop(value));
+    EXPECT_FALSE(q.steal(value));
+
+    for (long i = 0; i < 4; i++) {
+        q.push(i);
+    }
+    EXPECT_EQ(q.size(), 4);
+
+    ASSERT_TRUE(q.pop(value));
+    EXPECT_EQ(value, 3);
+    ASSERT_TRUE(q.steal(value));
+    EXPECT_EQ(value, 0);
+    ASSERT_TRUE(q.steal(value));
+    EXPECT_EQ(value, 1);
+    ASSERT_TRUE(q.pop(value));
+    EXPECT_EQ(value, 2);
+
+    EXPECT_FALSE(q.pop(value));
+    EXPECT_FALSE(q.steal(value));
+    EXPECT_TRUE(q.empty());
+}
+
+TEST(WorkStealingDequeTest, GrowsKeepingOrder) {
+    WorkStealingDeque<long> q(2);
+    long value = -1;
+
+    // Move indices forward first so that the ring wraps before it grows
+    for (long i = 0; i < 5; i++) {
+        q.push(i);
+        ASSERT_TRUE(q.steal(value));
+    }
+
+    for (long i = 0; i < 100; i++) {
+        q.push(i);
+    }
+    EXPECT_GE(q.capacity(), 100);
+
+    for (long i = 0; i < 50; i++) {
+        ASSERT_TRUE(q.steal(value));
+        EXPECT_EQ(value, i);
+    }
+    for (long i = 99; i >= 50; i--) {
+        ASSERT_TRUE(q.pop(value));
+        EXPECT_EQ(value, i);
+    }
+    EXPECT_FALSE(q.pop(value));
+}
+
+TEST(WorkStealingDequeTest, EveryValueTakenOnce) {
+    const long count = 200000;
+    const int thieves = 3;
+
+    WorkStealingDeque<long> q(16);
+    vector<atomic<int>> taken(count);
+    for (auto &t : taken) {
+        t.store(0);
+    }
+
+    atomic<bool> done(false);
+    vector<thread> threads;
+    for (int t = 0; t < thieves; t++) {
+        threads.emplace_back([&]() {
+            long value;
+            while (!done.load() || !q.empty()) {
+                if (q.steal(value)) {
+                    taken[value]++;
+                }
+            }
+        });
+    }
+
+    // Owner mixes pushes and pops so that it races with thieves for the last value as well
+    long value;
+    for (long i = 0; i < count; i++) {
+        q.push(i);
+        if (i % 3 == 0 && q.pop(value)) {
+            taken[value]++;
+        }
+    }
+    while (q.pop(value)) {
+        taken[value]++;
+    }
+    done.store(true);
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    for (long i = 0; i < count; i++) {
+        ASSERT_EQ(taken[i].load(), 1) << "value " << i;
+    }
+}
@@ -0,0 +1,87 @@
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+#include <afina/coroutine/Engine.h>
+
+// Context switch latency of the engine: two routines pass control to each other by sched() a number of
+// times, each of them doing that from the given stack depth. Stack copying engine moves the used part of
+// the stack on every switch, so its latency grows with the depth, while separate stacks just swap registers.
+// Routine creation cost is measured as well, along with the number of contexts and stacks taken from the pool.
+//
+// Usage: runCoroutineBenchmark [switches]
+
+namespace {
+
+using Afina::Coroutine::Engine;
+
+void *ping = nullptr, *pong = nullptr;
+
+// Goes depth kilobytes down the stack and then passes control to the other routine switches times
+void player(Engine &engine, void *&other, std::size_t depth, std::size_t switches) {
+    if (depth > 0) {
+        volatile char frame[1024];
+        frame[0] = 0;
+        player(engine, other, depth - 1, switches);
+        frame[0]++;
+        return;
+    }
+
+    for (std::size_t i = 0; i < switches; i++) {
+        engine.sched(other);
+    }
+}
+
+void match(Engine &engine, std::size_t depth, std::size_t switches) {
+    ping = engine.run(player, engine, pong, depth, switches);
+    pong = engine.run(player, engine, ping, depth, switches);
+    engine.sched(ping);
+}
+
+void nothing() {}
+
+void spawner(Engine &engine, std::size_t count) {
+    for (std::size_t i = 0; i < count; i++) {
+        engine.sched(engine.run(nothing));
+    }
+}
+
+const char *name(Engine::StackMode mode) { return mode == Engine::StackMode::Copying ? "copying" : "separate"; }
+
+} // namespace
+
+int main(int argc, char **argv) {
+    std::size_t switches = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+
+    std::cout << std::setw(10) << "mode" << std::setw(14) << "depth, KB" << std::setw(16) << "switch, ns"
+              << std::endl;
+    for (Engine::StackMode mode : {Engine::StackMode::Copying, Engine::StackMode::Separate}) {
+        for (std::size_t depth : {0, 1, 4, 16}) {
+            Engine engine(nullptr, mode);
+            auto start = std::chrono::steady_clock::now();
+            engine.start(match, engine, depth, switches);
+            std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+
+            std::cout << std::setw(10) << name(mode) << std::setw(14) << depth << std::setw(16) << std::fixed
+                      << std::setprecision(1) << elapsed.count() / (2 * switches) << std::endl;
+        }
+    }
+
+    std::cout << std::endl
+              << std::setw(10) << "mode" << std::setw(22) << "run and finish, ns" << std::setw(18) << "contexts reused"
+              << std::setw(16) << "stacks reused" << std::endl;
+    for (Engine::StackMode mode : {Engine::StackMode::Copying, Engine::StackMode::Separate}) {
+        std::size_t count = switches / 10;
+        Engine engine(nullptr, mode);
+        auto start = std::chrono::steady_clock::now();
+        engine.start(spawner, engine, count);
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+
+        const Engine::PoolStats &stats = engine.pool_stats();
+        std::cout << std::setw(10) << name(mode) << std::setw(22) << std::fixed << std::setprecision(1)
+                  << elapsed.count() / count << std::setw(18) << stats.contexts_reused << std::setw(16)
+                  << stats.stacks_reused << std::endl;
+    }
+    return 0;
+}
@@ -2,6 +2,8 @@
 
 #include <iostream>
 #include <sstream>
+#include <string>
+#include <vector>
 
 #include <afina/coroutine/Engine.h>
 
@@ -46,6 +48,8 @@ void printb(Afina::Coroutine::Engine &pe, std::stringstream &out, void *&other)
 std::stringstream out;
 void *pa = nullptr, *pb = nullptr;
 void _printer(Afina::Coroutine::Engine &pe, std::string &result) {
+    out.str("");
+
     // Create routines, note it doens't get control yet
     pa = pe.run(printa, pe, out, pb);
     pb = pe.run(printb, pe, out, pa);
@@ -69,3 +73,142 @@ TEST(CoroutineTest, Printer) {
     engine.start(_printer, engine, result);
     ASSERT_STREQ("A1 B1 A2 B2 A3 B3 END", result.c_str());
 }
+
+void _blocked(Afina::Coroutine::Engine &pe, std::vector<std::string> &trace, const char *name) {
+    trace.push_back(std::string(name) + " blocks");
+    pe.block();
+    trace.push_back(std::string(name) + " resumed");
+}
+
+void _blocker(Afina::Coroutine::Engine &pe, std::vector<std::string> &trace, std::vector<void *> &routines) {
+    routines.push_back(pe.run(_blocked, pe, trace, "A"));
+    routines.push_back(pe.run(_blocked, pe, trace, "B"));
+
+    // Both routines get control and block, so this one isn't blocked after yield
+    pe.yield();
+    pe.yield();
+    trace.push_back("main done");
+}
+
+void _block_unblock(Afina::Coroutine::Engine::StackMode mode) {
+    std::vector<std::string> trace;
+    std::vector<void *> routines;
+
+    // Once every routine is blocked engine asks to unblock them, the last one is left blocked
+    std::size_t unblocks = 0;
+    Afina::Coroutine::Engine engine(
+        [&]() {
+            unblocks++;
+            if (unblocks == 1) {
+                engine.unblock(routines[1]);
+            }
+        },
+        mode);
+    engine.start(_blocker, engine, trace, routines);
+
+    ASSERT_EQ(2, unblocks);
+    ASSERT_EQ(4, trace.size());
+    ASSERT_EQ("main done", trace[2]);
+    ASSERT_EQ("B resumed", trace[3]);
+}
+
+TEST(CoroutineTest, BlockUnblock) { _block_unblock(Afina::Coroutine::Engine::StackMode::Copying); }
+
+TEST(CoroutineTest, SeparateSimpleStart) {
+    Afina::Coroutine::Engine engine(nullptr, Afina::Coroutine::Engine::StackMode::Separate);
+    ASSERT_EQ(Afina::Coroutine::Engine::StackMode::Separate, engine.mode());
+
+    int result;
+    engine.start(_calculator_add, result, 1, 2);
+
+    ASSERT_EQ(3, result);
+}
+
+TEST(CoroutineTest, SeparatePrinter) {
+    Afina::Coroutine::Engine engine(nullptr, Afina::Coroutine::Engine::StackMode::Separate);
+
+    std::string result;
+    engine.start(_printer, engine, result);
+    ASSERT_STREQ("A1 B1 A2 B2 A3 B3 END", result.c_str());
+}
+
+TEST(CoroutineTest, SeparateBlockUnblock) { _block_unblock(Afina::Coroutine::Engine::StackMode::Separate); }
+
+void _argument_owner(std::vector<std::string> &trace, std::string value) { trace.push_back(value); }
+
+void _argument_creator(Afina::Coroutine::Engine &pe, std::vector<std::string> &trace) {
+    // Argument taken by value is moved into the routine, so it outlives the temporary
+    pe.run(_argument_owner, trace, std::string(100, 'x'));
+}
+
+TEST(CoroutineTest, SeparateArguments) {
+    Afina::Coroutine::Engine engine(nullptr, Afina::Coroutine::Engine::StackMode::Separate);
+
+    std::vector<std::string> trace;
+    engine.start(_argument_creator, engine, trace);
+    ASSERT_EQ(1, trace.size());
+    ASSERT_EQ(std::string(100, 'x'), trace[0]);
+}
+
+void _touch_stack(int &counter) {
+    volatile char frame[8192];
+    frame[0] = 1;
+    counter += frame[0];
+}
+
+void _sequential(Afina::Coroutine::Engine &pe, int &counter, std::size_t count) {
+    // Every routine finishes before the next one starts, so they all share the same context and stack
+    for (std::size_t i = 0; i < count; i++) {
+        pe.sched(pe.run(_touch_stack, counter));
+    }
+}
+
+TEST(CoroutineTest, PoolReuse) {
+    Afina::Coroutine::Engine engine(nullptr, Afina::Coroutine::Engine::StackMode::Separate);
+
+    int counter = 0;
+    engine.start(_sequential, engine, counter, 100);
+    ASSERT_EQ(100, counter);
+
+    // Main routine has its own stack as well
+    const Afina::Coroutine::Engine::PoolStats &stats = engine.pool_stats();
+    ASSERT_EQ(2, stats.stacks_mapped);
+    ASSERT_EQ(99, stats.stacks_reused);
+    ASSERT_EQ(2, stats.stacks_pooled);
+    ASSERT_EQ(0, stats.stacks_unmapped);
+
+    // Main routine, idle context and the routine being run
+    ASSERT_EQ(3, stats.contexts_allocated);
+    ASSERT_EQ(3, stats.contexts_pooled);
+}
+
+void _concurrent(Afina::Coroutine::Engine &pe, int &counter, std::size_t count) {
+    // All routines exist at the same time, then finish one by one
+    for (std::size_t i = 0; i < count; i++) {
+        pe.run(_touch_stack, counter);
+    }
+    pe.yield();
+}
+
+TEST(CoroutineTest, PoolLimits) {
+    Afina::Coroutine::Engine engine(nullptr, Afina::Coroutine::Engine::StackMode::Separate);
+    engine.pool_limits(2, 5);
+
+    int counter = 0;
+    engine.start(_concurrent, engine, counter, 8);
+    ASSERT_EQ(8, counter);
+
+    // Of 9 stacks including the main one only 5 are kept, and only 2 of them keep their pages
+    const Afina::Coroutine::Engine::PoolStats &stats = engine.pool_stats();
+    ASSERT_EQ(9, stats.stacks_mapped);
+    ASSERT_EQ(4, stats.stacks_unmapped);
+    ASSERT_EQ(5, stats.stacks_pooled);
+    ASSERT_EQ(2, stats.stacks_dirty);
+    ASSERT_EQ(3, stats.stacks_released);
+
+    // Stacks of the next start come from the pool while it lasts
+    engine.start(_concurrent, engine, counter, 5);
+    ASSERT_EQ(13, counter);
+    ASSERT_EQ(10, stats.stacks_mapped);
+    ASSERT_EQ(5, stats.stacks_reused);
+}
@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+
+#include <ctime>
+#include <string>
+
+#include <afina/execute/Add.h>
+#include <afina/execute/Append.h>
+#include <afina/execute/Get.h>
+#include <afina/execute/Replace.h>
+#include <afina/execute/Set.h>
+
+#include "storage/SimpleLRU.h"
+
+using namespace Afina;
+using namespace Afina::Execute;
+
+TEST(ExecuteTest, ExpireToTtl) {
+    EXPECT_EQ(0, Set("foo", 0, 0).ttl());
+    EXPECT_EQ(100, Set("foo", 0, 100).ttl());
+    EXPECT_EQ(60 * 60 * 24 * 30, Set("foo", 0, 60 * 60 * 24 * 30).ttl());
+    EXPECT_EQ(-1, Set("foo", 0, -10).ttl());
+
+    // Absolute unix time
+    int32_t now = int32_t(std::time(nullptr));
+    EXPECT_LE(99, Set("foo", 0, now + 100).ttl());
+    EXPECT_GE(100, Set("foo", 0, now + 100).ttl());
+    EXPECT_EQ(-1, Set("foo", 0, now - 100).ttl());
+}
+
+TEST(ExecuteTest, InsertHonorsExpire) {
+    Backend::SimpleLRU storage;
+    std::string out, value;
+
+    Set("foo", 0, 100).Execute(storage, "fooval", out);
+    EXPECT_EQ("STORED", out);
+    EXPECT_TRUE(storage.Get("foo", value));
+
+    Replace("foo", 0, -1).Execute(storage, "other", out);
+    EXPECT_EQ("STORED", out);
+    EXPECT_FALSE(storage.Get("foo", value));
+
+    Replace("foo", 0, 0).Execute(storage, "other", out);
+    EXPECT_EQ("NOT_STORED", out);
+
+    Add("bar", 0, int32_t(std::time(nullptr)) + 100).Execute(storage, "barval", out);
+    EXPECT_EQ("STORED", out);
+    EXPECT_TRUE(storage.Get("bar", value));
+    EXPECT_EQ("barval", value);
+}
+
+TEST(ExecuteTest, GetReturnsFlags) {
+    Backend::SimpleLRU storage;
+    std::string out;
+
+    Set("foo", 42, 0).Execute(storage, "fooval", out);
+    Set("bar", 0, 0).Execute(storage, "barval", out);
+    Append("foo", 1, 0).Execute(storage, "+", out);
+    EXPECT_EQ("STORED", out);
+
+    Get({"foo", "baz", "bar"}).Execute(storage, "", out);
+    EXPECT_EQ("VALUE foo 42 7\r\nfooval+\r\nVALUE bar 0 6\r\nbarval\r\nEND", out);
+}
+
+// Concatenates response segments the way writev would send them
+static std::string gather(const Response &response, size_t offset) {
+    struct iovec iov[16];
+    size_t count = response.gather(offset, iov, 16);
+
+    std::string result;
+    for (size_t i = 0; i < count; i++) {
+        result.append(static_cast<const char *>(iov[i].iov_base), iov[i].iov_len);
+    }
+    return result;
+}
+
+TEST(ExecuteTest, GetReferencesLargeValues) {
+    Backend::SimpleLRU storage(1 << 16);
+    std::string big(5000, 'b'), out;
+    Set("big", 3, 0).Execute(storage, big, out);
+    Set("small", 4, 0).Execute(storage, "smallval", out);
+
+    Get get({"small", "big", "none"});
+    get.Execute(storage, "", out);
+
+    Response response;
+    get.Execute(storage, "", response);
+    EXPECT_EQ(out.size(), response.size());
+    EXPECT_EQ(out, gather(response, 0));
+    EXPECT_EQ(out.substr(30), gather(response, 30));
+
+    // Value is sent from the storage memory, but outlives the entry
+    struct iovec iov[16];
+    EXPECT_EQ(3, response.gather(0, iov, 16));
+    Set("big", 0, 0).Execute(storage, std::string(5000, 'n'), out);
+    EXPECT_EQ(std::string(static_cast<char *>(iov[1].iov_base), iov[1].iov_len), big);
+
+    response.clear();
+    EXPECT_EQ(0, response.size());
+    EXPECT_EQ(0, response.gather(0, iov, 16));
+}
+
+TEST(ExecuteTest, GetsReturnsCas) {
+    Backend::SimpleLRU storage(1 << 16);
+    std::string out;
+
+    Set("foo", 42, 0).Execute(storage, "fooval", out);
+    Set("big", 3, 0).Execute(storage, std::string(5000, 'b'), out);
+
+    Get({"foo", "baz"}, true).Execute(storage, "", out);
+    EXPECT_EQ("VALUE foo 42 6 0\r\nfooval\r\nEND", out);
+
+    Response response;
+    Get({"big"}, true).Execute(storage, "", response);
+    EXPECT_EQ("VALUE big 3 5000 0\r\n" + std::string(5000, 'b') + "\r\nEND", gather(response, 0));
+}
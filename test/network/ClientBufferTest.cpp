@@ -0,0 +1,101 @@
+#include "gtest/gtest.h"
+#include <cstring>
+#include <string>
+
+#include "network/ClientBuffer.h"
+
+using namespace std;
+using namespace Afina::Network;
+
+namespace {
+
+// Emulates socket read of the given bytes
+void fill(ClientBuffer &buffer, const string &data) {
+    ASSERT_GE(buffer.read_size(), data.size());
+    memcpy(buffer.read_ptr(), data.data(), data.size());
+    buffer.read(data.size());
+}
+
+string pending(ClientBuffer &buffer) { return string(buffer.parse_ptr(), buffer.parse_size()); }
+
+} // namespace
+
+TEST(ClientBufferTest, PartialParseThenRead) {
+    ClientBuffer buffer(16);
+    EXPECT_EQ(16, buffer.read_size());
+    EXPECT_EQ(0, buffer.parse_size());
+
+    // Command split between reads stays contiguous right after the consumed one
+    fill(buffer, "get a\r\nge");
+    EXPECT_EQ("get a\r\nge", pending(buffer));
+    buffer.parsed(7);
+    EXPECT_EQ("ge", pending(buffer));
+    EXPECT_EQ(7, buffer.read_size());
+
+    fill(buffer, "t b\r\n");
+    EXPECT_EQ("get b\r\n", pending(buffer));
+    EXPECT_EQ(2, buffer.read_size());
+}
+
+TEST(ClientBufferTest, PendingMovedToFront) {
+    ClientBuffer buffer(16);
+    char *start = buffer.read_ptr();
+
+    fill(buffer, "get a\r\nget b\r\nge");
+    buffer.parsed(14);
+    EXPECT_EQ(0, buffer.read_size());
+
+    // Pending bytes fit, so buffer keeps its memory
+    buffer.reserve(8);
+    EXPECT_EQ(start, buffer.parse_ptr());
+    EXPECT_EQ("ge", pending(buffer));
+    EXPECT_EQ(14, buffer.read_size());
+
+    // Enough room already, nothing moves
+    buffer.reserve(14);
+    EXPECT_EQ(start, buffer.parse_ptr());
+    EXPECT_EQ(14, buffer.read_size());
+}
+
+TEST(ClientBufferTest, DoublesForLargePayload) {
+    ClientBuffer buffer(16);
+    fill(buffer, "set k 0 0 100\r\n");
+    buffer.parsed(15);
+
+    // Payload larger than the whole buffer doubles it as many times as needed, pending bytes survive
+    fill(buffer, "x");
+    buffer.reserve(100);
+    EXPECT_EQ("x", pending(buffer));
+    EXPECT_EQ(127, buffer.read_size());
+
+    fill(buffer, string(99, 'y'));
+    EXPECT_EQ("x" + string(99, 'y'), pending(buffer));
+
+    // More than half of the buffer is pending, moving it would leave too little room for the next reads
+    ClientBuffer half(16);
+    fill(half, "0123456789abcdef");
+    half.parsed(6);
+    half.reserve(4);
+    EXPECT_EQ("6789abcdef", pending(half));
+    EXPECT_EQ(22, half.read_size());
+}
+
+TEST(ClientBufferTest, ShrinksAfterDrain) {
+    ClientBuffer buffer(16);
+    fill(buffer, "set k 0 0 ");
+    buffer.reserve(40);
+    EXPECT_EQ(54, buffer.read_size());
+    fill(buffer, "30\r\n" + string(30, 'z') + "\r\n");
+
+    // Everything consumed, so buffer rewinds and gives back memory it grew for
+    buffer.parsed(buffer.parse_size());
+    EXPECT_EQ(0, buffer.parse_size());
+    EXPECT_EQ(16, buffer.read_size());
+
+    fill(buffer, "get k\r\n");
+    buffer.reserve(100);
+    EXPECT_EQ(121, buffer.read_size());
+    buffer.reset();
+    EXPECT_EQ(0, buffer.parse_size());
+    EXPECT_EQ(16, buffer.read_size());
+}
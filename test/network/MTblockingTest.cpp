@@ -0,0 +1,84 @@
+#include "gtest/gtest.h"
+#include <atomic>
+#include <memory>
+#include <string>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "network/mt_blocking/ServerImpl.h"
+#include "storage/SimpleLRU.h"
+
+#include "TestClient.h"
+
+using namespace std;
+using namespace Afina;
+using namespace Afina::Test;
+
+namespace {
+
+// Storage telling for each lookup whether any response has reached the client already
+class Probe : public Backend::SimpleLRU {
+public:
+    Probe() : SimpleLRU(1 << 20), client(-1), lookups(0), early(0) {}
+
+    std::size_t GetMany(const std::vector<StringView> &keys, std::size_t min_size,
+                        const BatchReader &reader) const override {
+        // Response sent by the server could be held back by Nagle for a while, so wait for it a little
+        struct pollfd event = {client, POLLIN, 0};
+        if (poll(&event, 1, 200) > 0) {
+            early++;
+        }
+        lookups++;
+        return SimpleLRU::GetMany(keys, min_size, reader);
+    }
+
+    int client;
+    mutable std::atomic<int> lookups;
+    mutable std::atomic<int> early;
+};
+
+/**
+ * Sends gets pipelined in a single packet to mt_blocking server with the given output limit, returns how
+ * many of the lookups happened once some responses were sent already
+ */
+int pipelined_gets(std::size_t max_pending, int count) {
+    shared_ptr<Probe> storage(new Probe);
+    storage->Put("key", string(100, 'v'));
+
+    uint16_t port = free_port();
+    Network::MTblocking::ServerImpl server(storage, logging());
+    server.SetMaxPending(max_pending);
+    server.Start(port, 1, 1);
+
+    storage->client = connect_to(port);
+    EXPECT_NE(-1, storage->client);
+
+    string request;
+    for (int i = 0; i < count; i++) {
+        request += "get key\r\n";
+    }
+    EXPECT_EQ(request.size(), send(storage->client, request.data(), request.size(), 0));
+
+    string value = "VALUE key 0 100\r\n" + string(100, 'v') + "\r\nEND\r\n";
+    EXPECT_EQ(count * value.size(), recv_size(storage->client, count * value.size()).size());
+    EXPECT_EQ(count, storage->lookups.load());
+
+    close(storage->client);
+    server.Stop();
+    server.Join();
+    return storage->early.load();
+}
+
+} // namespace
+
+TEST(MTblockingTest, PipelinedResponsesSentTogether) {
+    // Nothing goes out until every command of the read is executed
+    EXPECT_EQ(0, pipelined_gets(1 << 20, 5));
+}
+
+TEST(MTblockingTest, MaxPendingFlushesEarly) {
+    // Each response is over the limit, so it is sent before the next command runs
+    EXPECT_EQ(4, pipelined_gets(1, 5));
+}
@@ -0,0 +1,295 @@
+#include "gtest/gtest.h"
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "network/mt_nonblocking/ServerImpl.h"
+#include "network/mt_nonblocking/Worker.h"
+#include "storage/SimpleLRU.h"
+
+#include "TestClient.h"
+
+using namespace std;
+using namespace Afina;
+using namespace Afina::Test;
+
+namespace {
+
+// Storage with slow lookups, so batches stay in flight on storage threads for a while
+class Slow : public Backend::SimpleLRU {
+public:
+    explicit Slow(int delay_ms) : SimpleLRU(1 << 20), delay(delay_ms), lookups(0), active(0) {}
+
+    std::size_t GetMany(const std::vector<StringView> &keys, std::size_t min_size,
+                        const BatchReader &reader) const override {
+        active++;
+        lookups++;
+        std::this_thread::sleep_for(std::chrono::milliseconds(delay));
+        std::size_t result = SimpleLRU::GetMany(keys, min_size, reader);
+        active--;
+        return result;
+    }
+
+    int delay;
+    mutable std::atomic<int> lookups;
+    mutable std::atomic<int> active;
+};
+
+// Storage remembering which threads looked each key up
+class Tracker : public Backend::SimpleLRU {
+public:
+    Tracker() : SimpleLRU(1 << 20) {}
+
+    std::size_t GetMany(const std::vector<StringView> &keys, std::size_t min_size,
+                        const BatchReader &reader) const override {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (auto &key : keys) {
+                threads[key.str()].insert(std::this_thread::get_id());
+            }
+        }
+        return SimpleLRU::GetMany(keys, min_size, reader);
+    }
+
+    std::set<std::thread::id> ThreadsOf(const string &key) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return threads[key];
+    }
+
+    mutable std::mutex mutex;
+    mutable std::map<string, std::set<std::thread::id>> threads;
+};
+
+// Waits for the condition a few seconds at most
+template <typename F> bool eventually(F condition) {
+    for (int i = 0; i < 500 && !condition(); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return condition();
+}
+
+string set_command(const string &key, const string &value) {
+    return "set " + key + " 0 0 " + to_string(value.size()) + "\r\n" + value + "\r\n";
+}
+
+string value_line(const string &key, const string &value) {
+    return "VALUE " + key + " 0 " + to_string(value.size()) + "\r\n" + value + "\r\n";
+}
+
+string value_of(int i) { return string(1 + i % 50, 'a' + i % 26); }
+
+} // namespace
+
+TEST(MTnonblockingTest, PipelinedResponsesInOrder) {
+    shared_ptr<Slow> storage(new Slow(1));
+    uint16_t port = free_port();
+    Network::MTnonblock::ServerImpl server(storage, logging(), 2);
+    server.Start(port, 1, 2);
+
+    int client = connect_to(port);
+    ASSERT_NE(-1, client);
+
+    // Commands arrive in several reads, so next batch is parsed while previous one is still executed, every
+    // get sees the set right before it
+    string request, expected;
+    for (int i = 0; i < 300; i++) {
+        string key = "k" + to_string(i);
+        request += set_command(key, value_of(i)) + "get " + key + "\r\n";
+        expected += "STORED\r\n" + value_line(key, value_of(i)) + "END\r\n";
+        if (i > 0) {
+            string previous = "k" + to_string(i - 1);
+            request += "get " + previous + " " + key + "\r\n";
+            expected += value_line(previous, value_of(i - 1)) + value_line(key, value_of(i)) + "END\r\n";
+        }
+    }
+    for (size_t offset = 0; offset < request.size(); offset += 1000) {
+        ASSERT_TRUE(send_all(client, request.substr(offset, 1000)));
+    }
+    EXPECT_EQ(expected, recv_size(client, expected.size()));
+
+    close(client);
+    server.Stop();
+    server.Join();
+}
+
+TEST(MTnonblockingTest, ClientGoneWithCommandsInFlight) {
+    shared_ptr<Slow> storage(new Slow(20));
+    storage->Put("key", "value");
+    uint16_t port = free_port();
+    Network::MTnonblock::ServerImpl server(storage, logging(), 2);
+    server.Start(port, 1, 2);
+
+    for (int i = 0; i < 4; i++) {
+        int client = connect_to(port);
+        ASSERT_NE(-1, client);
+        string request;
+        for (int j = 0; j < 20; j++) {
+            request += "get key\r\n";
+        }
+        ASSERT_TRUE(send_all(client, request));
+        int before = storage->lookups.load();
+        ASSERT_TRUE(eventually([&] { return storage->lookups.load() > before; }));
+        close(client);
+    }
+
+    // Batches of the closed connections are done at some point and nothing of them is left
+    ASSERT_TRUE(eventually([&] { return storage->active.load() == 0; }));
+
+    int client = connect_to(port);
+    ASSERT_NE(-1, client);
+    string request = set_command("other", "data") + "get other key\r\n";
+    string expected = "STORED\r\nVALUE other 0 4\r\ndata\r\nVALUE key 0 5\r\nvalue\r\nEND\r\n";
+    EXPECT_EQ(expected, round_trip(client, request, expected.size()));
+
+    close(client);
+    server.Stop();
+    server.Join();
+}
+
+TEST(MTnonblockingTest, StopWaitsForBatchesInFlight) {
+    shared_ptr<Slow> storage(new Slow(20));
+    storage->Put("key", "value");
+    uint16_t port = free_port();
+    Network::MTnonblock::ServerImpl server(storage, logging(), 2);
+    server.Start(port, 1, 2);
+
+    vector<int> clients;
+    for (int i = 0; i < 4; i++) {
+        int client = connect_to(port);
+        ASSERT_NE(-1, client);
+        string request;
+        for (int j = 0; j < 20; j++) {
+            request += "get key\r\n";
+        }
+        ASSERT_TRUE(send_all(client, request));
+        clients.push_back(client);
+    }
+    ASSERT_TRUE(eventually([&] { return storage->active.load() > 0; }));
+
+    server.Stop();
+    server.Join();
+
+    // Nothing runs on the storage once server is joined
+    EXPECT_EQ(0, storage->active.load());
+    int lookups = storage->lookups.load();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    EXPECT_EQ(lookups, storage->lookups.load());
+
+    // Connections are closed by the server, whatever was sent before
+    for (int client : clients) {
+        char buffer[4096];
+        ssize_t n;
+        while ((n = recv(client, buffer, sizeof(buffer), 0)) > 0) {
+        }
+        EXPECT_NE(-1, n);
+        close(client);
+    }
+}
+
+TEST(MTnonblockingTest, LeastLoadedTakesNewConnection) {
+    shared_ptr<Storage> storage(new Backend::SimpleLRU(1 << 20));
+    vector<unique_ptr<Network::MTnonblock::Worker>> workers;
+    for (int i = 0; i < 3; i++) {
+        workers.emplace_back(new Network::MTnonblock::Worker(storage, logging(), 1));
+    }
+    EXPECT_EQ(workers[0].get(), Network::MTnonblock::Worker::LeastLoaded(workers));
+
+    // Handed over connections count right away, before the worker adopts them
+    vector<int> peers;
+    for (int i = 0; i < 5; i++) {
+        int fds[2];
+        ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+        peers.push_back(fds[1]);
+
+        Network::MTnonblock::Worker *target = Network::MTnonblock::Worker::LeastLoaded(workers);
+        EXPECT_EQ(workers[i % 3].get(), target);
+        EXPECT_TRUE(target->Assign(0, new Network::MTnonblock::Connection(fds[0], storage, logging(), 1 << 20)));
+    }
+    EXPECT_EQ(2, workers[0]->Load());
+    EXPECT_EQ(2, workers[1]->Load());
+    EXPECT_EQ(1, workers[2]->Load());
+    EXPECT_EQ(workers[2].get(), Network::MTnonblock::Worker::LeastLoaded(workers));
+
+    // Connections never adopted are closed with the worker
+    workers.clear();
+    for (int fd : peers) {
+        char c;
+        EXPECT_EQ(0, recv(fd, &c, 1, 0));
+        close(fd);
+    }
+}
+
+TEST(MTnonblockingTest, HotConnectionsMigrate) {
+    shared_ptr<Tracker> storage(new Tracker);
+    uint16_t port = free_port();
+    Network::MTnonblock::ServerImpl server(storage, logging());
+    server.Start(port, 1, 2);
+
+    // Accepted one by one, connections alternate between the workers, so once every second is closed all the
+    // rest are left on the first one
+    vector<int> clients, hot;
+    for (int i = 0; i < 6; i++) {
+        int client = connect_to(port);
+        ASSERT_NE(-1, client);
+        string key = "c" + to_string(i);
+        ASSERT_EQ("STORED\r\n", round_trip(client, set_command(key, key), 8));
+        clients.push_back(client);
+    }
+    for (int i = 0; i < 6; i++) {
+        if (i % 2 == 0) {
+            hot.push_back(i);
+        } else {
+            close(clients[i]);
+        }
+    }
+
+    // Hot connections keep getting correct responses while one of them moves to the idle worker
+    std::atomic<bool> stop(false);
+    std::atomic<int> failures(0);
+    vector<std::thread> load;
+    for (int i : hot) {
+        load.emplace_back([&, i] {
+            string key = "c" + to_string(i), request = "get " + key + "\r\n";
+            string expected = value_line(key, key) + "END\r\n";
+            while (!stop) {
+                if (round_trip(clients[i], request, expected.size()) != expected) {
+                    failures++;
+                    break;
+                }
+            }
+        });
+    }
+
+    auto migrated = [&] {
+        std::set<std::thread::id> threads;
+        for (int i : hot) {
+            auto of = storage->ThreadsOf("c" + to_string(i));
+            threads.insert(of.begin(), of.end());
+        }
+        return threads.size() > 1;
+    };
+    EXPECT_TRUE(eventually(migrated));
+
+    // Moved connection is still served by its new worker
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    stop = true;
+    for (auto &t : load) {
+        t.join();
+    }
+    EXPECT_EQ(0, failures.load());
+
+    for (int i : hot) {
+        close(clients[i]);
+    }
+    server.Stop();
+    server.Join();
+}
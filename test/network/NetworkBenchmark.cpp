@@ -0,0 +1,174 @@
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// Request throughput of the running server with many concurrent connections: all connections are opened
+// upfront, then each of them sends "get" of a small stored key and waits for the whole response before
+// sending the next one. Result is the number of requests served per second, along with the number of
+// epoll wakeups of the client for the reference.
+//
+// Usage: runNetworkBenchmark [port] [connections] [seconds]
+
+namespace {
+
+const std::string request = "get bench\r\n";
+const std::string end_marker = "END\r\n";
+
+struct client {
+    int socket;
+
+    // Bytes of the current response received so far
+    std::string received;
+};
+
+// Starts nonblocking connect to the server on the loopback
+int start_connect(uint16_t port) {
+    int s = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, IPPROTO_TCP);
+    if (s == -1) {
+        throw std::runtime_error("socket() failed: " + std::string(strerror(errno)));
+    }
+
+    int one = 1;
+    setsockopt(s, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    struct sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(s, (struct sockaddr *)&addr, sizeof(addr)) == -1 && errno != EINPROGRESS) {
+        close(s);
+        throw std::runtime_error("connect() failed: " + std::string(strerror(errno)));
+    }
+    return s;
+}
+
+// Opens all connections at once: server with short listen queue drops SYNs under the burst, so connects
+// are waited for concurrently and retransmits of the dropped ones overlap
+void open_connections(int epoll_fd, uint16_t port, std::vector<client> &clients) {
+    for (client &c : clients) {
+        c.socket = start_connect(port);
+
+        struct epoll_event event;
+        event.events = EPOLLOUT;
+        event.data.ptr = &c;
+        if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, c.socket, &event)) {
+            throw std::runtime_error("epoll_ctl() failed: " + std::string(strerror(errno)));
+        }
+    }
+
+    std::array<struct epoll_event, 256> events;
+    for (size_t pending = clients.size(); pending > 0;) {
+        int n = epoll_wait(epoll_fd, &events[0], events.size(), -1);
+        for (int i = 0; i < n; i++) {
+            client &c = *static_cast<client *>(events[i].data.ptr);
+            int error = 0;
+            socklen_t len = sizeof(error);
+            getsockopt(c.socket, SOL_SOCKET, SO_ERROR, &error, &len);
+            if (error != 0) {
+                throw std::runtime_error("connect() failed: " + std::string(strerror(error)));
+            }
+
+            struct epoll_event event;
+            event.events = EPOLLIN;
+            event.data.ptr = &c;
+            epoll_ctl(epoll_fd, EPOLL_CTL_MOD, c.socket, &event);
+            pending--;
+        }
+    }
+}
+
+// Sends whole buffer, requests are tiny so socket buffer always has room for them
+void send_all(int s, const std::string &data) {
+    for (size_t sent = 0; sent < data.size();) {
+        ssize_t n = write(s, data.data() + sent, data.size() - sent);
+        if (n < 0 && errno == EAGAIN) {
+            continue;
+        }
+        if (n <= 0) {
+            throw std::runtime_error("write() failed: " + std::string(strerror(errno)));
+        }
+        sent += n;
+    }
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    uint16_t port = argc > 1 ? uint16_t(std::atoi(argv[1])) : 8080;
+    size_t connections = argc > 2 ? std::atol(argv[2]) : 10000;
+    double seconds = argc > 3 ? std::atof(argv[3]) : 10;
+
+    int epoll_fd = epoll_create1(0);
+    std::vector<client> clients(connections);
+    auto connect_start = std::chrono::steady_clock::now();
+    open_connections(epoll_fd, port, clients);
+    std::chrono::duration<double> connect_time = std::chrono::steady_clock::now() - connect_start;
+
+    // Value every request reads, sockets are nonblocking already so wait for the reply with epoll
+    send_all(clients[0].socket, "set bench 0 0 16\r\n0123456789abcdef\r\n");
+    struct epoll_event stored;
+    char reply[64];
+    if (epoll_wait(epoll_fd, &stored, 1, 1000) != 1 || read(clients[0].socket, reply, sizeof(reply)) <= 0) {
+        throw std::runtime_error("Failed to store value");
+    }
+
+    for (client &c : clients) {
+        send_all(c.socket, request);
+    }
+
+    long served = 0, wakeups = 0;
+    auto start = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed(0);
+    std::array<struct epoll_event, 256> events;
+    std::array<char, 4096> buffer;
+    while (elapsed.count() < seconds) {
+        int n = epoll_wait(epoll_fd, &events[0], events.size(), 100);
+        wakeups++;
+        for (int i = 0; i < n; i++) {
+            client &c = *static_cast<client *>(events[i].data.ptr);
+            ssize_t got = read(c.socket, &buffer[0], buffer.size());
+            if (got <= 0) {
+                if (got < 0 && errno == EAGAIN) {
+                    continue;
+                }
+                std::cerr << "Connection closed by server" << std::endl;
+                return 1;
+            }
+
+            c.received.append(&buffer[0], got);
+            if (c.received.size() >= end_marker.size() &&
+                c.received.compare(c.received.size() - end_marker.size(), end_marker.size(), end_marker) == 0) {
+                c.received.clear();
+                served++;
+                send_all(c.socket, request);
+            }
+        }
+        elapsed = std::chrono::steady_clock::now() - start;
+    }
+
+    std::cout << std::setw(14) << "connections" << std::setw(14) << "connect, s" << std::setw(16) << "requests/sec"
+              << std::setw(16) << "wakeups/sec" << std::endl;
+    std::cout << std::setw(14) << connections << std::setw(14) << std::fixed << std::setprecision(2)
+              << connect_time.count() << std::setw(16) << std::setprecision(0) << served / elapsed.count()
+              << std::setw(16) << wakeups / elapsed.count() << std::endl;
+
+    for (client &c : clients) {
+        close(c.socket);
+    }
+    close(epoll_fd);
+    return 0;
+}
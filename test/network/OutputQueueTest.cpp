@@ -0,0 +1,127 @@
+#include "gtest/gtest.h"
+#include <string>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "network/OutputQueue.h"
+
+using namespace std;
+using namespace Afina;
+using namespace Afina::Network;
+
+namespace {
+
+Execute::Response response(const string &text) {
+    Execute::Response r;
+    r.append(text);
+    return r;
+}
+
+// Concatenates iovecs gathered from the given offset
+string gathered(const OutputQueue &q, size_t offset, size_t max = OutputQueue::max_iovecs) {
+    struct iovec iov[OutputQueue::max_iovecs];
+    size_t count = q.gather(offset, iov, max);
+    string result;
+    for (size_t i = 0; i < count; i++) {
+        result.append(static_cast<const char *>(iov[i].iov_base), iov[i].iov_len);
+    }
+    return result;
+}
+
+} // namespace
+
+TEST(OutputQueueTest, GatherAcrossResponses) {
+    OutputQueue q(1024);
+    EXPECT_TRUE(q.empty());
+    EXPECT_EQ(0, q.gather(0, nullptr, 0));
+
+    q.push(response("STORED\r\n"));
+    q.push(Execute::Response());
+    q.push(response("END\r\n"));
+    EXPECT_EQ(13, q.size());
+    EXPECT_EQ("STORED\r\nEND\r\n", gathered(q, 0));
+    EXPECT_EQ("RED\r\nEND\r\n", gathered(q, 3));
+    EXPECT_EQ("ND\r\n", gathered(q, 9));
+    EXPECT_EQ("STORED\r\n", gathered(q, 0, 1));
+}
+
+TEST(OutputQueueTest, SentKeepsPosition) {
+    OutputQueue q(1024);
+    q.push(response("abc"));
+    q.push(response("defg"));
+    q.push(response("h"));
+
+    q.sent(2);
+    EXPECT_EQ(6, q.size());
+    EXPECT_EQ("cdefgh", gathered(q, 0));
+
+    // Crossing response boundaries
+    q.sent(3);
+    EXPECT_EQ("fgh", gathered(q, 0));
+    EXPECT_EQ("gh", gathered(q, 1));
+
+    q.sent(3);
+    EXPECT_TRUE(q.empty());
+    EXPECT_EQ("", gathered(q, 0));
+
+    q.push(response("ij"));
+    EXPECT_EQ("ij", gathered(q, 0));
+}
+
+TEST(OutputQueueTest, FullAtLimit) {
+    OutputQueue q(10);
+    q.push(response("123456789"));
+    EXPECT_FALSE(q.full());
+    q.push(response("0"));
+    EXPECT_TRUE(q.full());
+    q.sent(1);
+    EXPECT_FALSE(q.full());
+
+    q.clear();
+    EXPECT_TRUE(q.empty());
+    EXPECT_FALSE(q.full());
+
+    // Zero limit would never let connection read anything
+    OutputQueue tiny(0);
+    EXPECT_FALSE(tiny.full());
+    tiny.push(response("x"));
+    EXPECT_TRUE(tiny.full());
+}
+
+TEST(OutputQueueTest, WholeQueueBySingleWrite) {
+    int fds[2];
+    ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+
+    OutputQueue q(1 << 20);
+    string expected;
+    for (int i = 0; i < 100; i++) {
+        string text = "VALUE k" + to_string(i) + " 0 1\r\nx\r\nEND\r\n";
+        q.push(response(text));
+        expected += text;
+    }
+
+    // More responses than iovecs, so writes are repeated until drained
+    size_t writes = 0;
+    while (!q.empty()) {
+        ASSERT_GT(q.write(fds[0]), 0);
+        writes++;
+    }
+    EXPECT_EQ((100 + OutputQueue::max_iovecs - 1) / OutputQueue::max_iovecs, writes);
+
+    string received(expected.size(), '\0');
+    size_t done = 0;
+    while (done < received.size()) {
+        ssize_t n = read(fds[1], &received[done], received.size() - done);
+        ASSERT_GT(n, 0);
+        done += n;
+    }
+    EXPECT_EQ(expected, received);
+
+    q.push(response("tail"));
+    EXPECT_TRUE(q.flush(fds[0]));
+    EXPECT_TRUE(q.empty());
+
+    close(fds[0]);
+    close(fds[1]);
+}
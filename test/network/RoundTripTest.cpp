@@ -0,0 +1,72 @@
+#include "gtest/gtest.h"
+#include <memory>
+#include <string>
+
+#include <unistd.h>
+
+#include "network/mt_reuseport/ServerImpl.h"
+#include "network/st_coroutine/ServerImpl.h"
+#include "network/uring/ServerImpl.h"
+#include "storage/SimpleLRU.h"
+
+#include "TestClient.h"
+
+using namespace std;
+using namespace Afina;
+using namespace Afina::Test;
+
+namespace {
+
+/**
+ * Stores values through one client and reads them back through another, including value that doesn't fit
+ * into a single socket read
+ */
+void set_get(Network::Server &server, uint16_t port) {
+    int writer = connect_to(port), reader = connect_to(port);
+    ASSERT_NE(-1, writer);
+    ASSERT_NE(-1, reader);
+
+    string large(10000, 'x');
+    string request = "set small 0 0 5\r\nvalue\r\nset large 0 0 10000\r\n" + large + "\r\n";
+    EXPECT_EQ("STORED\r\nSTORED\r\n", round_trip(writer, request, 16));
+
+    string expected = "VALUE small 0 5\r\nvalue\r\nEND\r\n";
+    EXPECT_EQ(expected, round_trip(reader, "get small\r\n", expected.size()));
+
+    expected = "VALUE small 0 5\r\nvalue\r\nVALUE large 0 10000\r\n" + large + "\r\nEND\r\n";
+    EXPECT_EQ(expected, round_trip(reader, "get small missing large\r\n", expected.size()));
+
+    EXPECT_EQ("END\r\n", round_trip(reader, "get missing\r\n", 5));
+
+    close(writer);
+    close(reader);
+    server.Stop();
+    server.Join();
+}
+
+} // namespace
+
+TEST(MTreuseportTest, SetGet) {
+    shared_ptr<Storage> storage(new Backend::SimpleLRU(1 << 20));
+    uint16_t port = free_port();
+    Network::MTreuseport::ServerImpl server(storage, logging());
+    server.Start(port, 1, 2);
+    set_get(server, port);
+}
+
+TEST(UringTest, SetGet) {
+    // Falls back to reuseport server where kernel has no io_uring
+    shared_ptr<Storage> storage(new Backend::SimpleLRU(1 << 20));
+    uint16_t port = free_port();
+    Network::Uring::ServerImpl server(storage, logging());
+    server.Start(port, 1, 2);
+    set_get(server, port);
+}
+
+TEST(STcoroutineTest, SetGet) {
+    shared_ptr<Storage> storage(new Backend::SimpleLRU(1 << 20));
+    uint16_t port = free_port();
+    Network::STcoroutine::ServerImpl server(storage, logging());
+    server.Start(port, 1, 1);
+    set_get(server, port);
+}
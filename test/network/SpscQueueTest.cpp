@@ -0,0 +1,79 @@
+#include "gtest/gtest.h"
+#include <thread>
+
+#include "network/SpscQueue.h"
+
+using namespace std;
+using namespace Afina::Network;
+
+TEST(SpscQueueTest, CapacityRoundedUp) {
+    SpscQueue<int> q(5);
+    EXPECT_EQ(q.capacity(), 8);
+
+    for (int i = 0; i < 8; i++) {
+        EXPECT_TRUE(q.push(i));
+    }
+    EXPECT_FALSE(q.push(8));
+}
+
+TEST(SpscQueueTest, FifoAcrossWrap) {
+    SpscQueue<int> q(4);
+    int value = -1;
+    EXPECT_FALSE(q.pop(value));
+
+    // Indices run over capacity many times, order must hold
+    int next = 0;
+    for (int round = 0; round < 100; round++) {
+        EXPECT_TRUE(q.push(round * 3));
+        EXPECT_TRUE(q.push(round * 3 + 1));
+        EXPECT_TRUE(q.push(round * 3 + 2));
+        for (int i = 0; i < 3; i++) {
+            ASSERT_TRUE(q.pop(value));
+            EXPECT_EQ(next++, value);
+        }
+    }
+    EXPECT_FALSE(q.pop(value));
+}
+
+TEST(SpscQueueTest, FullThenDrained) {
+    SpscQueue<int> q(2);
+    EXPECT_TRUE(q.push(1));
+    EXPECT_TRUE(q.push(2));
+    EXPECT_FALSE(q.push(3));
+
+    int value = 0;
+    ASSERT_TRUE(q.pop(value));
+    EXPECT_EQ(1, value);
+
+    // Producer sees the freed slot once it rereads the head
+    EXPECT_TRUE(q.push(3));
+    ASSERT_TRUE(q.pop(value));
+    EXPECT_EQ(2, value);
+    ASSERT_TRUE(q.pop(value));
+    EXPECT_EQ(3, value);
+}
+
+TEST(SpscQueueTest, ConcurrentProducerConsumer) {
+    const size_t count = 1000000;
+    SpscQueue<size_t> q(64);
+
+    std::thread producer([&q, count]() {
+        for (size_t i = 0; i < count; i++) {
+            while (!q.push(i)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    size_t expected = 0;
+    while (expected < count) {
+        size_t value;
+        if (!q.pop(value)) {
+            std::this_thread::yield();
+            continue;
+        }
+        ASSERT_EQ(expected, value);
+        expected++;
+    }
+    producer.join();
+}
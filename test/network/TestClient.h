@@ -0,0 +1,103 @@
+#ifndef AFINA_TEST_NETWORK_TEST_CLIENT_H
+#define AFINA_TEST_NETWORK_TEST_CLIENT_H
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <afina/logging/Config.h>
+
+#include "logging/ServiceImpl.h"
+
+namespace Afina {
+namespace Test {
+
+// Port nobody listens on right now
+inline uint16_t free_port() {
+    int s = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(s, (struct sockaddr *)&addr, sizeof(addr));
+    socklen_t len = sizeof(addr);
+    getsockname(s, (struct sockaddr *)&addr, &len);
+    close(s);
+    return ntohs(addr.sin_port);
+}
+
+// Blocking client socket, reads time out so broken server fails the test instead of hanging it
+inline int connect_to(uint16_t port) {
+    int s = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(s, (struct sockaddr *)&addr, sizeof(addr)) == -1) {
+        close(s);
+        return -1;
+    }
+
+    struct timeval timeout = {5, 0};
+    setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    return s;
+}
+
+inline bool send_all(int s, const std::string &data) {
+    std::size_t done = 0;
+    while (done < data.size()) {
+        ssize_t n = send(s, data.data() + done, data.size() - done, MSG_NOSIGNAL);
+        if (n <= 0) {
+            return false;
+        }
+        done += n;
+    }
+    return true;
+}
+
+// Reads until the given number of bytes is received, returns less once connection is closed or times out
+inline std::string recv_size(int s, std::size_t size) {
+    std::string result;
+    char buffer[4096];
+    while (result.size() < size) {
+        ssize_t n = recv(s, buffer, std::min(sizeof(buffer), size - result.size()), 0);
+        if (n <= 0) {
+            break;
+        }
+        result.append(buffer, n);
+    }
+    return result;
+}
+
+// Sends the request and waits for the response of the given size
+inline std::string round_trip(int s, const std::string &request, std::size_t size) {
+    if (!send_all(s, request)) {
+        return std::string();
+    }
+    return recv_size(s, size);
+}
+
+// Loggers are registered globally, so service is started once for all tests
+inline std::shared_ptr<Logging::Service> logging() {
+    static std::shared_ptr<Logging::Service> service;
+    if (!service) {
+        std::shared_ptr<Logging::Config> config(new Logging::Config);
+        config->appenders["console"].type = Logging::Appender::Type::STDERR;
+        config->loggers["root"].level = Logging::Logger::Level::ERROR;
+        config->loggers["root"].appenders.push_back("console");
+        service.reset(new Logging::ServiceImpl(config));
+        service->Start();
+    }
+    return service;
+}
+
+} // namespace Test
+} // namespace Afina
+
+#endif // AFINA_TEST_NETWORK_TEST_CLIENT_H
@@ -5,6 +5,7 @@
 
 #include <afina/execute/Add.h>
 #include <afina/execute/Get.h>
+#include <afina/execute/Replace.h>
 #include <afina/execute/Set.h>
 #include <afina/execute/Stats.h>
 
@@ -58,6 +59,27 @@ TEST(MemcachedParserTest, SimpleAdd) {
     ASSERT_EQ(-1, tmp->expire());
 }
 
+// Verify multi digit expiration time passed to replace command
+TEST(MemcachedParserTest, ReplaceExpire) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    bool cmd_avail = parser.Parse("replace baz 5 3600 3\r\nbaz\r\n", consumed);
+    ASSERT_TRUE(cmd_avail);
+    ASSERT_EQ(22, consumed);
+    ASSERT_EQ("replace", parser.Name());
+
+    size_t value_size;
+    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    ASSERT_FALSE(cmd == nullptr);
+    ASSERT_EQ(3, value_size);
+
+    Execute::Replace *tmp = reinterpret_cast<Execute::Replace *>(cmd.get());
+    ASSERT_EQ("baz", tmp->key());
+    ASSERT_EQ(5, tmp->flags());
+    ASSERT_EQ(3600, tmp->expire());
+}
+
 // Verify simple get command passed in a single string
 TEST(MemcachedParserTest, SimpleGet) {
     Protocol::Parser parser;
@@ -81,6 +103,29 @@ TEST(MemcachedParserTest, SimpleGet) {
     ASSERT_EQ("super_long_key", keys[2]);
 }
 
+// Verify gets builds get command reporting cas
+TEST(MemcachedParserTest, Gets) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    bool cmd_avail = parser.Parse("gets foo bar\r\n", consumed);
+    ASSERT_TRUE(cmd_avail);
+    ASSERT_EQ(14, consumed);
+    ASSERT_EQ("gets", parser.Name());
+
+    size_t value_size;
+    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    ASSERT_FALSE(cmd == nullptr);
+    ASSERT_EQ(0, value_size);
+
+    Execute::Get *tmp = dynamic_cast<Execute::Get *>(cmd.get());
+    ASSERT_FALSE(tmp == nullptr);
+    ASSERT_TRUE(tmp->cas());
+    ASSERT_EQ(2, tmp->keys().size());
+    ASSERT_EQ("foo", tmp->keys()[0]);
+    ASSERT_EQ("bar", tmp->keys()[1]);
+}
+
 TEST(MemcachedParserTest, Stats) {
     Protocol::Parser parser;
 
@@ -0,0 +1,144 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <afina/Storage.h>
+
+#include "storage/ClockLRU.h"
+#include "storage/ShardedLRU.h"
+#include "storage/ThreadSafeSimpleLRU.h"
+
+using namespace Afina::Backend;
+
+// Multi-threaded throughput of thread safe storages: every worker runs mixed workload of 90% Get and
+// 10% Put over shared set of keys, result is total number of operations per second. Then single thread
+// multi-get of 100 random keys is measured both key by key and as a batch, result is keys per second
+//
+// Usage: runStorageBenchmark [max_threads] [ops_per_thread]
+
+namespace {
+
+const size_t keys_count = 100000;
+
+std::string make_key(uint64_t i) { return "key_" + std::to_string(i); }
+
+// Tiny xorshift generator, each worker has its own one
+uint64_t next_random(uint64_t &state) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+double run(Afina::Storage &storage, int threads, long ops) {
+    std::vector<std::thread> workers;
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&storage, t, ops]() {
+            uint64_t state = 88172645463325252ull + t;
+            std::string value;
+            for (long i = 0; i < ops; i++) {
+                uint64_t r = next_random(state);
+                std::string key = make_key(r % keys_count);
+                if (r % 10 == 0) {
+                    storage.Put(key, key);
+                } else {
+                    storage.Get(key, value);
+                }
+            }
+        });
+    }
+
+    for (auto &w : workers) {
+        w.join();
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return threads * ops / elapsed.count();
+}
+
+// Looks up random batches of keys either one by one or by a single GetMany call
+double run_multiget(Afina::Storage &storage, size_t batch, long rounds, bool batched) {
+    uint64_t state = 88172645463325252ull;
+    std::vector<std::string> names(batch);
+    std::vector<Afina::StringView> keys(batch);
+    size_t found = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (long r = 0; r < rounds; r++) {
+        for (size_t i = 0; i < batch; i++) {
+            names[i] = make_key(next_random(state) % keys_count);
+            keys[i] = Afina::StringView(names[i]);
+        }
+
+        if (batched) {
+            found += storage.GetMany(keys, 1024, [](size_t, Afina::StringView, uint32_t, Afina::Storage::Holder) {});
+        } else {
+            for (size_t i = 0; i < batch; i++) {
+                found += storage.Pin(keys[i], 1024, [](Afina::StringView, uint32_t, Afina::Storage::Holder) {});
+            }
+        }
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    if (found != batch * rounds) {
+        std::cerr << "Only " << found << " of " << batch * rounds << " keys found" << std::endl;
+    }
+    return batch * rounds / elapsed.count();
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    int max_threads = argc > 1 ? std::atoi(argv[1]) : 8;
+    long ops = argc > 2 ? std::atol(argv[2]) : 200000;
+    const size_t max_size = keys_count * 64;
+
+    std::cout << std::setw(12) << "storage" << std::setw(10) << "threads" << std::setw(16) << "ops/sec" << std::endl;
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+        std::unique_ptr<Afina::Storage> storages[] = {
+            std::unique_ptr<Afina::Storage>(new ThreadSafeSimplLRU(max_size)),
+            std::unique_ptr<Afina::Storage>(new ShardedLRU(max_size, 64)),
+            std::unique_ptr<Afina::Storage>(new ClockLRU(max_size)),
+        };
+        const char *names[] = {"mt_lru", "sharded_lru", "clock_lru"};
+
+        for (int s = 0; s < 3; s++) {
+            for (size_t i = 0; i < keys_count; i++) {
+                storages[s]->Put(make_key(i), make_key(i));
+            }
+
+            double result = run(*storages[s], threads, ops);
+            std::cout << std::setw(12) << names[s] << std::setw(10) << threads << std::setw(16) << std::fixed
+                      << std::setprecision(0) << result << std::endl;
+        }
+    }
+
+    std::cout << std::endl
+              << std::setw(12) << "storage" << std::setw(16) << "per key" << std::setw(16) << "batched" << std::endl;
+    std::unique_ptr<Afina::Storage> storages[] = {
+        std::unique_ptr<Afina::Storage>(new ThreadSafeSimplLRU(max_size)),
+        std::unique_ptr<Afina::Storage>(new ShardedLRU(max_size, 64)),
+        std::unique_ptr<Afina::Storage>(new ClockLRU(max_size)),
+    };
+    const char *names[] = {"mt_lru", "sharded_lru", "clock_lru"};
+    for (int s = 0; s < 3; s++) {
+        for (size_t i = 0; i < keys_count; i++) {
+            storages[s]->Put(make_key(i), make_key(i));
+        }
+
+        long rounds = ops / 100;
+        double single = run_multiget(*storages[s], 100, rounds, false);
+        double batched = run_multiget(*storages[s], 100, rounds, true);
+        std::cout << std::setw(12) << names[s] << std::setw(16) << std::fixed << std::setprecision(0) << single
+                  << std::setw(16) << batched << std::endl;
+    }
+
+    return 0;
+}
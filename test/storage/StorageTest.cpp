@@ -1,7 +1,15 @@
 #include "gtest/gtest.h"
+#include <algorithm>
+#include <cmath>
 #include <iomanip>
 #include <iostream>
+#include <list>
+#include <map>
+#include <memory>
 #include <set>
+#include <chrono>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 #include <afina/execute/Add.h>
@@ -10,7 +18,13 @@
 #include <afina/execute/Get.h>
 #include <afina/execute/Set.h>
 
+#include "storage/ArenaLRU.h"
+#include "storage/ClockLRU.h"
+#include "storage/Entry.h"
+#include "storage/ShardedLRU.h"
 #include "storage/SimpleLRU.h"
+#include "storage/ThreadSafeSimpleLRU.h"
+#include "storage/TimingWheel.h"
 
 using namespace Afina::Backend;
 using namespace Afina::Execute;
@@ -108,3 +122,819 @@ TEST(StorageTest, MaxTest) {
         EXPECT_FALSE(storage.Get(key, res));
     }
 }
+
+TEST(StorageTest, ShardedPutGet) {
+    ShardedLRU storage(2 * 1000 * 20, 4);
+    EXPECT_EQ(4, storage.Shards());
+
+    for (long i = 0; i < 100; ++i) {
+        EXPECT_TRUE(storage.Put("Key " + std::to_string(i), "Val " + std::to_string(i)));
+    }
+
+    for (long i = 0; i < 100; ++i) {
+        std::string res;
+        EXPECT_TRUE(storage.Get("Key " + std::to_string(i), res));
+        EXPECT_EQ("Val " + std::to_string(i), res);
+    }
+
+    EXPECT_FALSE(storage.PutIfAbsent("Key 1", "other"));
+    EXPECT_TRUE(storage.Set("Key 1", "other"));
+    EXPECT_TRUE(storage.Delete("Key 1"));
+    EXPECT_FALSE(storage.Set("Key 1", "other"));
+
+    std::string res;
+    EXPECT_FALSE(storage.Get("Key 1", res));
+}
+
+TEST(StorageTest, ShardedSmallBudget) {
+    ShardedLRU storage(1024);
+    EXPECT_EQ(1, storage.Shards());
+    EXPECT_TRUE(storage.Put("Key", std::string(500, 'v')));
+
+    EXPECT_EQ(2, ShardedLRU(8192).Shards());
+    EXPECT_EQ(16, ShardedLRU(1 << 20).Shards());
+}
+
+TEST(StorageTest, ShardedConcurrent) {
+    const size_t length = 20;
+    const int threads = 4, per_thread = 5000;
+    ShardedLRU storage(2 * threads * per_thread * length * 2, 8);
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&storage, t]() {
+            for (int i = 0; i < per_thread; i++) {
+                auto key = pad_space("Key " + std::to_string(t) + " " + std::to_string(i), length);
+                auto val = pad_space("Val " + std::to_string(i), length);
+                storage.Put(key, val);
+
+                std::string res;
+                if (storage.Get(key, res)) {
+                    EXPECT_EQ(val, res);
+                }
+            }
+        });
+    }
+
+    for (auto &w : workers) {
+        w.join();
+    }
+
+    std::string res;
+    auto key = pad_space("Key 0 " + std::to_string(per_thread - 1), length);
+    EXPECT_TRUE(storage.Get(key, res));
+}
+
+TEST(StorageTest, RandomOpsMatchModel) {
+    const size_t keys = 500;
+    SimpleLRU storage(1 << 30);
+    std::map<std::string, std::string> model;
+
+    uint64_t state = 42;
+    for (int i = 0; i < 100000; ++i) {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        auto key = "Key " + std::to_string((state >> 33) % keys);
+        auto val = "Val " + std::to_string(i);
+
+        std::string res;
+        switch ((state >> 20) % 4) {
+        case 0:
+            EXPECT_TRUE(storage.Put(key, val));
+            model[key] = val;
+            break;
+        case 1:
+            EXPECT_EQ(model.count(key) == 0, storage.PutIfAbsent(key, val));
+            model.insert(std::make_pair(key, val));
+            break;
+        case 2:
+            EXPECT_EQ(model.erase(key) == 1, storage.Delete(key));
+            break;
+        default:
+            EXPECT_EQ(model.count(key) == 1, storage.Get(key, res));
+            if (model.count(key) == 1) {
+                EXPECT_EQ(model[key], res);
+            }
+        }
+    }
+
+    for (auto &kv : model) {
+        std::string res;
+        EXPECT_TRUE(storage.Get(kv.first, res));
+        EXPECT_EQ(kv.second, res);
+    }
+}
+
+TEST(StorageTest, HugeDestroy) {
+    // Used to overflow stack by recursive node destruction
+    const size_t count = 2000000;
+    std::unique_ptr<SimpleLRU> storage(new SimpleLRU(count * 16));
+    for (size_t i = 0; i < count; ++i) {
+        storage->Put(std::to_string(i), "v");
+    }
+
+    std::string res;
+    EXPECT_TRUE(storage->Get("0", res));
+    storage.reset();
+}
+
+TEST(StorageTest, ViewPutGet) {
+    SimpleLRU storage;
+
+    const char buffer[] = "KEY1val1";
+    EXPECT_TRUE(storage.Put(Afina::StringView(buffer, 4), Afina::StringView(buffer + 4, 4), 0, 0));
+    EXPECT_FALSE(storage.PutIfAbsent(Afina::StringView(buffer, 4), Afina::StringView("other", 5), 0, 0));
+
+    std::string value;
+    EXPECT_TRUE(storage.Get(Afina::StringView("KEY1", 4), value));
+    EXPECT_EQ("val1", value);
+
+    int calls = 0;
+    EXPECT_TRUE(storage.Get(Afina::StringView("KEY1", 4), [&calls](Afina::StringView v, uint32_t flags) {
+        calls++;
+        EXPECT_EQ(Afina::StringView("val1", 4), v);
+    }));
+    EXPECT_FALSE(storage.Get(Afina::StringView("KEY2", 4), [&calls](Afina::StringView v, uint32_t flags) { calls++; }));
+    EXPECT_EQ(1, calls);
+
+    EXPECT_TRUE(storage.Set(Afina::StringView("KEY1", 4), Afina::StringView("val2", 4), 0, 0));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("val2", value);
+
+    EXPECT_TRUE(storage.Delete(Afina::StringView("KEY1", 4)));
+    EXPECT_FALSE(storage.Get("KEY1", value));
+}
+
+TEST(StorageTest, ShardedViewGet) {
+    ShardedLRU storage(1024, 4);
+    storage.Put("KEY1", "val1");
+
+    std::string value;
+    EXPECT_TRUE(storage.Get(Afina::StringView("KEY1", 4), [&value](Afina::StringView v, uint32_t flags) { value = v.str(); }));
+    EXPECT_EQ("val1", value);
+}
+
+TEST(StorageTest, ClockPutGet) {
+    ClockLRU storage(2 * 1000 * 20);
+
+    for (long i = 0; i < 100; ++i) {
+        EXPECT_TRUE(storage.Put("Key " + std::to_string(i), "Val " + std::to_string(i)));
+    }
+
+    for (long i = 0; i < 100; ++i) {
+        std::string res;
+        EXPECT_TRUE(storage.Get("Key " + std::to_string(i), res));
+        EXPECT_EQ("Val " + std::to_string(i), res);
+    }
+
+    EXPECT_FALSE(storage.PutIfAbsent("Key 1", "other"));
+    EXPECT_TRUE(storage.Set("Key 1", "other"));
+    EXPECT_TRUE(storage.Delete("Key 1"));
+    EXPECT_FALSE(storage.Set("Key 1", "other"));
+
+    std::string res;
+    EXPECT_FALSE(storage.Get("Key 1", res));
+}
+
+TEST(StorageTest, ClockEvictsUnreferenced) {
+    // Room for exactly 4 entries of 10 bytes
+    ClockLRU storage(40);
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_TRUE(storage.Put("Key " + std::to_string(i), "Val" + std::to_string(i) + "a"));
+    }
+
+    // Keys 0 and 2 are read, so get second chance
+    std::string res;
+    EXPECT_TRUE(storage.Get("Key 0", res));
+    EXPECT_TRUE(storage.Get("Key 2", res));
+
+    EXPECT_TRUE(storage.Put("Key 4", "Val4a"));
+    EXPECT_TRUE(storage.Put("Key 5", "Val5a"));
+    EXPECT_EQ(40, storage.Size());
+
+    EXPECT_TRUE(storage.Get("Key 0", res));
+    EXPECT_FALSE(storage.Get("Key 1", res));
+    EXPECT_TRUE(storage.Get("Key 2", res));
+    EXPECT_FALSE(storage.Get("Key 3", res));
+    EXPECT_TRUE(storage.Get("Key 4", res));
+    EXPECT_TRUE(storage.Get("Key 5", res));
+}
+
+TEST(StorageTest, ClockConcurrent) {
+    const size_t length = 20;
+    const int threads = 4, per_thread = 5000;
+    // Room for a quarter of keys, so writers keep evicting while readers are running
+    ClockLRU storage(threads * per_thread * length * 2 / 4);
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&storage, t]() {
+            for (int i = 0; i < per_thread; i++) {
+                auto key = pad_space("Key " + std::to_string(t) + " " + std::to_string(i), length);
+                auto val = pad_space("Val " + std::to_string(i), length);
+                storage.Put(key, val);
+
+                for (int j = std::max(0, i - 8); j <= i; j++) {
+                    auto old_key = pad_space("Key " + std::to_string(t) + " " + std::to_string(j), length);
+                    std::string res;
+                    if (storage.Get(old_key, res)) {
+                        EXPECT_EQ(pad_space("Val " + std::to_string(j), length), res);
+                    }
+                }
+            }
+        });
+    }
+
+    for (auto &w : workers) {
+        w.join();
+    }
+
+    EXPECT_LE(storage.Size(), threads * per_thread * length * 2 / 4);
+}
+
+// Replays the same Zipfian trace against strict and approximate LRU: every request is Get and on miss
+// value is Put, as cache-aside client would do. CLOCK must stay close to the strict LRU hit ratio
+TEST(StorageTest, ClockHitRatioCloseToLRU) {
+    const size_t keys = 100000, requests = 1000000;
+    const double skew = 0.99;
+
+    // Cumulative distribution of the Zipf law over key ranks
+    std::vector<double> cdf(keys);
+    double sum = 0;
+    for (size_t i = 0; i < keys; i++) {
+        sum += 1.0 / std::pow(double(i + 1), skew);
+        cdf[i] = sum;
+    }
+
+    std::vector<std::string> trace;
+    trace.reserve(requests);
+    uint64_t state = 42;
+    for (size_t i = 0; i < requests; i++) {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        double p = double(state >> 11) / double(1ull << 53) * sum;
+        size_t rank = std::lower_bound(cdf.begin(), cdf.end(), p) - cdf.begin();
+        trace.push_back(pad_space("Key " + std::to_string(rank), 16));
+    }
+
+    // Cache holds 10% of all keys, each entry is 32 bytes of key and value
+    const size_t capacity = keys / 10;
+
+    // Strict LRU reference: hit moves key to the front, miss evicts the back once cache is full
+    size_t lru_hits = 0;
+    {
+        std::list<std::string> order;
+        std::unordered_map<std::string, std::list<std::string>::iterator> index;
+        for (auto &key : trace) {
+            auto it = index.find(key);
+            if (it != index.end()) {
+                lru_hits++;
+                order.splice(order.begin(), order, it->second);
+                continue;
+            }
+
+            if (order.size() == capacity) {
+                index.erase(order.back());
+                order.pop_back();
+            }
+            order.push_front(key);
+            index[key] = order.begin();
+        }
+    }
+
+    ClockLRU clock(capacity * 32);
+    size_t clock_hits = 0;
+    std::string res;
+    for (auto &key : trace) {
+        if (clock.Get(key, res)) {
+            clock_hits++;
+        } else {
+            clock.Put(key, key);
+        }
+    }
+
+    EXPECT_GT(double(clock_hits) / requests, double(lru_hits) / requests - 0.02);
+}
+
+TEST(StorageTest, TimingWheelExpiresInOrder) {
+    const uint64_t tick = TimingWheel::tick_ms;
+    const size_t count = 5000;
+    TimingWheel wheel;
+    uint64_t now = TimingWheel::now();
+
+    // Spread expiration across several levels: from right now up to a couple of weeks
+    std::vector<uint64_t> expire(count);
+    uint64_t state = 42;
+    for (size_t i = 0; i < count; i++) {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        uint64_t range = uint64_t(1000) << ((state >> 40) % 21);
+        expire[i] = now + (state >> 20) % range;
+        wheel.schedule(i, expire[i]);
+    }
+
+    // Every fifth node is cancelled and must never be reported
+    for (size_t i = 0; i < count; i += 5) {
+        wheel.cancel(i);
+    }
+    EXPECT_EQ(count - count / 5, wheel.size());
+
+    std::vector<int> reported(count, 0);
+    uint64_t end = now + (uint64_t(1000) << 21);
+    while (now < end) {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        now += (state >> 20) % (1000 * 60 * 60);
+
+        wheel.advance(now, [&](TimingWheel::node_id id) {
+            reported[id]++;
+            EXPECT_LE(expire[id], now);
+        });
+
+        // Nodes expired at least one tick ago must be reported already
+        for (size_t i = 1; i < count; i += 97) {
+            if (i % 5 != 0 && expire[i] + tick <= now) {
+                EXPECT_EQ(1, reported[i]);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        EXPECT_EQ(i % 5 == 0 ? 0 : 1, reported[i]);
+    }
+    EXPECT_EQ(0, wheel.size());
+}
+
+TEST(StorageTest, ExpireOnAccess) {
+    SimpleLRU storage;
+
+    EXPECT_TRUE(storage.Put(Afina::StringView("Key 1", 5), Afina::StringView("Val 1", 5), 0, 1));
+    EXPECT_TRUE(storage.Put(Afina::StringView("Key 2", 5), Afina::StringView("Val 2", 5), 0, 0));
+    EXPECT_TRUE(storage.Put(Afina::StringView("Key 3", 5), Afina::StringView("Val 3", 5), 0, -1));
+
+    std::string res;
+    EXPECT_TRUE(storage.Get("Key 1", res));
+    EXPECT_TRUE(storage.Get("Key 2", res));
+    EXPECT_FALSE(storage.Get("Key 3", res));
+    EXPECT_EQ(20, storage.Size());
+
+    // Negative ttl removes existing value
+    EXPECT_TRUE(storage.Set(Afina::StringView("Key 2", 5), Afina::StringView("Val 2", 5), 0, -1));
+    EXPECT_FALSE(storage.Get("Key 2", res));
+    EXPECT_EQ(10, storage.Size());
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    EXPECT_FALSE(storage.Get("Key 1", res));
+    EXPECT_FALSE(storage.Set("Key 1", "other"));
+    EXPECT_EQ(0, storage.Size());
+
+    EXPECT_TRUE(storage.Put(Afina::StringView("Key 1", 5), Afina::StringView("Val 1", 5), 0, 1));
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    EXPECT_TRUE(storage.PutIfAbsent("Key 1", "other"));
+    EXPECT_TRUE(storage.Get("Key 1", res));
+    EXPECT_EQ("other", res);
+}
+
+// Room for exactly 4 entries of 10 bytes. Expired entry has to go away before least recently used one
+template <typename T> void expired_evicted_first() {
+    T storage(40);
+    EXPECT_TRUE(storage.Put("Key 0", "Val 0"));
+    EXPECT_TRUE(storage.Put(Afina::StringView("Key 1", 5), Afina::StringView("Val 1", 5), 0, 1));
+    EXPECT_TRUE(storage.Put("Key 2", "Val 2"));
+    EXPECT_TRUE(storage.Put("Key 3", "Val 3"));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    EXPECT_EQ(40, storage.Size());
+    EXPECT_TRUE(storage.Put("Key 4", "Val 4"));
+
+    std::string res;
+    EXPECT_TRUE(storage.Get("Key 0", res));
+    EXPECT_FALSE(storage.Get("Key 1", res));
+    EXPECT_TRUE(storage.Get("Key 4", res));
+    EXPECT_EQ(40, storage.Size());
+}
+
+TEST(StorageTest, ExpiredEvictedFirst) { expired_evicted_first<SimpleLRU>(); }
+
+TEST(StorageTest, ClockExpiredEvictedFirst) { expired_evicted_first<ClockLRU>(); }
+
+TEST(StorageTest, BackgroundExpire) {
+    ThreadSafeSimplLRU storage;
+    storage.Start();
+
+    EXPECT_TRUE(storage.Put(Afina::StringView("Key 1", 5), Afina::StringView("Val 1", 5), 0, 1));
+    EXPECT_TRUE(storage.Put("Key 2", "Val 2"));
+
+    // Entry expires after a second, sweeper runs once a second and wheel could be late for one tick
+    std::this_thread::sleep_for(std::chrono::milliseconds(2300));
+    storage.Stop();
+
+    std::string res;
+    EXPECT_TRUE(storage.Get("Key 2", res));
+    EXPECT_EQ(10, storage.Size());
+}
+
+// Flags and expiration time are stored with the value, plain Set and Append keep them
+template <typename T> void flags_round_trip() {
+    T storage(1024);
+    uint32_t flags = 0;
+    std::string res;
+    auto reader = [&flags, &res](Afina::StringView v, uint32_t f) {
+        res = v.str();
+        flags = f;
+    };
+
+    EXPECT_TRUE(storage.Put(Afina::StringView("Key 1", 5), Afina::StringView("Val 1", 5), 0xDEADBEEF, 0));
+    EXPECT_TRUE(storage.Get(Afina::StringView("Key 1", 5), reader));
+    EXPECT_EQ(0xDEADBEEF, flags);
+    EXPECT_EQ("Val 1", res);
+
+    EXPECT_TRUE(storage.Set("Key 1", "Longer value 1"));
+    EXPECT_TRUE(storage.Append(Afina::StringView("Key 1", 5), Afina::StringView(" tail", 5)));
+    EXPECT_TRUE(storage.Get(Afina::StringView("Key 1", 5), reader));
+    EXPECT_EQ(0xDEADBEEF, flags);
+    EXPECT_EQ("Longer value 1 tail", res);
+
+    EXPECT_TRUE(storage.Set(Afina::StringView("Key 1", 5), Afina::StringView("V", 1), 7, 1));
+    EXPECT_TRUE(storage.Get(Afina::StringView("Key 1", 5), reader));
+    EXPECT_EQ(7, flags);
+    EXPECT_EQ("V", res);
+
+    EXPECT_FALSE(storage.Append(Afina::StringView("Key 2", 5), Afina::StringView(" tail", 5)));
+
+    // Append doesn't prolong entry life
+    EXPECT_TRUE(storage.Append(Afina::StringView("Key 1", 5), Afina::StringView("al", 2)));
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    EXPECT_FALSE(storage.Get("Key 1", res));
+}
+
+TEST(StorageTest, FlagsRoundTrip) { flags_round_trip<SimpleLRU>(); }
+
+TEST(StorageTest, ClockFlagsRoundTrip) { flags_round_trip<ClockLRU>(); }
+
+TEST(StorageTest, ShardedFlagsRoundTrip) { flags_round_trip<ShardedLRU>(); }
+
+TEST(StorageTest, ArenaFlagsRoundTrip) { flags_round_trip<ArenaLRU>(); }
+
+// Each entry takes 24 bytes block and 8 bytes descriptor, so arena has room for exactly 4 of them
+TEST(StorageTest, ArenaEvictsLRU) {
+    const size_t max_size = ArenaLRU::Overhead(8) + 128;
+    ArenaLRU storage(max_size, 8);
+    for (int i = 0; i < 4; i++) {
+        EXPECT_TRUE(storage.Put("Key " + std::to_string(i), "Val " + std::to_string(i)));
+    }
+    EXPECT_EQ(max_size, storage.Size());
+
+    EXPECT_TRUE(storage.Set("Key 0", "Val 0"));
+    EXPECT_TRUE(storage.Put("Key 4", "Val 4"));
+
+    std::string res;
+    EXPECT_TRUE(storage.Get("Key 0", res));
+    EXPECT_FALSE(storage.Get("Key 1", res));
+    EXPECT_TRUE(storage.Get("Key 4", res));
+    EXPECT_EQ(max_size, storage.Size());
+}
+
+// Bookkeeping comes out of the budget too, so number of entries is capped even if arena has room
+TEST(StorageTest, ArenaEvictsOnEntryLimit) {
+    ArenaLRU storage(1 << 16, 4);
+    EXPECT_EQ(ArenaLRU::Overhead(4), storage.Size());
+    for (int i = 0; i < 4; i++) {
+        EXPECT_TRUE(storage.Put("Key " + std::to_string(i), "Val " + std::to_string(i)));
+    }
+    EXPECT_TRUE(storage.Set("Key 0", "Val 0"));
+    EXPECT_TRUE(storage.Put(Afina::StringView("Key 4", 5), Afina::StringView("Val 4", 5), 0, 1));
+
+    std::string res;
+    EXPECT_TRUE(storage.Get("Key 0", res));
+    EXPECT_FALSE(storage.Get("Key 1", res));
+    EXPECT_TRUE(storage.Get("Key 4", res));
+
+    // Expired entry goes away before least recently used one
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    EXPECT_TRUE(storage.Put("Key 5", "Val 5"));
+    EXPECT_TRUE(storage.Get("Key 2", res));
+
+    // Reservation holds its node until commit
+    for (int i = 0; i < 4; i++) {
+        EXPECT_TRUE(storage.Put("Key " + std::to_string(i), "Val " + std::to_string(i)));
+    }
+    std::vector<std::unique_ptr<Afina::Storage::Reservation>> pending;
+    for (int i = 0; i < 4; i++) {
+        pending.push_back(storage.Reserve(Afina::Storage::WriteMode::Put, Afina::StringView("Reserved", 8), 5, 0, 0));
+        EXPECT_TRUE(pending.back() != nullptr);
+    }
+    EXPECT_FALSE(storage.Get("Key 3", res));
+    EXPECT_TRUE(storage.Reserve(Afina::Storage::WriteMode::Put, Afina::StringView("Other", 5), 5, 0, 0) == nullptr);
+    EXPECT_FALSE(storage.Put("Key 0", "Val 0"));
+}
+
+// Value sizes drift, so space freed by old sizes is reusable only after compaction
+TEST(StorageTest, ArenaSizeIsHardCap) {
+    const size_t max_size = 1 << 16;
+    ArenaLRU storage(max_size);
+
+    // Tiny entries run out of bookkeeping before arena is full
+    for (int i = 0; i < 10000; ++i) {
+        ASSERT_TRUE(storage.Put(std::to_string(i), "v"));
+        ASSERT_LE(storage.Size(), max_size);
+    }
+
+    uint64_t state = 42;
+    std::string last;
+    for (int i = 0; i < 20000; ++i) {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        size_t base = size_t(16) << (i / 2500);
+        last = "Key " + std::to_string((state >> 33) % 1000);
+        ASSERT_TRUE(storage.Put(last, std::string(base + (state >> 40) % base, 'a' + i % 26)));
+        ASSERT_LE(storage.Size(), max_size);
+    }
+
+    std::string res;
+    EXPECT_TRUE(storage.Get(last, res));
+    EXPECT_FALSE(storage.Put("Big", std::string(max_size, 'x')));
+}
+
+// Fills reservation with the given value and commits it
+static bool reserve_commit(Afina::Storage &storage, Afina::Storage::WriteMode mode, const std::string &key,
+                           const std::string &value, uint32_t flags = 0) {
+    std::unique_ptr<Afina::Storage::Reservation> r = storage.Reserve(mode, key, value.size(), flags, 0);
+    if (r == nullptr) {
+        ADD_FAILURE() << "No reservation for " << key;
+        return false;
+    }
+    EXPECT_EQ(value.size(), r->size());
+    std::copy(value.begin(), value.end(), r->data());
+    return r->Commit();
+}
+
+template <typename T> static void reservation_modes() {
+    using Mode = Afina::Storage::WriteMode;
+    T storage(1 << 16);
+
+    std::string res;
+    uint32_t flags = 0;
+    auto reader = [&](Afina::StringView value, uint32_t f) {
+        res = value.str();
+        flags = f;
+    };
+
+    EXPECT_FALSE(reserve_commit(storage, Mode::Set, "Key 1", "Val 1"));
+    EXPECT_FALSE(reserve_commit(storage, Mode::Append, "Key 1", "Val 1"));
+    EXPECT_FALSE(storage.Get("Key 1", res));
+
+    EXPECT_TRUE(reserve_commit(storage, Mode::PutIfAbsent, "Key 1", "Val 1", 3));
+    EXPECT_FALSE(reserve_commit(storage, Mode::PutIfAbsent, "Key 1", "Other"));
+    EXPECT_TRUE(storage.Get(Afina::StringView("Key 1", 5), reader));
+    EXPECT_EQ("Val 1", res);
+    EXPECT_EQ(3, flags);
+
+    EXPECT_TRUE(reserve_commit(storage, Mode::Set, "Key 1", std::string(100, 'x'), 4));
+    EXPECT_TRUE(reserve_commit(storage, Mode::Append, "Key 1", " tail", 5));
+    EXPECT_TRUE(storage.Get(Afina::StringView("Key 1", 5), reader));
+    EXPECT_EQ(std::string(100, 'x') + " tail", res);
+    EXPECT_EQ(4, flags);
+
+    EXPECT_TRUE(reserve_commit(storage, Mode::Put, "Key 2", "Val 2"));
+    EXPECT_TRUE(storage.Get("Key 2", res));
+    EXPECT_EQ("Val 2", res);
+
+    // Value isn't visible until commit and dropped without it
+    {
+        std::unique_ptr<Afina::Storage::Reservation> r =
+            storage.Reserve(Mode::Put, Afina::StringView("Key 3", 5), 5, 0, 0);
+        ASSERT_TRUE(r != nullptr);
+        std::copy_n("Val 3", 5, r->data());
+        EXPECT_FALSE(storage.Get("Key 3", res));
+    }
+    EXPECT_FALSE(storage.Get("Key 3", res));
+
+    EXPECT_TRUE(storage.Reserve(Mode::Put, Afina::StringView("Key 4", 5), 1 << 17, 0, 0) == nullptr);
+}
+
+TEST(StorageTest, ReservationModes) { reservation_modes<SimpleLRU>(); }
+
+TEST(StorageTest, ThreadSafeReservationModes) { reservation_modes<ThreadSafeSimplLRU>(); }
+
+TEST(StorageTest, ShardedReservationModes) { reservation_modes<ShardedLRU>(); }
+
+TEST(StorageTest, ArenaReservationModes) { reservation_modes<ArenaLRU>(); }
+
+TEST(StorageTest, ClockHasNoReservations) {
+    ClockLRU storage(1024);
+    EXPECT_TRUE(storage.Reserve(Afina::Storage::WriteMode::Put, Afina::StringView("Key", 3), 5, 0, 0) == nullptr);
+}
+
+// Random writes of drifting sizes against a model: storage may lose entries to eviction, but never
+// returns a stale or corrupted value and never goes over the budget
+TEST(StorageTest, ArenaRandomChurn) {
+    const size_t max_size = 64 * 1024;
+    ArenaLRU storage(max_size, 64);
+    std::map<std::string, std::string> model;
+
+    uint64_t state = 7;
+    auto next = [&state](uint64_t limit) {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        return (state >> 33) % limit;
+    };
+
+    for (int i = 0; i < 50000; i++) {
+        std::string key = "Key " + std::to_string(next(200));
+        uint64_t op = next(10);
+        if (op < 6) {
+            std::string value(1 + next(2000), char('a' + i % 26));
+            if (op == 0) {
+                value = std::to_string(i) + value;
+            }
+            ASSERT_TRUE(storage.Put(key, value));
+            model[key] = value;
+        } else if (op < 7) {
+            std::string tail(1 + next(100), 't');
+            if (storage.Append(Afina::StringView(key), Afina::StringView(tail))) {
+                ASSERT_TRUE(model.count(key) > 0);
+                model[key] += tail;
+            } else {
+                model.erase(key);
+            }
+        } else if (op < 8) {
+            storage.Delete(key);
+            model.erase(key);
+        } else {
+            std::string res;
+            if (storage.Get(key, res)) {
+                ASSERT_TRUE(model.count(key) > 0) << key;
+                ASSERT_EQ(model[key], res) << key;
+            }
+        }
+        ASSERT_LE(storage.Size(), max_size);
+    }
+
+    for (auto &kv : model) {
+        std::string res;
+        if (storage.Get(kv.first, res)) {
+            EXPECT_EQ(kv.second, res);
+        }
+    }
+}
+
+// Pending reservation is neither evicted nor moved while other writes churn the arena
+TEST(StorageTest, ArenaReservationSurvivesChurn) {
+    ArenaLRU storage(1 << 14);
+    std::string value(3000, 'r');
+    std::unique_ptr<Afina::Storage::Reservation> r =
+        storage.Reserve(Afina::Storage::WriteMode::Put, Afina::StringView("Reserved", 8), value.size(), 0, 0);
+    ASSERT_TRUE(r != nullptr);
+    char *data = r->data();
+    std::copy(value.begin(), value.end(), data);
+
+    for (int i = 0; i < 1000; i++) {
+        storage.Put("Key " + std::to_string(i), std::string(16 + (i * 37) % 500, 'v'));
+    }
+    EXPECT_EQ(data, r->data());
+    EXPECT_TRUE(r->Commit());
+
+    std::string res;
+    EXPECT_TRUE(storage.Get("Reserved", res));
+    EXPECT_EQ(value, res);
+}
+
+TEST(StorageTest, EntryGrowShrink) {
+    EXPECT_EQ(64, sizeof(Entry));
+
+    Entry entry;
+    entry.assign(Afina::StringView("key", 3), Afina::StringView("small", 5));
+    EXPECT_EQ(Afina::StringView("key", 3), entry.key());
+    EXPECT_EQ(Afina::StringView("small", 5), entry.value());
+
+    // Grow out of the inline space and back
+    std::string big(1000, 'x');
+    entry.append_value(big);
+    EXPECT_EQ("small" + big, entry.value().str());
+    entry.assign_value(big);
+    EXPECT_EQ(big, entry.value().str());
+    entry.assign_value(Afina::StringView("tiny", 4));
+    EXPECT_EQ(Afina::StringView("key", 3), entry.key());
+    EXPECT_EQ(Afina::StringView("tiny", 4), entry.value());
+
+    entry.assign_value(big);
+    Entry moved(std::move(entry));
+    EXPECT_EQ(big, moved.value().str());
+    EXPECT_EQ(0, entry.size());
+}
+
+// Pinned buffer is never changed in place and outlives the entry
+TEST(StorageTest, EntryPinIsCopyOnWrite) {
+    Entry entry;
+    entry.assign(Afina::StringView("key", 3), Afina::StringView("small", 5));
+    EXPECT_TRUE(entry.pin() == nullptr);
+
+    std::string big(1000, 'x');
+    entry.assign_value(big);
+    std::shared_ptr<const void> pin = entry.pin();
+    ASSERT_TRUE(pin != nullptr);
+    Afina::StringView pinned = entry.value();
+
+    entry.append_value(Afina::StringView("tail", 4));
+    entry.assign_value(std::string(1000, 'y'));
+    EXPECT_EQ(big, pinned.str());
+    EXPECT_NE(pinned.data(), entry.value().data());
+
+    entry.clear();
+    EXPECT_EQ(big, pinned.str());
+}
+
+template <typename T> static void pin_outlives_entry() {
+    T storage(1 << 16);
+    std::string big(2000, 'b');
+    EXPECT_TRUE(storage.Put("Small", "value"));
+    EXPECT_TRUE(storage.Put("Big", big));
+
+    Afina::StringView view;
+    Afina::Storage::Holder holder;
+    auto reader = [&](Afina::StringView value, uint32_t flags, Afina::Storage::Holder h) {
+        view = value;
+        holder = std::move(h);
+    };
+
+    EXPECT_TRUE(storage.Pin(Afina::StringView("Small", 5), 0, reader));
+    EXPECT_TRUE(holder == nullptr);
+    EXPECT_TRUE(storage.Pin(Afina::StringView("Big", 3), 4096, reader));
+    EXPECT_TRUE(holder == nullptr);
+    EXPECT_FALSE(storage.Pin(Afina::StringView("None", 4), 0, reader));
+
+    EXPECT_TRUE(storage.Pin(Afina::StringView("Big", 3), 1024, reader));
+    ASSERT_TRUE(holder != nullptr);
+    EXPECT_TRUE(storage.Put("Big", std::string(2000, 'n')));
+    EXPECT_TRUE(storage.Delete("Big"));
+    EXPECT_EQ(big, view.str());
+}
+
+TEST(StorageTest, PinOutlivesEntry) { pin_outlives_entry<SimpleLRU>(); }
+
+TEST(StorageTest, ShardedPinOutlivesEntry) { pin_outlives_entry<ShardedLRU>(); }
+
+TEST(StorageTest, ClockPinOutlivesEntry) { pin_outlives_entry<ClockLRU>(); }
+
+template <typename T> static void get_many_in_order() {
+    T storage(1 << 20);
+    std::vector<std::string> names;
+    for (int i = 0; i < 200; i++) {
+        names.push_back("Key " + std::to_string(i));
+        if (i % 3 != 0) {
+            EXPECT_TRUE(storage.Put(Afina::StringView(names.back()), Afina::StringView(names.back()), i, 0));
+        }
+    }
+    EXPECT_TRUE(storage.Put("Big", std::string(3000, 'b')));
+    names.push_back("Big");
+    names.push_back("Key 1");
+
+    std::vector<Afina::StringView> keys(names.begin(), names.end());
+    std::vector<size_t> seen;
+    size_t found = storage.GetMany(keys, 1024, [&](size_t i, Afina::StringView value, uint32_t flags,
+                                                   Afina::Storage::Holder holder) {
+        EXPECT_TRUE(seen.empty() || seen.back() < i);
+        seen.push_back(i);
+        if (names[i] == "Big") {
+            EXPECT_EQ(std::string(3000, 'b'), value.str());
+        } else {
+            EXPECT_EQ(names[i], value.str());
+            EXPECT_TRUE(holder == nullptr);
+            EXPECT_EQ(i < 200 ? i : 1, flags);
+        }
+    });
+
+    EXPECT_EQ(seen.size(), found);
+    EXPECT_EQ(200 - 67 + 2, found);
+    for (size_t i : seen) {
+        EXPECT_TRUE(i >= 200 || i % 3 != 0);
+    }
+    EXPECT_EQ(0, storage.GetMany(std::vector<Afina::StringView>(), 0, nullptr));
+}
+
+TEST(StorageTest, GetManyInOrder) { get_many_in_order<SimpleLRU>(); }
+
+TEST(StorageTest, ThreadSafeGetManyInOrder) { get_many_in_order<ThreadSafeSimplLRU>(); }
+
+TEST(StorageTest, ShardedGetManyInOrder) { get_many_in_order<ShardedLRU>(); }
+
+TEST(StorageTest, ShardedGetManyReleasesLocks) {
+    ShardedLRU storage(1 << 20);
+    std::vector<std::string> names;
+    for (int i = 0; i < 100; i++) {
+        names.push_back("Key " + std::to_string(i));
+        EXPECT_TRUE(storage.Put(names.back(), names.back()));
+    }
+
+    // Shard locks are not held while reader runs, so it could write to any shard, even replace values
+    // being reported
+    std::vector<Afina::StringView> keys(names.begin(), names.end());
+    size_t seen = 0;
+    size_t found = storage.GetMany(keys, 1024, [&](size_t i, Afina::StringView value, uint32_t flags,
+                                                   Afina::Storage::Holder holder) {
+        EXPECT_EQ(seen++, i);
+        EXPECT_EQ(names[i], value.str());
+        EXPECT_TRUE(storage.Set(names[(i + 1) % names.size()], "changed"));
+    });
+    EXPECT_EQ(100, found);
+    EXPECT_EQ(100, seen);
+}
+
+TEST(StorageTest, ClockGetManyInOrder) { get_many_in_order<ClockLRU>(); }
+
+TEST(StorageTest, ArenaGetManyInOrder) { get_many_in_order<ArenaLRU>(); }